@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/handlers/news_json.hpp"
+
+namespace news_aggregator::benchs {
+
+// A listing entry of typical size, with a few characters that need escaping
+inline storage::NewsItem MakeItem(int id) {
+  storage::NewsItem item{};
+  item.id = id;
+  item.title = "Chipmaker \"beats\" estimates as data-centre demand keeps growing, story " + std::to_string(id);
+  item.snippet = std::string(180, 'x') + "\n\tquoted \\ tail";
+  item.source = "TechCrunch";
+  item.category = "technology";
+  item.published_at = "2026-10-18T12:00:00+00:00";
+  item.url = "https://example.com/articles/" + std::to_string(id);
+  item.created_at_us = 1760788800000000 + id;
+  return item;
+}
+
+// Serialized listing entries of `count` items, as NewsFragmentCache holds them
+inline std::vector<std::shared_ptr<const std::string>> MakeFragments(int count) {
+  std::vector<std::shared_ptr<const std::string>> fragments;
+  fragments.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    fragments.push_back(std::make_shared<const std::string>(handlers::SerializeNewsSummary(MakeItem(i))));
+  }
+  return fragments;
+}
+
+}  // namespace news_aggregator::benchs
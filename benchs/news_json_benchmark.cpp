@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/handlers/news_json.hpp"
+#include "news_items.hpp"
+
+namespace {
+
+using namespace news_aggregator;
+
+void NewsSerializeSummary(benchmark::State& state) {
+  const auto item = benchs::MakeItem(1);
+  for ([[maybe_unused]] auto _ : state) {
+    benchmark::DoNotOptimize(handlers::SerializeNewsSummary(item));
+  }
+}
+BENCHMARK(NewsSerializeSummary);
+
+// /news/latest with every entry already in the fragment cache
+void NewsLatestBodyCached(benchmark::State& state) {
+  const auto limit = static_cast<int>(state.range(0));
+  const auto fragments = benchs::MakeFragments(limit);
+  for ([[maybe_unused]] auto _ : state) {
+    benchmark::DoNotOptimize(handlers::BuildNewsLatestBody(fragments, limit, 1760788800000, "1760788800000000_1"));
+  }
+  state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(NewsLatestBodyCached)->Arg(10)->Arg(50)->Arg(100);
+
+// /news/latest with every entry serialized for the request
+void NewsLatestBodyUncached(benchmark::State& state) {
+  const auto limit = static_cast<int>(state.range(0));
+  std::vector<storage::NewsItem> items;
+  for (int i = 0; i < limit; ++i) {
+    items.push_back(benchs::MakeItem(i));
+  }
+  for ([[maybe_unused]] auto _ : state) {
+    std::vector<std::shared_ptr<const std::string>> fragments;
+    fragments.reserve(items.size());
+    for (const auto& item : items) {
+      fragments.push_back(std::make_shared<const std::string>(handlers::SerializeNewsSummary(item)));
+    }
+    benchmark::DoNotOptimize(handlers::BuildNewsLatestBody(fragments, limit, 1760788800000, "1760788800000000_1"));
+  }
+  state.SetItemsProcessed(state.iterations() * limit);
+}
+BENCHMARK(NewsLatestBodyUncached)->Arg(10)->Arg(50)->Arg(100);
+
+}  // namespace
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/common/news_snapshot.hpp"
+#include "../src/gateway/news_snapshot.hpp"
+#include "../src/handlers/news_json.hpp"
+#include "news_items.hpp"
+
+namespace {
+
+using namespace news_aggregator;
+
+std::vector<std::string_view> MakeViews(const std::vector<std::shared_ptr<const std::string>>& fragments) {
+  std::vector<std::string_view> items;
+  items.reserve(fragments.size());
+  for (const auto& fragment : fragments) {
+    items.push_back(*fragment);
+  }
+  return items;
+}
+
+// StorageService side of /internal/news/latest: version from the ids, then the layout
+void NewsSnapshotEncode(benchmark::State& state) {
+  const auto count = static_cast<int>(state.range(0));
+  const auto fragments = benchs::MakeFragments(count);
+  const auto items = MakeViews(fragments);
+  for ([[maybe_unused]] auto _ : state) {
+    std::vector<int64_t> ids;
+    ids.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      ids.push_back(i);
+    }
+    benchmark::DoNotOptimize(common::EncodeNewsSnapshot(common::FoldSnapshotVersion(ids), 1760788800000, items));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(NewsSnapshotEncode)->Arg(10)->Arg(100);
+
+// Gateway side of every /news request: check the cached snapshot and cut a page
+void NewsSnapshotParse(benchmark::State& state) {
+  const auto fragments = benchs::MakeFragments(static_cast<int>(common::kSnapshotItems));
+  const auto items = MakeViews(fragments);
+  const auto snapshot = common::EncodeNewsSnapshot(1, 1760788800000, items);
+  const auto limit = static_cast<size_t>(state.range(0));
+  for ([[maybe_unused]] auto _ : state) {
+    const auto view = common::NewsSnapshotView::Parse(snapshot);
+    benchmark::DoNotOptimize(view->GetItems(limit));
+  }
+}
+BENCHMARK(NewsSnapshotParse)->Arg(10)->Arg(100);
+
+// Gateway JSON fallback: scan a /news/latest response into a snapshot
+void NewsSnapshotFromJson(benchmark::State& state) {
+  const auto count = static_cast<int>(state.range(0));
+  const auto body = handlers::BuildNewsLatestBody(benchs::MakeFragments(count), count, 1760788800000, "1760788800000000_1");
+  for ([[maybe_unused]] auto _ : state) {
+    benchmark::DoNotOptimize(gateway::BuildNewsSnapshot(body));
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+BENCHMARK(NewsSnapshotFromJson)->Arg(10)->Arg(100);
+
+}  // namespace
@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# News Aggregator - gateway <-> storage protocol benchmark
+# Compares the public JSON listing (/news/latest) with the binary snapshot the
+# gateway fetches (/internal/news/latest): payload size, latency and, when the
+# StorageService PID is known, its CPU time per request.
+# Usage: ./scripts/bench-internal-protocol.sh [requests] [base url] [storage pid]
+
+set -e
+
+REQUESTS="${1:-500}"
+API_BASE="${2:-http://localhost:8080}"
+STORAGE_PID="${3:-$(cat logs/storage.pid 2>/dev/null || true)}"
+CLK_TCK=$(getconf CLK_TCK)
+
+# utime + stime of the StorageService process, in clock ticks
+cpu_ticks() {
+    if [ -n "${STORAGE_PID}" ] && [ -r "/proc/${STORAGE_PID}/stat" ]; then
+        awk '{ print $14 + $15 }' "/proc/${STORAGE_PID}/stat"
+    else
+        echo 0
+    fi
+}
+
+echo "StorageService protocol benchmark (${REQUESTS} requests, limit=100, ${API_BASE})"
+echo "======================================================================"
+printf "%-24s %10s %10s %10s %10s %12s\n" "endpoint" "avg ms" "p50 ms" "p99 ms" "bytes" "cpu us/req"
+
+for endpoint in /news/latest /internal/news/latest; do
+    url="${API_BASE}${endpoint}?limit=100"
+
+    # Warm up the fragment caches so both paths serialize from the same state
+    for i in $(seq 1 20); do
+        curl -s -o /dev/null "${url}"
+    done
+
+    samples=$(mktemp)
+    cpu_before=$(cpu_ticks)
+    for i in $(seq 1 "${REQUESTS}"); do
+        curl -s -o /dev/null -w "%{time_total} %{size_download}\n" "${url}" >> "${samples}"
+    done
+    cpu_after=$(cpu_ticks)
+
+    sort -n "${samples}" | awk -v endpoint="${endpoint}" -v ticks="$((cpu_after - cpu_before))" \
+                               -v hz="${CLK_TCK}" -v has_pid="${STORAGE_PID:+1}" '
+        { t[NR] = $1 * 1000; sum += $1 * 1000; bytes = $2 }
+        END {
+            p50 = t[int(NR * 0.50) > 0 ? int(NR * 0.50) : 1]
+            p99 = t[int(NR * 0.99) > 0 ? int(NR * 0.99) : 1]
+            cpu = has_pid ? sprintf("%.1f", ticks * 1000000 / hz / NR) : "n/a"
+            printf "%-24s %10.3f %10.3f %10.3f %10d %12s\n", endpoint, sum / NR, p50, p99, bytes, cpu
+        }'
+    rm -f "${samples}"
+done
+
+if [ -z "${STORAGE_PID}" ]; then
+    echo
+    echo "StorageService PID unknown (no logs/storage.pid); pass it as the third argument for CPU numbers"
+fi
@@ -0,0 +1,305 @@
+#include "copy_encoder.hpp"
+#include <array>
+#include <cctype>
+#include <cstring>
+
+namespace news_aggregator::bulk_import {
+
+namespace {
+
+// PostgreSQL timestamps count from 2000-01-01 00:00:00 UTC
+constexpr int64_t kPostgresEpochUnixUs = 946684800LL * 1000000LL;
+
+constexpr std::string_view kReplacementCharacter = "\xEF\xBF\xBD";
+
+int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+class Scanner {
+public:
+    explicit Scanner(std::string_view text) : text_(text) {}
+
+    bool AtEnd() const { return pos_ >= text_.size(); }
+    char Peek() const { return AtEnd() ? '\0' : text_[pos_]; }
+    void Skip() { ++pos_; }
+    void SkipSpaces() {
+        while (!AtEnd() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+    bool Consume(char c) {
+        if (Peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+    // Reads exactly `digits` digits, or between 1 and `digits` when `exact` is false
+    bool ReadNumber(size_t digits, int& value, bool exact = true) {
+        size_t read = 0;
+        value = 0;
+        while (read < digits && std::isdigit(static_cast<unsigned char>(Peek()))) {
+            value = value * 10 + (Peek() - '0');
+            ++pos_;
+            ++read;
+        }
+        return exact ? read == digits : read > 0;
+    }
+    std::string_view ReadWord() {
+        const size_t start = pos_;
+        while (!AtEnd() && std::isalpha(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        return text_.substr(start, pos_ - start);
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads "Z", "+HH:MM", "+HHMM", "+HH" or a named RFC 822 zone; absent zone means UTC
+bool ReadZoneOffset(Scanner& scanner, int64_t& offset_seconds) {
+    offset_seconds = 0;
+    scanner.SkipSpaces();
+    if (scanner.AtEnd() || scanner.Consume('Z') || scanner.Consume('z')) {
+        return scanner.AtEnd();
+    }
+
+    if (scanner.Peek() == '+' || scanner.Peek() == '-') {
+        const int sign = scanner.Peek() == '-' ? -1 : 1;
+        scanner.Skip();
+        int hours = 0;
+        int minutes = 0;
+        if (!scanner.ReadNumber(2, hours)) return false;
+        scanner.Consume(':');
+        if (!scanner.AtEnd() && !scanner.ReadNumber(2, minutes)) return false;
+        offset_seconds = sign * (hours * 3600 + minutes * 60);
+        return scanner.AtEnd();
+    }
+
+    static constexpr std::array<std::pair<std::string_view, int>, 11> kZones = {{
+        {"GMT", 0}, {"UT", 0}, {"UTC", 0},
+        {"EST", -5}, {"EDT", -4}, {"CST", -6}, {"CDT", -5},
+        {"MST", -7}, {"MDT", -6}, {"PST", -8}, {"PDT", -7},
+    }};
+    const auto word = scanner.ReadWord();
+    for (const auto& [name, hours] : kZones) {
+        if (EqualsIgnoreCase(word, name)) {
+            offset_seconds = hours * 3600;
+            scanner.SkipSpaces();
+            return scanner.AtEnd();
+        }
+    }
+    return false;
+}
+
+bool ReadTimeOfDay(Scanner& scanner, int64_t& seconds, int64_t& fraction_us) {
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    fraction_us = 0;
+    if (!scanner.ReadNumber(2, hour) || !scanner.Consume(':') || !scanner.ReadNumber(2, minute)) {
+        return false;
+    }
+    if (scanner.Consume(':')) {
+        if (!scanner.ReadNumber(2, second)) return false;
+        if (scanner.Consume('.') || scanner.Consume(',')) {
+            int64_t scale = 100000;
+            while (std::isdigit(static_cast<unsigned char>(scanner.Peek()))) {
+                fraction_us += (scanner.Peek() - '0') * scale;
+                scale /= 10;
+                scanner.Skip();
+            }
+        }
+    }
+    if (hour > 23 || minute > 59 || second > 60) return false;
+    seconds = hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+std::optional<int64_t> ParseIso8601(std::string_view text) {
+    Scanner scanner(text);
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!scanner.ReadNumber(4, year) || !scanner.Consume('-') || !scanner.ReadNumber(2, month) ||
+        !scanner.Consume('-') || !scanner.ReadNumber(2, day)) {
+        return std::nullopt;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) return std::nullopt;
+
+    int64_t seconds = 0;
+    int64_t fraction_us = 0;
+    if (scanner.Consume('T') || scanner.Consume('t') || scanner.Consume(' ')) {
+        if (!ReadTimeOfDay(scanner, seconds, fraction_us)) return std::nullopt;
+    }
+
+    int64_t offset_seconds = 0;
+    if (!ReadZoneOffset(scanner, offset_seconds)) return std::nullopt;
+
+    const int64_t unix_seconds = DaysFromCivil(year, month, day) * 86400 + seconds - offset_seconds;
+    return unix_seconds * 1000000 + fraction_us;
+}
+
+std::optional<int64_t> ParseRfc822(std::string_view text) {
+    static constexpr std::array<std::string_view, 12> kMonths = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    Scanner scanner(text);
+    scanner.SkipSpaces();
+    if (std::isalpha(static_cast<unsigned char>(scanner.Peek()))) {
+        scanner.ReadWord();  // day of week
+        if (!scanner.Consume(',')) return std::nullopt;
+        scanner.SkipSpaces();
+    }
+
+    int day = 0;
+    int year = 0;
+    if (!scanner.ReadNumber(2, day, false)) return std::nullopt;
+    scanner.SkipSpaces();
+    const auto month_name = scanner.ReadWord();
+    unsigned month = 0;
+    for (size_t i = 0; i < kMonths.size(); ++i) {
+        if (EqualsIgnoreCase(month_name, kMonths[i])) month = static_cast<unsigned>(i + 1);
+    }
+    scanner.SkipSpaces();
+    if (month == 0 || !scanner.ReadNumber(4, year)) return std::nullopt;
+    scanner.SkipSpaces();
+
+    int64_t seconds = 0;
+    int64_t fraction_us = 0;
+    if (!ReadTimeOfDay(scanner, seconds, fraction_us)) return std::nullopt;
+
+    int64_t offset_seconds = 0;
+    if (!ReadZoneOffset(scanner, offset_seconds)) return std::nullopt;
+
+    const int64_t unix_seconds = DaysFromCivil(year, month, day) * 86400 + seconds - offset_seconds;
+    return unix_seconds * 1000000 + fraction_us;
+}
+
+// Length of the valid UTF-8 sequence at the start of `text`, or 0
+size_t ValidUtf8SequenceLength(std::string_view text) {
+    const auto byte = [&text](size_t i) { return static_cast<unsigned char>(text[i]); };
+    const auto is_continuation = [&](size_t i) { return i < text.size() && (byte(i) & 0xC0) == 0x80; };
+
+    const unsigned char lead = byte(0);
+    if (lead < 0x80) return 1;
+    if (lead >= 0xC2 && lead <= 0xDF) return is_continuation(1) ? 2 : 0;
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        if (!is_continuation(1) || !is_continuation(2)) return 0;
+        if (lead == 0xE0 && byte(1) < 0xA0) return 0;  // overlong
+        if (lead == 0xED && byte(1) >= 0xA0) return 0;  // UTF-16 surrogates
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        if (!is_continuation(1) || !is_continuation(2) || !is_continuation(3)) return 0;
+        if (lead == 0xF0 && byte(1) < 0x90) return 0;  // overlong
+        if (lead == 0xF4 && byte(1) >= 0x90) return 0;  // above U+10FFFF
+        return 4;
+    }
+    return 0;
+}
+
+}  // namespace
+
+std::string CopyEncoder::Header() {
+    std::string header("PGCOPY\n\377\r\n\0", 11);
+    header.append(8, '\0');  // flags and header extension length
+    return header;
+}
+
+std::string CopyEncoder::Trailer() {
+    return std::string("\xFF\xFF", 2);
+}
+
+void CopyEncoder::BeginRow(int16_t field_count) {
+    PutInt16(field_count);
+}
+
+void CopyEncoder::AddText(std::string_view value) {
+    const size_t length_pos = buffer_.size();
+    PutInt32(0);
+
+    const size_t start = buffer_.size();
+    while (!value.empty()) {
+        const size_t length = ValidUtf8SequenceLength(value);
+        if (length == 0) {
+            buffer_.append(kReplacementCharacter);
+            value.remove_prefix(1);
+        } else {
+            if (length > 1 || value.front() != '\0') {
+                buffer_.append(value.data(), length);
+            }
+            value.remove_prefix(length);
+        }
+    }
+
+    const auto length = static_cast<uint32_t>(buffer_.size() - start);
+    const unsigned char bytes[4] = {
+        static_cast<unsigned char>(length >> 24), static_cast<unsigned char>(length >> 16),
+        static_cast<unsigned char>(length >> 8), static_cast<unsigned char>(length)};
+    std::memcpy(buffer_.data() + length_pos, bytes, sizeof(bytes));
+}
+
+void CopyEncoder::AddBigint(int64_t value) {
+    PutInt32(8);
+    PutInt64(value);
+}
+
+void CopyEncoder::AddTimestamp(std::optional<int64_t> unix_us) {
+    if (!unix_us) {
+        AddNull();
+        return;
+    }
+    PutInt32(8);
+    PutInt64(*unix_us - kPostgresEpochUnixUs);
+}
+
+void CopyEncoder::AddNull() {
+    PutInt32(-1);
+}
+
+void CopyEncoder::PutInt16(int16_t value) {
+    const auto bits = static_cast<uint16_t>(value);
+    buffer_.push_back(static_cast<char>(bits >> 8));
+    buffer_.push_back(static_cast<char>(bits));
+}
+
+void CopyEncoder::PutInt32(int32_t value) {
+    const auto bits = static_cast<uint32_t>(value);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buffer_.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+void CopyEncoder::PutInt64(int64_t value) {
+    const auto bits = static_cast<uint64_t>(value);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        buffer_.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+std::optional<int64_t> ParseTimestamp(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    if (auto iso = ParseIso8601(text)) {
+        return iso;
+    }
+    return ParseRfc822(text);
+}
+
+}  // namespace news_aggregator::bulk_import
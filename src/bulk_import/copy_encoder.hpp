@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace news_aggregator::bulk_import {
+
+// Encoder for PostgreSQL's binary COPY format:
+// https://www.postgresql.org/docs/current/sql-copy.html#id-1.9.3.55.9.4
+class CopyEncoder {
+public:
+    // Signature, flags and header extension; sent once per COPY
+    static std::string Header();
+    // File trailer (a field count of -1); sent once per COPY
+    static std::string Trailer();
+
+    explicit CopyEncoder(std::string& buffer) : buffer_(buffer) {}
+
+    void BeginRow(int16_t field_count);
+    // Text is sanitized to valid UTF-8 without NUL bytes, as the server requires
+    void AddText(std::string_view value);
+    void AddBigint(int64_t value);
+    // Microseconds since the Unix epoch; std::nullopt writes NULL
+    void AddTimestamp(std::optional<int64_t> unix_us);
+    void AddNull();
+
+private:
+    void PutInt16(int16_t value);
+    void PutInt32(int32_t value);
+    void PutInt64(int64_t value);
+
+    std::string& buffer_;
+};
+
+// Parses ISO 8601 ("2025-10-23T14:18:47.123Z", "2025-10-23 14:18:47+03:00")
+// and RFC 822 ("Thu, 23 Oct 2025 14:18:47 GMT") timestamps into microseconds
+// since the Unix epoch
+std::optional<int64_t> ParseTimestamp(std::string_view text);
+
+}  // namespace news_aggregator::bulk_import
@@ -0,0 +1,434 @@
+// news_bulk_import: backfills archived news into the news table.
+//
+// Reader thread -> raw record batches -> N parser/encoder threads ->
+// binary COPY chunks -> main thread streams them with PQputCopyData into a
+// temporary staging table, which is merged into `news` every --merge-rows rows
+// using the same content-key deduplication as online ingest.
+
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../storage/content_key.hpp"
+#include "../storage/postgres_client.hpp"
+#include "../storage/snippet.hpp"
+#include "copy_encoder.hpp"
+#include "record_reader.hpp"
+
+namespace {
+
+using namespace news_aggregator;
+using namespace news_aggregator::bulk_import;
+
+constexpr int16_t kStagingColumns = 9;
+
+constexpr std::string_view kCreateStaging =
+    "CREATE TEMP TABLE news_import ("
+    "title TEXT, content TEXT, source TEXT, category TEXT, url TEXT, "
+    "content_key BIGINT, snippet TEXT, published_at TIMESTAMPTZ, created_at TIMESTAMPTZ)";
+
+constexpr std::string_view kCopyStaging = "COPY news_import FROM STDIN (FORMAT binary)";
+
+// Makes sure the partitions covering the staged rows exist before they are
+// merged; {unit} is replaced with --partition-unit
+constexpr std::string_view kEnsureStagingPartitions =
+    "SELECT news_ensure_partition(period, '{unit}') FROM generate_series("
+    "date_trunc('{unit}', (SELECT MIN(COALESCE(created_at, published_at, CURRENT_TIMESTAMP)) FROM news_import), 'UTC'), "
+    "(SELECT MAX(COALESCE(created_at, published_at, CURRENT_TIMESTAMP)) FROM news_import), "
+    "INTERVAL '1 {unit}') AS period";
+
+// Duplicates inside the staging batch are collapsed by DISTINCT ON, duplicates
+// of stored stories by claiming the key in news_keys first
+constexpr std::string_view kMergeStaging =
+    "WITH staged AS ("
+    "SELECT DISTINCT ON (content_key) title, content, source, category, url, content_key, snippet, "
+    "COALESCE(published_at, created_at, CURRENT_TIMESTAMP) AS published_at, "
+    "COALESCE(created_at, published_at, CURRENT_TIMESTAMP) AS created_at "
+    "FROM news_import ORDER BY content_key), "
+    "claimed AS ("
+    "INSERT INTO news_keys (content_key, news_id, created_at) "
+    "SELECT content_key, nextval('news_id_seq'), created_at FROM staged "
+    "ON CONFLICT (content_key) DO NOTHING "
+    "RETURNING content_key, news_id) "
+    "INSERT INTO news (id, title, content, source, category, url, content_key, snippet, published_at, created_at, "
+    "text_normalized) "
+    "SELECT claimed.news_id, title, content, source, category, url, content_key, snippet, published_at, created_at, "
+    "TRUE "
+    "FROM claimed JOIN staged USING (content_key)";
+
+struct Options {
+    std::string dsn = "host=localhost port=5432 dbname=news_db user=news_user password=news_password";
+    std::vector<std::string> files;
+    std::optional<InputFormat> format;
+    RecordDefaults defaults;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t records_per_task = 2048;
+    size_t merge_rows = 500000;
+    std::string partition_unit = "week";
+};
+
+template <typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity) : capacity_(capacity) {}
+
+    // false once the queue is closed, the value is then dropped
+    bool Push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        queue_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // std::nullopt once the queue is closed and drained
+    std::optional<T> Pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return std::nullopt;
+        }
+        T value = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    // Closes the queue and drops everything still queued
+    void Cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        queue_.clear();
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> queue_;
+    bool closed_ = false;
+};
+
+struct RawBatch {
+    InputFormat format;
+    const std::vector<std::string>* csv_header;  // owned by the reader, outlives the batch
+    std::vector<std::string> records;
+};
+
+struct EncodedChunk {
+    std::string data;
+    size_t rows = 0;
+    size_t rejected = 0;
+};
+
+void PrintUsage() {
+    std::cerr << "Usage: news_bulk_import [options] FILE...\n"
+                 "  FILE                  .ndjson/.jsonl/.csv input, optionally .gz; '-' for stdin\n"
+                 "  --dsn DSN             libpq connection string\n"
+                 "  --format ndjson|csv   input format (default: from file extension)\n"
+                 "  --source NAME         source for records without one\n"
+                 "  --category NAME       category for records without one (default: general)\n"
+                 "  --threads N           parser/encoder threads (default: CPU count)\n"
+                 "  --merge-rows N        rows staged per merge transaction (default: 500000)\n"
+                 "  --partition-unit U    day|week|month partitions created for backfilled ranges,\n"
+                 "                        should match storage-service partitioning (default: week)\n";
+}
+
+std::optional<Options> ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::optional<std::string> {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return std::nullopt;
+            }
+            return std::string(argv[++i]);
+        };
+
+        if (arg == "--help" || arg == "-h") {
+            return std::nullopt;
+        } else if (arg == "--dsn") {
+            auto v = value();
+            if (!v) return std::nullopt;
+            options.dsn = *v;
+        } else if (arg == "--format") {
+            auto v = value();
+            if (!v || (*v != "ndjson" && *v != "csv")) return std::nullopt;
+            options.format = *v == "csv" ? InputFormat::kCsv : InputFormat::kNdjson;
+        } else if (arg == "--source") {
+            auto v = value();
+            if (!v) return std::nullopt;
+            options.defaults.source = *v;
+        } else if (arg == "--category") {
+            auto v = value();
+            if (!v) return std::nullopt;
+            options.defaults.category = *v;
+        } else if (arg == "--threads") {
+            auto v = value();
+            if (!v) return std::nullopt;
+            options.threads = std::max<size_t>(1, std::strtoul(v->c_str(), nullptr, 10));
+        } else if (arg == "--merge-rows") {
+            auto v = value();
+            if (!v) return std::nullopt;
+            options.merge_rows = std::max<size_t>(1, std::strtoul(v->c_str(), nullptr, 10));
+        } else if (arg == "--partition-unit") {
+            auto v = value();
+            if (!v || (*v != "day" && *v != "week" && *v != "month")) return std::nullopt;
+            options.partition_unit = *v;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg != "-") {
+            std::cerr << "Unknown option " << arg << "\n";
+            return std::nullopt;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+
+    if (options.files.empty()) {
+        std::cerr << "No input files\n";
+        return std::nullopt;
+    }
+    return options;
+}
+
+EncodedChunk Encode(const RawBatch& batch, const RecordDefaults& defaults) {
+    EncodedChunk chunk;
+    chunk.data.reserve(batch.records.size() * 512);
+    CopyEncoder encoder(chunk.data);
+    std::string error;
+
+    for (const auto& raw : batch.records) {
+        auto record = batch.format == InputFormat::kCsv
+                          ? ParseCsvRecord(raw, *batch.csv_header, defaults, error)
+                          : ParseNdjsonRecord(raw, defaults, error);
+        if (!record) {
+            ++chunk.rejected;
+            continue;
+        }
+
+        const auto& item = record->item;
+        encoder.BeginRow(kStagingColumns);
+        encoder.AddText(item.title);
+        encoder.AddText(item.content);
+        encoder.AddText(item.source);
+        encoder.AddText(item.category);
+        encoder.AddText(item.url);
+        encoder.AddBigint(storage::ComputeContentKey(item));
+        encoder.AddText(storage::MakeSnippet(item.content));
+        encoder.AddTimestamp(record->published_at_us);
+        encoder.AddTimestamp(record->created_at_us);
+        ++chunk.rows;
+    }
+    return chunk;
+}
+
+class Importer {
+public:
+    Importer(storage::PostgresClient& client, const std::string& partition_unit)
+        : client_(client), ensure_partitions_sql_(std::string(kEnsureStagingPartitions)) {
+        for (auto pos = ensure_partitions_sql_.find("{unit}"); pos != std::string::npos;
+             pos = ensure_partitions_sql_.find("{unit}", pos)) {
+            ensure_partitions_sql_.replace(pos, 6, partition_unit);
+        }
+    }
+
+    bool Start() {
+        return client_.Execute(std::string(kCreateStaging)) && BeginCopy();
+    }
+
+    bool Write(const EncodedChunk& chunk, size_t merge_rows) {
+        if (chunk.rows == 0) {
+            return true;
+        }
+        if (!client_.PutCopyData(chunk.data)) {
+            return false;
+        }
+        staged_ += chunk.rows;
+        if (staged_ >= merge_rows) {
+            return Merge() && BeginCopy();
+        }
+        return true;
+    }
+
+    bool Finish() {
+        return Merge();
+    }
+
+    size_t Inserted() const { return inserted_; }
+    size_t Merged() const { return merged_; }
+
+private:
+    bool BeginCopy() {
+        if (!client_.BeginCopy(std::string(kCopyStaging))) {
+            return false;
+        }
+        return client_.PutCopyData(CopyEncoder::Header());
+    }
+
+    bool Merge() {
+        if (!client_.PutCopyData(CopyEncoder::Trailer()) || !client_.EndCopy()) {
+            return false;
+        }
+        if (staged_ != 0 && !client_.Execute(ensure_partitions_sql_)) {
+            return false;
+        }
+        const auto inserted = client_.ExecuteAffected(std::string(kMergeStaging));
+        if (!inserted || !client_.Execute("TRUNCATE news_import")) {
+            return false;
+        }
+        inserted_ += static_cast<size_t>(*inserted);
+        merged_ += staged_;
+        staged_ = 0;
+        return true;
+    }
+
+    storage::PostgresClient& client_;
+    std::string ensure_partitions_sql_;
+    size_t staged_ = 0;
+    size_t merged_ = 0;
+    size_t inserted_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 2;
+    }
+
+    storage::PostgresClient client(options->dsn);
+    if (!client.Connect()) {
+        std::cerr << "Failed to connect to PostgreSQL\n";
+        return 1;
+    }
+
+    Importer importer(client, options->partition_unit);
+    if (!importer.Start()) {
+        std::cerr << "Failed to prepare the staging table\n";
+        return 1;
+    }
+
+    BlockingQueue<RawBatch> raw_queue(options->threads * 4);
+    BlockingQueue<EncodedChunk> encoded_queue(options->threads * 4);
+    std::atomic<bool> input_failed{false};
+
+    // Outlive the worker threads: batches point at the CSV header of their reader
+    std::vector<std::unique_ptr<RecordReader>> readers;
+    std::thread reader([&]() {
+        for (const auto& path : options->files) {
+            const auto format = options->format ? options->format : DetectFormat(path);
+            if (!format) {
+                std::cerr << "Cannot tell the format of " << path << ", use --format\n";
+                input_failed = true;
+                continue;
+            }
+
+            readers.push_back(std::make_unique<RecordReader>(path, *format));
+            auto& file_reader = *readers.back();
+            if (!file_reader.IsOpen()) {
+                std::cerr << "Failed to open " << path << "\n";
+                input_failed = true;
+                continue;
+            }
+
+            bool more = true;
+            while (more) {
+                RawBatch batch{*format, &file_reader.GetCsvHeader(), {}};
+                batch.records.reserve(options->records_per_task);
+                more = file_reader.ReadBatch(batch.records, options->records_per_task);
+                if (!batch.records.empty() && !raw_queue.Push(std::move(batch))) {
+                    return;  // the import was aborted
+                }
+            }
+        }
+        raw_queue.Close();
+    });
+
+    std::atomic<size_t> active_workers{options->threads};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < options->threads; ++i) {
+        workers.emplace_back([&]() {
+            while (auto batch = raw_queue.Pop()) {
+                if (!encoded_queue.Push(Encode(*batch, options->defaults))) {
+                    break;  // the import was aborted
+                }
+            }
+            if (--active_workers == 0) {
+                encoded_queue.Close();
+            }
+        });
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    auto last_report = started;
+    size_t rows = 0;
+    size_t rejected = 0;
+    bool write_failed = false;
+
+    while (auto chunk = encoded_queue.Pop()) {
+        if (!importer.Write(*chunk, options->merge_rows)) {
+            std::cerr << "Writing to PostgreSQL failed, aborting import\n";
+            write_failed = true;
+            // Stop reading and encoding the rest of the input
+            raw_queue.Cancel();
+            encoded_queue.Cancel();
+            break;
+        }
+        rows += chunk->rows;
+        rejected += chunk->rejected;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(5)) {
+            const double seconds = std::chrono::duration<double>(now - started).count();
+            std::cerr << "Streamed " << rows << " rows (" << static_cast<size_t>(rows / seconds)
+                      << " rows/s), " << importer.Inserted() << " inserted so far, "
+                      << rejected << " rejected\n";
+            last_report = now;
+        }
+    }
+
+    reader.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (write_failed || !importer.Finish()) {
+        std::cerr << "Import failed after " << importer.Merged() << " merged rows\n";
+        return 1;
+    }
+
+    const double seconds = std::max(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(), 1e-3);
+    std::cerr << "Imported " << rows << " rows in " << seconds << "s ("
+              << static_cast<size_t>(rows / seconds) << " rows/s): "
+              << importer.Inserted() << " inserted, " << rows - importer.Inserted() << " duplicates, "
+              << rejected << " rejected\n";
+    return input_failed ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+#include "record_reader.hpp"
+#include <userver/formats/json/serialize.hpp>
+#include <userver/formats/json/value.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+#include "../storage/text_normalizer.hpp"
+#include "copy_encoder.hpp"
+
+namespace news_aggregator::bulk_import {
+
+namespace {
+
+constexpr size_t kReadChunkSize = 1 << 20;
+
+bool EndsWith(std::string_view text, std::string_view suffix) {
+    return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+}
+
+std::string_view TrimLineEnd(std::string_view record) {
+    while (!record.empty() && (record.back() == '\r' || record.back() == '\n')) {
+        record.remove_suffix(1);
+    }
+    return record;
+}
+
+bool IsBlank(std::string_view record) {
+    return std::all_of(record.begin(), record.end(),
+                       [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; });
+}
+
+bool Finalize(ImportRecord& record, const RecordDefaults& defaults, std::string& error) {
+    auto& item = record.item;
+    storage::NormalizeNewsItem(item);
+    if (item.title.empty()) {
+        error = "missing title";
+        return false;
+    }
+    if (item.source.empty()) item.source = defaults.source;
+    if (item.category.empty()) item.category = defaults.category;
+    if (item.source.empty()) {
+        error = "missing source";
+        return false;
+    }
+    record.published_at_us = ParseTimestamp(item.published_at);
+    return true;
+}
+
+}  // namespace
+
+std::optional<InputFormat> DetectFormat(std::string_view path) {
+    if (EndsWith(path, ".gz")) {
+        path.remove_suffix(3);
+    }
+    if (EndsWith(path, ".ndjson") || EndsWith(path, ".jsonl") || EndsWith(path, ".json")) {
+        return InputFormat::kNdjson;
+    }
+    if (EndsWith(path, ".csv")) {
+        return InputFormat::kCsv;
+    }
+    return std::nullopt;
+}
+
+RecordReader::RecordReader(const std::string& path, InputFormat format) : format_(format) {
+    // gzread passes uncompressed input through unchanged
+    file_ = path == "-" ? gzdopen(dup(STDIN_FILENO), "rb") : gzopen(path.c_str(), "rb");
+    if (file_) {
+        gzbuffer(file_, kReadChunkSize);
+    }
+    if (file_ && format_ == InputFormat::kCsv) {
+        std::string header;
+        if (NextRecord(header)) {
+            csv_header_ = SplitCsvFields(TrimLineEnd(header));
+        }
+    }
+}
+
+RecordReader::~RecordReader() {
+    if (file_) {
+        gzclose(file_);
+    }
+}
+
+bool RecordReader::FillBuffer() {
+    if (eof_) {
+        return false;
+    }
+    buffer_.erase(0, pos_);
+    pos_ = 0;
+
+    const size_t old_size = buffer_.size();
+    buffer_.resize(old_size + kReadChunkSize);
+    const int read = gzread(file_, buffer_.data() + old_size, kReadChunkSize);
+    if (read <= 0) {
+        buffer_.resize(old_size);
+        eof_ = true;
+        return false;
+    }
+    buffer_.resize(old_size + static_cast<size_t>(read));
+    return true;
+}
+
+bool RecordReader::NextRecord(std::string& record) {
+    size_t scan = pos_;
+    bool in_quotes = false;
+    while (true) {
+        for (; scan < buffer_.size(); ++scan) {
+            const char c = buffer_[scan];
+            if (format_ == InputFormat::kCsv && c == '"') {
+                in_quotes = !in_quotes;  // "" inside quotes toggles twice
+            } else if (c == '\n' && !in_quotes) {
+                record.assign(buffer_, pos_, scan - pos_);
+                pos_ = scan + 1;
+                return true;
+            }
+        }
+
+        const size_t scanned = scan - pos_;
+        if (!FillBuffer()) {
+            if (pos_ < buffer_.size()) {
+                record.assign(buffer_, pos_, std::string::npos);
+                pos_ = buffer_.size();
+                return true;
+            }
+            return false;
+        }
+        scan = pos_ + scanned;  // FillBuffer moved the unread tail to the front
+    }
+}
+
+bool RecordReader::ReadBatch(std::vector<std::string>& records, size_t max_records) {
+    std::string record;
+    while (records.size() < max_records) {
+        if (!NextRecord(record)) {
+            return false;
+        }
+        if (!IsBlank(record)) {
+            records.push_back(std::move(record));
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> SplitCsvFields(std::string_view record) {
+    std::vector<std::string> fields(1);
+    bool in_quotes = false;
+    for (size_t i = 0; i < record.size(); ++i) {
+        const char c = record[i];
+        if (in_quotes) {
+            if (c == '"' && i + 1 < record.size() && record[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else if (c == '"') {
+                in_quotes = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            in_quotes = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::optional<ImportRecord> ParseNdjsonRecord(std::string_view line, const RecordDefaults& defaults,
+                                              std::string& error) {
+    ImportRecord record;
+    try {
+        const auto json = formats::json::FromString(TrimLineEnd(line));
+        auto& item = record.item;
+        item.id = 0;
+        item.title = json["title"].As<std::string>("");
+        item.content = json["content"].As<std::string>("");
+        item.source = json["source"].As<std::string>("");
+        item.category = json["category"].As<std::string>("");
+        item.url = json["url"].As<std::string>("");
+        item.guid = json["guid"].As<std::string>("");
+        item.published_at = json["published_at"].As<std::string>("");
+        record.created_at_us = ParseTimestamp(json["created_at"].As<std::string>(""));
+    } catch (const std::exception& ex) {
+        error = ex.what();
+        return std::nullopt;
+    }
+
+    if (!Finalize(record, defaults, error)) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+std::optional<ImportRecord> ParseCsvRecord(std::string_view record_text, const std::vector<std::string>& header,
+                                           const RecordDefaults& defaults, std::string& error) {
+    const auto fields = SplitCsvFields(TrimLineEnd(record_text));
+    if (fields.size() != header.size()) {
+        error = "expected " + std::to_string(header.size()) + " fields, got " + std::to_string(fields.size());
+        return std::nullopt;
+    }
+
+    ImportRecord record;
+    auto& item = record.item;
+    item.id = 0;
+    for (size_t i = 0; i < header.size(); ++i) {
+        const auto& column = header[i];
+        if (column == "title") item.title = fields[i];
+        else if (column == "content") item.content = fields[i];
+        else if (column == "source") item.source = fields[i];
+        else if (column == "category") item.category = fields[i];
+        else if (column == "url") item.url = fields[i];
+        else if (column == "guid") item.guid = fields[i];
+        else if (column == "published_at") item.published_at = fields[i];
+        else if (column == "created_at") record.created_at_us = ParseTimestamp(fields[i]);
+    }
+
+    if (!Finalize(record, defaults, error)) {
+        return std::nullopt;
+    }
+    return record;
+}
+
+}  // namespace news_aggregator::bulk_import
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+#include "../storage/postgres_client.hpp"
+
+namespace news_aggregator::bulk_import {
+
+enum class InputFormat { kNdjson, kCsv };
+
+// Guesses the format from the file extension (.ndjson/.jsonl/.json or .csv,
+// optionally followed by .gz)
+std::optional<InputFormat> DetectFormat(std::string_view path);
+
+struct ImportRecord {
+    storage::NewsItem item;
+    std::optional<int64_t> published_at_us;
+    std::optional<int64_t> created_at_us;
+};
+
+struct RecordDefaults {
+    std::string source;
+    std::string category = "general";
+};
+
+// Splits a plain or gzip-compressed input into raw records: lines for NDJSON,
+// RFC 4180 records (quoted fields may contain newlines) for CSV
+class RecordReader {
+public:
+    // "-" reads standard input
+    RecordReader(const std::string& path, InputFormat format);
+    ~RecordReader();
+
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    bool IsOpen() const { return file_ != nullptr; }
+    InputFormat GetFormat() const { return format_; }
+
+    // Appends up to `max_records` records; returns false once the input is exhausted
+    bool ReadBatch(std::vector<std::string>& records, size_t max_records);
+
+    // Column names from the first CSV record
+    const std::vector<std::string>& GetCsvHeader() const { return csv_header_; }
+
+private:
+    bool NextRecord(std::string& record);
+    bool FillBuffer();
+
+    InputFormat format_;
+    gzFile file_ = nullptr;
+    std::string buffer_;
+    size_t pos_ = 0;
+    bool eof_ = false;
+    std::vector<std::string> csv_header_;
+};
+
+std::vector<std::string> SplitCsvFields(std::string_view record);
+
+// Return std::nullopt and describe the problem in `error` for malformed records
+std::optional<ImportRecord> ParseNdjsonRecord(std::string_view line, const RecordDefaults& defaults,
+                                              std::string& error);
+std::optional<ImportRecord> ParseCsvRecord(std::string_view record, const std::vector<std::string>& header,
+                                           const RecordDefaults& defaults, std::string& error);
+
+}  // namespace news_aggregator::bulk_import
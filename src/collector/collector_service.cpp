@@ -150,6 +150,7 @@ void CollectorService::SendToStorageService(const NewsSource& source, const RssI
         builder["source"] = source.name;
         builder["category"] = source.category;
         builder["url"] = item.link;
+        builder["guid"] = item.guid;
         builder["published_at"] = item.pub_date;
         
         std::string news_data = formats::json::ToString(builder.ExtractValue());
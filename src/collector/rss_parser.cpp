@@ -4,7 +4,6 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <map>
 
 namespace news_aggregator::collector {
 
@@ -161,8 +160,8 @@ std::string RssParser::CleanHtml(const std::string& html) {
     std::regex tag_regex("<[^>]*>");
     cleaned = std::regex_replace(cleaned, tag_regex, "");
     
-    // Decode HTML entities
-    cleaned = DecodeHtmlEntities(cleaned);
+    // HTML entities are decoded by StorageService when the item is stored;
+    // decoding here too would turn "&amp;lt;" into "<"
     
     // Remove extra whitespace and line breaks
     std::regex whitespace_regex("\\s+");
@@ -179,38 +178,6 @@ std::string RssParser::CleanHtml(const std::string& html) {
     return cleaned;
 }
 
-std::string RssParser::DecodeHtmlEntities(const std::string& text) {
-    std::string decoded = text;
-    
-    // Common HTML entities
-    std::map<std::string, std::string> entities = {
-        {"&amp;", "&"},
-        {"&lt;", "<"},
-        {"&gt;", ">"},
-        {"&quot;", "\""},
-        {"&#39;", "'"},
-        {"&apos;", "'"},
-        {"&nbsp;", " "},
-        {"&mdash;", "—"},
-        {"&ndash;", "–"},
-        {"&hellip;", "…"},
-        {"&copy;", "©"},
-        {"&reg;", "®"},
-        {"&trade;", "™"},
-        {"&euro;", "€"},
-        {"&pound;", "£"},
-        {"&yen;", "¥"},
-        {"&cent;", "¢"}
-    };
-    
-    for (const auto& entity : entities) {
-        std::regex entity_regex(entity.first);
-        decoded = std::regex_replace(decoded, entity_regex, entity.second);
-    }
-    
-    return decoded;
-}
-
 std::string RssParser::NormalizeDate(const std::string& date_str) {
     if (date_str.empty()) {
         return "";
@@ -42,7 +42,6 @@ private:
     std::string ExtractText(const std::string& content, const std::string& tag);
     std::vector<std::string> ExtractAllText(const std::string& content, const std::string& tag);
     std::string CleanHtml(const std::string& html);
-    std::string DecodeHtmlEntities(const std::string& text);
     std::string NormalizeDate(const std::string& date_str);
 };
 
@@ -0,0 +1,109 @@
+#include "news_snapshot.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace news_aggregator::common {
+
+namespace {
+
+constexpr std::string_view kMagic = "NSN1";
+constexpr size_t kHeaderSize = 4 + 8 + 8 + 4;
+
+// Fixed little-endian so the layout is the same on the wire as in Redis
+template <typename T>
+void AppendRaw(std::string& out, T value) {
+    auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out += static_cast<char>(bits & 0xff);
+        bits >>= 8;
+    }
+}
+
+template <typename T>
+T ReadRaw(const char* data) {
+    std::make_unsigned_t<T> bits = 0;
+    for (size_t i = sizeof(T); i-- > 0;) {
+        bits = (bits << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return static_cast<T>(bits);
+}
+
+}  // namespace
+
+uint64_t FoldSnapshotVersion(const std::vector<int64_t>& ids) {
+    // Order-sensitive, so a reordered listing gets another version
+    uint64_t version = 14695981039346656037ULL ^ ids.size();
+    for (const auto id : ids) {
+        version = (version ^ static_cast<uint64_t>(id)) * 0x9e3779b97f4a7c15ULL;
+        version ^= version >> 32;
+    }
+    return version;
+}
+
+std::string EncodeNewsSnapshot(uint64_t version, int64_t timestamp_ms, const std::vector<std::string_view>& items) {
+    const size_t count = std::min(items.size(), kSnapshotItems);
+    size_t items_size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        items_size += items[i].size() + 1;
+    }
+
+    std::string snapshot;
+    snapshot.reserve(kHeaderSize + count * sizeof(uint32_t) + items_size);
+    snapshot += kMagic;
+    AppendRaw<uint64_t>(snapshot, version);
+    AppendRaw<int64_t>(snapshot, timestamp_ms);
+    AppendRaw<uint32_t>(snapshot, static_cast<uint32_t>(count));
+    uint32_t end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        end += static_cast<uint32_t>(items[i].size() + (i != 0 ? 1 : 0));
+        AppendRaw<uint32_t>(snapshot, end);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (i != 0) {
+            snapshot += ',';
+        }
+        snapshot += items[i];
+    }
+    return snapshot;
+}
+
+std::optional<NewsSnapshotView> NewsSnapshotView::Parse(std::string_view data) {
+    if (data.size() < kHeaderSize || data.substr(0, kMagic.size()) != kMagic) {
+        return std::nullopt;
+    }
+    NewsSnapshotView view;
+    view.data_ = data;
+    view.version_ = ReadRaw<uint64_t>(data.data() + 4);
+    view.timestamp_ms_ = ReadRaw<int64_t>(data.data() + 12);
+    view.count_ = ReadRaw<uint32_t>(data.data() + 20);
+    const size_t table_size = view.count_ * sizeof(uint32_t);
+    if (view.count_ > kSnapshotItems || data.size() < kHeaderSize + table_size) {
+        return std::nullopt;
+    }
+    view.ends_ = data.data() + kHeaderSize;
+    view.items_ = data.substr(kHeaderSize + table_size);
+    // Snapshots also arrive over the network now, so check every offset
+    // rather than trusting the table; it is at most kSnapshotItems reads
+    uint32_t previous = 0;
+    for (size_t i = 0; i < view.count_; ++i) {
+        const auto end = ReadRaw<uint32_t>(view.ends_ + i * sizeof(uint32_t));
+        if (end < previous || end > view.items_.size()) {
+            return std::nullopt;
+        }
+        previous = end;
+    }
+    if (previous != view.items_.size()) {
+        return std::nullopt;
+    }
+    return view;
+}
+
+std::string_view NewsSnapshotView::GetItems(size_t count) const {
+    count = std::min(count, count_);
+    if (count == 0) {
+        return {};
+    }
+    return items_.substr(0, ReadRaw<uint32_t>(ends_ + (count - 1) * sizeof(uint32_t)));
+}
+
+} // namespace news_aggregator::common
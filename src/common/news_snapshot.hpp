@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace news_aggregator::common {
+
+// Snapshot of the newest listing entries shared by StorageService, which
+// serves it from /internal/news/latest, and the API gateway, which caches it
+// and cuts pages of any size from it.
+
+// Largest page the gateway serves; a snapshot holds this many newest items
+inline constexpr size_t kSnapshotItems = 100;
+
+// Version of a listing of these news ids, newest first. Stored rows never
+// change, so the ids identify the listing without reading its bytes; pass
+// the ids of exactly the items given to EncodeNewsSnapshot.
+uint64_t FoldSnapshotVersion(const std::vector<int64_t>& ids);
+
+// Lays out already serialized items (JSON objects, newest first) as a snapshot.
+// StorageService uses it to answer /internal/news/latest in this format, so
+// the gateway can cache the response body as is.
+std::string EncodeNewsSnapshot(uint64_t version, int64_t timestamp_ms, const std::vector<std::string_view>& items);
+
+// Zero-copy view of a snapshot built by EncodeNewsSnapshot. Layout, integers
+// little-endian:
+//   "NSN1" | version u64 | timestamp_ms i64 | count u32 | end offset u32 * count | items
+// where items are comma-joined JSON objects and end offsets are relative to them.
+class NewsSnapshotView {
+public:
+    // std::nullopt for bytes that are not a well-formed snapshot
+    static std::optional<NewsSnapshotView> Parse(std::string_view data);
+
+    // Equal versions mean identical listings
+    uint64_t GetVersion() const { return version_; }
+    int64_t GetTimestampMs() const { return timestamp_ms_; }
+    size_t GetItemCount() const { return count_; }
+    // The first `count` items, comma-joined
+    std::string_view GetItems(size_t count) const;
+
+private:
+    std::string_view data_;
+    uint64_t version_ = 0;
+    int64_t timestamp_ms_ = 0;
+    size_t count_ = 0;
+    const char* ends_ = nullptr;
+    std::string_view items_;
+};
+
+} // namespace news_aggregator::common
@@ -3,7 +3,7 @@
 #include <stdexcept>
 #include <chrono>
 
-namespace news_aggregator::gateway {
+namespace news_aggregator::common {
 
 RedisClient::RedisClient(const std::string& host, int port, int timeout_ms)
     : host_(host), port_(port), timeout_ms_(timeout_ms), context_(nullptr), connected_(false) {
@@ -34,6 +34,11 @@ bool RedisClient::Connect() {
         return false;
     }
 
+    // The same timeout bounds every command, so a stalled server cannot hang a caller
+    if (redisSetTimeout(context_, timeout) != REDIS_OK) {
+        LOG_WARNING() << "Failed to set Redis command timeout";
+    }
+
     connected_ = true;
     LOG_INFO() << "Successfully connected to Redis at " << host_ << ":" << port_;
     return true;
@@ -52,6 +57,23 @@ bool RedisClient::IsConnected() const {
     return connected_ && context_ != nullptr;
 }
 
+bool RedisClient::Ping() {
+    if (!IsConnected()) {
+        return false;
+    }
+
+    redisReply* reply = static_cast<redisReply*>(redisCommand(context_, "PING"));
+
+    if (reply == nullptr) {
+        HandleRedisError("PING");
+        return false;
+    }
+
+    bool success = (reply->type == REDIS_REPLY_STATUS);
+    freeReplyObject(reply);
+    return success;
+}
+
 bool RedisClient::Set(const std::string& key, const std::string& value, int expire_seconds) {
     if (!IsConnected()) {
         LOG_ERROR() << "Not connected to Redis.";
@@ -109,6 +131,42 @@ std::string RedisClient::Get(const std::string& key) {
     return result;
 }
 
+RedisClient::ValueWithTtl RedisClient::GetWithTtl(const std::string& key) {
+    ValueWithTtl result;
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to Redis.";
+        return result;
+    }
+
+    if (redisAppendCommand(context_, "GET %s", key.c_str()) != REDIS_OK ||
+        redisAppendCommand(context_, "PTTL %s", key.c_str()) != REDIS_OK) {
+        HandleRedisError("GET+PTTL");
+        return result;
+    }
+
+    // Both replies have to be read, or the next command would see the second one
+    void* replies[2] = {nullptr, nullptr};
+    for (auto& reply : replies) {
+        if (redisGetReply(context_, &reply) != REDIS_OK) {
+            if (replies[0]) {
+                freeReplyObject(replies[0]);
+            }
+            HandleRedisError("GET+PTTL");
+            return result;
+        }
+    }
+
+    const auto* value = static_cast<redisReply*>(replies[0]);
+    const auto* ttl = static_cast<redisReply*>(replies[1]);
+    if (value->type == REDIS_REPLY_STRING && ttl->type == REDIS_REPLY_INTEGER) {
+        result.value = std::string(value->str, value->len);
+        result.ttl_ms = ttl->integer;
+    }
+    freeReplyObject(replies[0]);
+    freeReplyObject(replies[1]);
+    return result;
+}
+
 bool RedisClient::Del(const std::string& key) {
     if (!IsConnected()) {
         LOG_ERROR() << "Not connected to Redis.";
@@ -154,6 +212,25 @@ bool RedisClient::Exists(const std::string& key) {
     return exists;
 }
 
+bool RedisClient::Publish(const std::string& channel, const std::string& message) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to Redis.";
+        return false;
+    }
+
+    redisReply* reply = static_cast<redisReply*>(
+        redisCommand(context_, "PUBLISH %s %b", channel.c_str(), message.data(), message.size()));
+
+    if (reply == nullptr) {
+        HandleRedisError("PUBLISH");
+        return false;
+    }
+
+    bool success = (reply->type == REDIS_REPLY_INTEGER);
+    freeReplyObject(reply);
+    return success;
+}
+
 bool RedisClient::SetJson(const std::string& key, const std::string& json_value, int expire_seconds) {
     return Set(key, json_value, expire_seconds);
 }
@@ -165,11 +242,11 @@ std::string RedisClient::GetJson(const std::string& key) {
 void RedisClient::HandleRedisError(const std::string& operation) {
     if (context_ && context_->err) {
         LOG_ERROR() << "Redis error during " << operation << ": " << context_->errstr;
-        // Don't disconnect on error, let the caller decide
     } else {
         LOG_ERROR() << "Redis connection lost during " << operation;
-        connected_ = false;
     }
+    // hiredis contexts are unusable after an I/O error or timeout; the pool reconnects
+    Disconnect();
 }
 
-} // namespace news_aggregator::gateway
+} // namespace news_aggregator::common
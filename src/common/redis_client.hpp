@@ -1,10 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <hiredis/hiredis.h>
 
-namespace news_aggregator::gateway {
+namespace news_aggregator::common {
 
 class RedisClient {
 public:
@@ -14,6 +15,8 @@ public:
     bool Connect();
     void Disconnect();
     bool IsConnected() const;
+    // Round trip on the open connection; drops it when the server does not answer
+    bool Ping();
 
     // String operations
     bool Set(const std::string& key, const std::string& value, int expire_seconds = 0);
@@ -21,6 +24,17 @@ public:
     bool Del(const std::string& key);
     bool Exists(const std::string& key);
 
+    // GET and PTTL pipelined in one round trip. ttl_ms is -1 for a key without
+    // expiry; value is empty on a miss or error
+    struct ValueWithTtl {
+        std::string value;
+        int64_t ttl_ms = -2;
+    };
+    ValueWithTtl GetWithTtl(const std::string& key);
+
+    // Pub/sub; returns false when the message could not be sent
+    bool Publish(const std::string& channel, const std::string& message);
+
     // JSON operations
     bool SetJson(const std::string& key, const std::string& json_value, int expire_seconds = 0);
     std::string GetJson(const std::string& key);
@@ -35,4 +49,4 @@ private:
     void HandleRedisError(const std::string& operation);
 };
 
-} // namespace news_aggregator::gateway
+} // namespace news_aggregator::common
@@ -0,0 +1,102 @@
+#include "change_subscriber.hpp"
+#include <userver/engine/sleep.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <poll.h>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// Bounds how long a stop request waits for the blocking poll
+constexpr int kPollTimeoutMs = 1000;
+
+}  // namespace
+
+ChangeSubscriber::ChangeSubscriber(std::string host, int port, std::string channel,
+                                   std::chrono::milliseconds timeout)
+    : host_(std::move(host)), port_(port), channel_(std::move(channel)), timeout_(timeout) {
+}
+
+ChangeSubscriber::~ChangeSubscriber() {
+    Disconnect();
+}
+
+void ChangeSubscriber::Run(const std::atomic<bool>& should_stop, const MessageCallback& on_message,
+                           const StateCallback& on_state) {
+    while (!should_stop) {
+        if (!context_) {
+            if (!Subscribe()) {
+                engine::SleepFor(std::chrono::seconds(1));
+                continue;
+            }
+            on_state(true);
+        }
+
+        // Waiting in poll() rather than in a socket read timeout keeps the
+        // context usable when the channel is quiet
+        pollfd descriptor{context_->fd, POLLIN, 0};
+        const int ready = poll(&descriptor, 1, kPollTimeoutMs);
+        if (ready == 0) {
+            continue;
+        }
+        if (ready < 0 || redisBufferRead(context_) != REDIS_OK || !DrainReplies(on_message)) {
+            LOG_WARNING() << "Lost the subscription to " << channel_ << ", reconnecting";
+            Disconnect();
+            on_state(false);
+        }
+    }
+    Disconnect();
+}
+
+bool ChangeSubscriber::Subscribe() {
+    const timeval timeout = {static_cast<time_t>(timeout_.count() / 1000),
+                             static_cast<suseconds_t>((timeout_.count() % 1000) * 1000)};
+    context_ = redisConnectWithTimeout(host_.c_str(), port_, timeout);
+    if (context_ == nullptr || context_->err) {
+        LOG_ERROR() << "Failed to connect to Redis for " << channel_ << ": "
+                    << (context_ ? context_->errstr : "allocation failed");
+        Disconnect();
+        return false;
+    }
+
+    auto* reply = static_cast<redisReply*>(redisCommand(context_, "SUBSCRIBE %s", channel_.c_str()));
+    if (reply == nullptr) {
+        LOG_ERROR() << "Failed to subscribe to " << channel_ << ": " << context_->errstr;
+        Disconnect();
+        return false;
+    }
+    freeReplyObject(reply);
+    LOG_INFO() << "Subscribed to " << channel_;
+    return true;
+}
+
+void ChangeSubscriber::Disconnect() {
+    if (context_) {
+        redisFree(context_);
+        context_ = nullptr;
+    }
+}
+
+bool ChangeSubscriber::DrainReplies(const MessageCallback& on_message) {
+    while (true) {
+        void* raw = nullptr;
+        if (redisGetReplyFromReader(context_, &raw) != REDIS_OK) {
+            return false;
+        }
+        if (raw == nullptr) {
+            return true;
+        }
+        const auto* reply = static_cast<redisReply*>(raw);
+        // ["message", channel, payload]
+        if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+            reply->element[0]->type == REDIS_REPLY_STRING &&
+            std::string(reply->element[0]->str, reply->element[0]->len) == "message" &&
+            reply->element[2]->type == REDIS_REPLY_STRING) {
+            on_message(std::string(reply->element[2]->str, reply->element[2]->len));
+        }
+        freeReplyObject(raw);
+    }
+}
+
+} // namespace news_aggregator::gateway
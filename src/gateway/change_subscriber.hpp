@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <hiredis/hiredis.h>
+
+namespace news_aggregator::gateway {
+
+// Dedicated Redis connection subscribed to one pub/sub channel. A subscribed
+// connection cannot run other commands, so it is kept outside the pool.
+class ChangeSubscriber {
+public:
+    using MessageCallback = std::function<void(const std::string& payload)>;
+    // Called with true after every successful (re)subscribe and with false when the connection drops
+    using StateCallback = std::function<void(bool subscribed)>;
+
+    ChangeSubscriber(std::string host, int port, std::string channel, std::chrono::milliseconds timeout);
+    ~ChangeSubscriber();
+
+    // Receives messages until `should_stop` is set, reconnecting as needed. Blocking.
+    void Run(const std::atomic<bool>& should_stop, const MessageCallback& on_message,
+             const StateCallback& on_state);
+
+private:
+    bool Subscribe();
+    void Disconnect();
+    // Handles every reply already parsed; false when the connection is broken
+    bool DrainReplies(const MessageCallback& on_message);
+
+    const std::string host_;
+    const int port_;
+    const std::string channel_;
+    const std::chrono::milliseconds timeout_;
+    redisContext* context_ = nullptr;
+};
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,147 @@
+#include "compression.hpp"
+#include <brotli/encode.h>
+#include <zlib.h>
+#include <cctype>
+#include <cstdlib>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+std::string_view Trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// q-value of one Accept-Encoding element such as "gzip;q=0.5"; 1 when absent
+double ParseQuality(std::string_view params) {
+    while (!params.empty()) {
+        const auto semicolon = params.find(';');
+        const auto param = Trim(params.substr(0, semicolon));
+        params = semicolon == std::string_view::npos ? std::string_view{} : params.substr(semicolon + 1);
+        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            return std::strtod(std::string(param.substr(2)).c_str(), nullptr);
+        }
+    }
+    return 1.0;
+}
+
+std::optional<std::string> Gzip(std::string_view data, int level) {
+    z_stream stream{};
+    // 16 on top of the window bits selects the gzip wrapper
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::nullopt;
+    }
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    const int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<std::string> Brotli(std::string_view data, int quality) {
+    std::string out(BrotliEncoderMaxCompressedSize(data.size()), '\0');
+    size_t out_size = out.size();
+    if (out.empty() ||
+        !BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                               reinterpret_cast<const uint8_t*>(data.data()), &out_size,
+                               reinterpret_cast<uint8_t*>(out.data()))) {
+        return std::nullopt;
+    }
+    out.resize(out_size);
+    return out;
+}
+
+}  // namespace
+
+ContentEncoding NegotiateEncoding(std::string_view accept_encoding) {
+    double brotli = 0.0;
+    double gzip = 0.0;
+    double any = 0.0;
+    bool brotli_listed = false;
+    bool gzip_listed = false;
+    while (!accept_encoding.empty()) {
+        const auto comma = accept_encoding.find(',');
+        const auto element = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+
+        const auto semicolon = element.find(';');
+        const auto coding = Trim(element.substr(0, semicolon));
+        const double quality =
+            semicolon == std::string_view::npos ? 1.0 : ParseQuality(element.substr(semicolon + 1));
+        if (EqualsIgnoreCase(coding, "br")) {
+            brotli = quality;
+            brotli_listed = true;
+        } else if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) {
+            gzip = quality;
+            gzip_listed = true;
+        } else if (coding == "*") {
+            any = quality;
+        }
+    }
+    // "*" covers the codings not listed by name
+    if (!brotli_listed) {
+        brotli = any;
+    }
+    if (!gzip_listed) {
+        gzip = any;
+    }
+
+    if (brotli > 0.0 && brotli >= gzip) {
+        return ContentEncoding::kBrotli;
+    }
+    if (gzip > 0.0) {
+        return ContentEncoding::kGzip;
+    }
+    return ContentEncoding::kIdentity;
+}
+
+std::string_view GetEncodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::kGzip:
+            return "gzip";
+        case ContentEncoding::kBrotli:
+            return "br";
+        case ContentEncoding::kIdentity:
+            break;
+    }
+    return "identity";
+}
+
+std::optional<std::string> Compress(std::string_view data, ContentEncoding encoding, const CompressionLevels& levels) {
+    switch (encoding) {
+        case ContentEncoding::kGzip:
+            return Gzip(data, levels.gzip);
+        case ContentEncoding::kBrotli:
+            return Brotli(data, levels.brotli);
+        case ContentEncoding::kIdentity:
+            break;
+    }
+    return std::string(data);
+}
+
+} // namespace news_aggregator::gateway
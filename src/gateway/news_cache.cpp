@@ -0,0 +1,567 @@
+#include "news_cache.hpp"
+
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/formats/json/value.hpp>
+#include <algorithm>
+#include <mutex>
+#include "change_subscriber.hpp"
+#include "redis_component.hpp"
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// Bounds the refresh-ahead bookkeeping when keys are many and short-lived
+constexpr size_t kMaxLoaders = 4096;
+// Bounds the per-category change times; past it an event stales everything
+constexpr size_t kMaxTrackedCategories = 1024;
+
+constexpr std::string_view kAllSnapshotKey = "news:snapshot:all";
+constexpr std::string_view kCategorySnapshotPrefix = "news:snapshot:category:";
+
+// Tick of the refresh-ahead loop: change events refresh hot keys at most this
+// often, and heat decays every kTicksPerDecay ticks
+constexpr std::chrono::milliseconds kRefreshTick{250};
+constexpr int kTicksPerDecay = 4;
+
+void RaiseTo(std::atomic<int64_t>& value, int64_t candidate) {
+    auto current = value.load();
+    while (current < candidate && !value.compare_exchange_weak(current, candidate)) {
+    }
+}
+
+}  // namespace
+
+NewsCache::NewsCache(const components::ComponentConfig& config,
+                     const components::ComponentContext& component_context)
+    : LoggableComponentBase(config, component_context),
+      redis_pool_(component_context.FindComponent<RedisComponent>().GetPool()),
+      fs_task_processor_(component_context.GetTaskProcessor(
+          config["fs-task-processor"].As<std::string>("fs-task-processor"))),
+      refresh_tasks_(fs_task_processor_) {
+    const auto memory_config = config["memory"];
+    ResponseCacheConfig cache_config;
+    cache_config.shards = memory_config["shards"].As<size_t>(cache_config.shards);
+    cache_config.max_bytes = memory_config["max_bytes"].As<size_t>(cache_config.max_bytes);
+    memory_ = std::make_unique<ResponseCache>(cache_config);
+    soft_ttl_ = config["soft_ttl_seconds"].As<std::chrono::seconds>(soft_ttl_);
+    hard_ttl_ = std::max(soft_ttl_, config["hard_ttl_seconds"].As<std::chrono::seconds>(hard_ttl_));
+    load_timeout_ = std::chrono::milliseconds(config["load_timeout_ms"].As<int>(load_timeout_.count()));
+    const auto refresh_ahead_config = config["refresh_ahead"];
+    refresh_ahead_top_k_ = refresh_ahead_config["top_k"].As<size_t>(refresh_ahead_top_k_);
+    refresh_ahead_lead_ = refresh_ahead_config["lead_seconds"].As<std::chrono::seconds>(refresh_ahead_lead_);
+    const auto invalidation_config = config["invalidation"];
+    invalidation_enabled_ = invalidation_config["enabled"].As<bool>(false);
+    invalidation_channel_ = invalidation_config["channel"].As<std::string>(invalidation_channel_);
+    fallback_soft_ttl_ = std::min(
+        soft_ttl_, invalidation_config["fallback_soft_ttl_seconds"].As<std::chrono::seconds>(fallback_soft_ttl_));
+    const auto compression_config = config["compression"];
+    compression_enabled_ = compression_config["enabled"].As<bool>(compression_enabled_);
+    compression_levels_.gzip = std::clamp(compression_config["gzip_level"].As<int>(compression_levels_.gzip), 1, 9);
+    compression_levels_.brotli =
+        std::clamp(compression_config["brotli_quality"].As<int>(compression_levels_.brotli), 0, 11);
+    ResponseCacheConfig compressed_config;
+    compressed_config.shards = cache_config.shards;
+    compressed_config.max_bytes = compression_config["max_bytes"].As<size_t>(cache_config.max_bytes / 4);
+    compressed_ = std::make_unique<ResponseCache>(compressed_config);
+
+    statistics_holder_ = component_context.FindComponent<components::StatisticsStorage>()
+                             .GetStorage()
+                             .RegisterWriter("news-cache", [this](utils::statistics::Writer& writer) {
+                                 const auto stats = memory_->GetStats();
+                                 auto memory_writer = writer["memory"];
+                                 memory_writer["entries"] = stats.entries;
+                                 memory_writer["bytes"] = stats.bytes;
+                                 memory_writer["hits"] = stats.hits;
+                                 memory_writer["stale_hits"] = stats.stale_hits;
+                                 memory_writer["misses"] = stats.misses;
+                                 memory_writer["expired"] = stats.expired;
+                                 memory_writer["evictions"] = stats.evictions;
+                                 const auto lookups = stats.hits + stats.misses;
+                                 memory_writer["hit_rate"] =
+                                     lookups == 0 ? 0.0 : static_cast<double>(stats.hits) / lookups;
+                                 auto redis_writer = writer["redis"];
+                                 redis_writer["hits"] = redis_hits_.load();
+                                 redis_writer["stale_hits"] = redis_stale_hits_.load();
+                                 redis_writer["misses"] = redis_misses_.load();
+                                 redis_writer["unavailable"] = redis_unavailable_.load();
+                                 const auto load_stats = loads_.GetStats();
+                                 auto loads_writer = writer["upstream"];
+                                 loads_writer["loads"] = load_stats.loads;
+                                 loads_writer["coalesced"] = load_stats.coalesced;
+                                 loads_writer["failed"] = load_stats.failed_loads;
+                                 loads_writer["timeouts"] = load_stats.timeouts;
+                                 auto refresh_writer = writer["refresh"];
+                                 refresh_writer["stale"] = refreshes_.load();
+                                 refresh_writer["ahead"] = refreshes_ahead_.load();
+                                 refresh_writer["failed"] = failed_refreshes_.load();
+                                 if (compression_enabled_) {
+                                     const auto compressed_stats = compressed_->GetStats();
+                                     auto compression_writer = writer["compression"];
+                                     compression_writer["entries"] = compressed_stats.entries;
+                                     compression_writer["bytes"] = compressed_stats.bytes;
+                                     compression_writer["hits"] = compressed_stats.hits;
+                                     compression_writer["misses"] = compressed_stats.misses;
+                                     const auto compressed_lookups = compressed_stats.hits + compressed_stats.misses;
+                                     compression_writer["hit_rate"] =
+                                         compressed_lookups == 0
+                                             ? 0.0
+                                             : static_cast<double>(compressed_stats.hits) / compressed_lookups;
+                                     compression_writer["evictions"] = compressed_stats.evictions;
+                                     compression_writer["built"] = compressions_.load();
+                                     compression_writer["failed"] = failed_compressions_.load();
+                                     const auto input_bytes = compression_input_bytes_.load();
+                                     compression_writer["ratio"] =
+                                         input_bytes == 0
+                                             ? 0.0
+                                             : static_cast<double>(compression_output_bytes_.load()) / input_bytes;
+                                 }
+                                 if (invalidation_enabled_) {
+                                     auto invalidation_writer = writer["invalidation"];
+                                     invalidation_writer["subscribed"] = subscribed_.load() ? 1 : 0;
+                                     invalidation_writer["events"] = change_events_.load();
+                                 }
+                             });
+
+    LOG_INFO() << "News cache: " << cache_config.shards << " memory shards, " << cache_config.max_bytes
+               << " bytes, soft TTL " << soft_ttl_.count() << "s, hard TTL " << hard_ttl_.count() << "s, invalidation "
+               << (invalidation_enabled_ ? "on " + invalidation_channel_ : std::string("disabled"));
+}
+
+NewsCache::~NewsCache() {
+    statistics_holder_.Unregister();
+}
+
+void NewsCache::OnAllComponentsLoaded() {
+    if (refresh_ahead_top_k_ > 0) {
+        StartRefreshAheadLoop();
+    }
+    if (invalidation_enabled_) {
+        StartChangeSubscription();
+    }
+}
+
+void NewsCache::OnAllComponentsAreStopping() {
+    should_stop_ = true;
+    if (refresh_ahead_task_.IsValid()) {
+        refresh_ahead_task_.Wait();
+    }
+    if (subscription_task_.IsValid()) {
+        subscription_task_.Wait();
+    }
+    refresh_tasks_.CancelAndWait();
+}
+
+std::string NewsCache::GetSnapshotKey(std::string_view category) {
+    if (category.empty()) {
+        return std::string(kAllSnapshotKey);
+    }
+    std::string key(kCategorySnapshotPrefix);
+    key += category;
+    return key;
+}
+
+CacheLookup NewsCache::Lookup(const std::string& key) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto fresh_after = GetFreshAfter(key, now);
+    if (auto cached = memory_->Get(key, fresh_after); cached.body) {
+        return {std::move(cached.body), CacheTier::kMemory, cached.stale};
+    }
+
+    // hiredis blocks its thread, so the round trip runs on the blocking task
+    // processor while the request waits without holding a main thread
+    auto lookup = engine::AsyncNoSpan(fs_task_processor_, [this, &key]() -> std::optional<common::RedisClient::ValueWithTtl> {
+        auto redis_client = redis_pool_.Acquire();
+        if (!redis_client) {
+            return std::nullopt;
+        }
+        return (*redis_client)->GetWithTtl(key);
+    }).Get();
+    if (!lookup) {
+        ++redis_unavailable_;
+        return {};
+    }
+    auto& cached = *lookup;
+    if (cached.value.empty()) {
+        ++redis_misses_;
+        return {};
+    }
+    ++redis_hits_;
+
+    // Redis only knows the remaining lifetime; the age follows from the hard TTL it was stored with
+    const auto remaining = cached.ttl_ms < 0 ? std::chrono::milliseconds(hard_ttl_)
+                                             : std::chrono::milliseconds(cached.ttl_ms);
+    const auto stored_at = now - (std::chrono::milliseconds(hard_ttl_) - remaining);
+    const bool stale = stored_at < fresh_after;
+    if (stale) {
+        ++redis_stale_hits_;
+    }
+
+    auto body = std::make_shared<const std::string>(std::move(cached.value));
+    memory_->Put(key, body, stored_at, now + remaining);
+    return {std::move(body), CacheTier::kRedis, stale};
+}
+
+void NewsCache::Store(const std::string& key, const std::string& body, ResponseCache::TimePoint stored_at) {
+    auto stored = std::make_shared<const std::string>(body);
+    memory_->Put(key, stored, stored_at, stored_at + hard_ttl_);
+    // Nobody waits for the L2 copy; the write runs on the blocking task processor
+    refresh_tasks_.AsyncDetach("news-cache-store", [this, key, stored = std::move(stored)] {
+        if (auto redis_client = redis_pool_.Acquire()) {
+            (*redis_client)->Set(key, *stored, static_cast<int>(hard_ttl_.count()));
+        } else {
+            ++redis_unavailable_;
+        }
+    });
+}
+
+CacheLookup NewsCache::GetOrLoad(const std::string& key, const Loader& loader) {
+    auto cached = Lookup(key);
+    if (cached.body) {
+        if (cached.tier == CacheTier::kRedis) {
+            RememberLoader(key, loader);
+        }
+        if (cached.stale) {
+            StartRefresh(key, loader);
+        }
+        return cached;
+    }
+
+    RememberLoader(key, loader);
+    const auto deadline = std::chrono::steady_clock::now() + load_timeout_;
+    auto body = loads_.Run(key, deadline, [this, &key, &loader]() -> ResponseCache::Body {
+        // A load that finished between our miss and taking the lead already stored the key
+        if (auto stored = memory_->Get(key, GetFreshAfter(key, std::chrono::steady_clock::now()));
+            stored.body && !stored.stale) {
+            return stored.body;
+        }
+        return Load(key, loader);
+    });
+    return {std::move(body), CacheTier::kUpstream};
+}
+
+ResponseCache::Body NewsCache::GetCompressed(const std::string& page_key, ContentEncoding encoding,
+                                             PageRenderer render) {
+    if (!compression_enabled_ || encoding == ContentEncoding::kIdentity) {
+        return nullptr;
+    }
+    auto key = page_key;
+    key += '|';
+    key += GetEncodingName(encoding);
+    // The key changes with the page, so a compressed copy never turns stale
+    if (auto cached = compressed_->Get(key, ResponseCache::TimePoint::min()); cached.body) {
+        return std::move(cached.body);
+    }
+
+    {
+        std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+        if (!compressing_.insert(key).second) {
+            return nullptr;
+        }
+    }
+    refresh_tasks_.AsyncDetach("news-cache-compress", [this, key, encoding, render = std::move(render)] {
+        const auto page = render();
+        auto compressed = Compress(page, encoding, compression_levels_);
+        if (compressed) {
+            ++compressions_;
+            compression_input_bytes_ += page.size();
+            compression_output_bytes_ += compressed->size();
+            const auto now = std::chrono::steady_clock::now();
+            compressed_->Put(key, std::make_shared<const std::string>(std::move(*compressed)), now, now + hard_ttl_);
+        } else {
+            ++failed_compressions_;
+            LOG_WARNING() << "Failed to compress " << key;
+        }
+        std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+        compressing_.erase(key);
+    });
+    return nullptr;
+}
+
+ResponseCache::Body NewsCache::Load(const std::string& key, const Loader& loader) {
+    // Taken before the request, so a change event that arrives during it still marks the result stale
+    const auto started = std::chrono::steady_clock::now();
+    auto loaded = loader();
+    if (!loaded) {
+        return nullptr;
+    }
+    Store(key, *loaded, started);
+    return std::make_shared<const std::string>(std::move(*loaded));
+}
+
+void NewsCache::StartRefresh(const std::string& key, Loader loader) {
+    {
+        std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+        if (!refreshing_.insert(key).second) {
+            return;
+        }
+    }
+    ++refreshes_;
+
+    refresh_tasks_.AsyncDetach("news-cache-refresh", [this, key, loader = std::move(loader)] {
+        // Shares the flight with requests that miss the key outright meanwhile
+        const auto body = loads_.Run(key, std::chrono::steady_clock::now() + load_timeout_,
+                                     [this, &key, &loader] { return Load(key, loader); });
+        if (!body) {
+            ++failed_refreshes_;
+            LOG_WARNING() << "Background refresh of " << key << " failed, serving the stale copy";
+        }
+        std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+        refreshing_.erase(key);
+    });
+}
+
+void NewsCache::RememberLoader(const std::string& key, const Loader& loader) {
+    std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+    if (loaders_.size() >= kMaxLoaders && loaders_.count(key) == 0) {
+        // Keys that are still hot are re-registered by their next miss or stale hit
+        loaders_.clear();
+    }
+    loaders_[key] = loader;
+}
+
+void NewsCache::StartRefreshAheadLoop() {
+    refresh_ahead_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        for (int tick = 1; !should_stop_; ++tick) {
+            engine::SleepFor(kRefreshTick);
+            if (should_stop_) {
+                break;
+            }
+            if (tick % kTicksPerDecay == 0) {
+                memory_->DecayHeat();
+                RefreshHotKeys();
+            } else if (hot_refresh_pending_.exchange(false)) {
+                RefreshHotKeys();
+            }
+        }
+    });
+}
+
+void NewsCache::RefreshHotKeys() {
+    // Hot keys are reloaded before they turn stale, so their readers never see a miss
+    const auto now = std::chrono::steady_clock::now();
+    last_hot_refresh_ = now.time_since_epoch().count();
+    for (auto& hot : memory_->GetHottest(refresh_ahead_top_k_)) {
+        if (hot.stored_at >= GetFreshAfter(hot.key, now + refresh_ahead_lead_)) {
+            continue;
+        }
+        Loader loader;
+        {
+            std::lock_guard<engine::Mutex> lock(refresh_mutex_);
+            const auto found = loaders_.find(hot.key);
+            if (found == loaders_.end()) {
+                continue;
+            }
+            loader = found->second;
+        }
+        ++refreshes_ahead_;
+        StartRefresh(hot.key, std::move(loader));
+    }
+}
+
+void NewsCache::StartChangeSubscription() {
+    subscription_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        const auto& redis_config = redis_pool_.GetConfig();
+        ChangeSubscriber subscriber(redis_config.host, redis_config.port, invalidation_channel_,
+                                    redis_config.timeout);
+        subscriber.Run(
+            should_stop_, [this](const std::string& payload) { OnChange(payload); },
+            [this](bool subscribed) {
+                subscribed_ = subscribed;
+                // Events published while unsubscribed are lost, so everything cached before is suspect
+                if (subscribed) {
+                    const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+                    everything_changed_ = now;
+                    last_change_ = now;
+                }
+            });
+        subscribed_ = false;
+    });
+}
+
+void NewsCache::RequestHotRefresh() {
+    const ResponseCache::TimePoint last_refresh{ResponseCache::TimePoint::duration(last_hot_refresh_.load())};
+    if (std::chrono::steady_clock::now() - last_refresh >= kRefreshTick) {
+        RefreshHotKeys();
+    } else {
+        hot_refresh_pending_ = true;
+    }
+}
+
+void NewsCache::OnChange(const std::string& payload) {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    last_change_ = now;
+    ++change_events_;
+
+    // StorageService leaves the names out when a merged event touched too
+    // many of them; then, as for a malformed event, any category may have changed
+    std::vector<std::string> categories;
+    bool all_categories = true;
+    int64_t max_id = 0;
+    try {
+        const auto event = formats::json::FromString(payload);
+        if (event.HasMember("categories")) {
+            for (const auto& category : event["categories"]) {
+                categories.push_back(category.As<std::string>());
+            }
+            all_categories = false;
+        }
+        max_id = event["max_id"].As<int64_t>(0);
+        LOG_DEBUG() << "News changed: " << event["count"].As<int>(0) << " rows up to id " << max_id;
+    } catch (const std::exception& ex) {
+        LOG_WARNING() << "Malformed change event: " << ex.what();
+    }
+    RaiseTo(last_max_id_, max_id);
+
+    if (!all_categories && !categories.empty()) {
+        auto changes = category_changes_.StartWrite();
+        if (changes->size() + categories.size() > kMaxTrackedCategories) {
+            changes->clear();
+            all_categories = true;
+        } else {
+            for (const auto& category : categories) {
+                auto& change = (*changes)[category];
+                change.time = now;
+                change.max_id = std::max(change.max_id, max_id);
+            }
+        }
+        changes.Commit();
+    }
+    if (all_categories) {
+        everything_changed_ = now;
+        // The cleared categories' ids live on here
+        RaiseTo(everything_max_id_, last_max_id_.load());
+    }
+
+    if (refresh_ahead_top_k_ > 0) {
+        RequestHotRefresh();
+    }
+}
+
+int64_t NewsCache::GetChangedUpTo(const std::string& key) const {
+    const std::string_view key_view = key;
+    if (key_view.substr(0, kCategorySnapshotPrefix.size()) != kCategorySnapshotPrefix) {
+        return last_max_id_.load();
+    }
+    auto max_id = everything_max_id_.load();
+    const auto changes = category_changes_.Read();
+    const auto found = changes->find(std::string(key_view.substr(kCategorySnapshotPrefix.size())));
+    if (found != changes->end()) {
+        max_id = std::max(max_id, found->second.max_id);
+    }
+    return max_id;
+}
+
+ResponseCache::TimePoint NewsCache::GetFreshAfter(const std::string& key, ResponseCache::TimePoint now) const {
+    const auto soft_ttl = !invalidation_enabled_ || subscribed_ ? soft_ttl_ : fallback_soft_ttl_;
+    auto changed = everything_changed_.load();
+    const std::string_view key_view = key;
+    if (key_view.substr(0, kCategorySnapshotPrefix.size()) == kCategorySnapshotPrefix) {
+        const auto changes = category_changes_.Read();
+        const auto found = changes->find(std::string(key_view.substr(kCategorySnapshotPrefix.size())));
+        if (found != changes->end()) {
+            changed = std::max(changed, found->second.time);
+        }
+    } else {
+        // The all-news snapshot, and any key this cache does not know the scope of
+        changed = std::max(changed, last_change_.load());
+    }
+    return std::max(now - soft_ttl, ResponseCache::TimePoint{ResponseCache::TimePoint::duration(changed)});
+}
+
+yaml_config::Schema NewsCache::GetStaticConfigSchema() {
+    return yaml_config::MergeSchemas<components::LoggableComponentBase>(R"(
+type: object
+description: two-tier cache of gateway responses
+additionalProperties: false
+properties:
+    soft_ttl_seconds:
+        type: integer
+        description: age after which a response is served stale and reloaded in the background
+        defaultDescription: 30
+    hard_ttl_seconds:
+        type: integer
+        description: age after which a response is no longer served; also its lifetime in Redis
+        defaultDescription: 300
+    load_timeout_ms:
+        type: integer
+        description: how long a request waits for a StorageService load started by a concurrent request
+        defaultDescription: 10000
+    fs-task-processor:
+        type: string
+        description: task processor for Redis round trips and background reloads, which block on hiredis and libcurl
+        defaultDescription: fs-task-processor
+    refresh_ahead:
+        type: object
+        description: reloading of the most requested keys before they turn stale
+        additionalProperties: false
+        properties:
+            top_k:
+                type: integer
+                description: keys with the most recent hits (halved every second) that are kept warm, 0 disables
+                defaultDescription: 32
+            lead_seconds:
+                type: integer
+                description: how long before the soft TTL a hot key is reloaded
+                defaultDescription: 5
+    invalidation:
+        type: object
+        description: staleness driven by the change events StorageService publishes after inserts
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: subscribe to change events
+                defaultDescription: false
+            channel:
+                type: string
+                description: Redis pub/sub channel of the events
+                defaultDescription: news:changes
+            fallback_soft_ttl_seconds:
+                type: integer
+                description: soft TTL used instead while the subscription is down
+                defaultDescription: 30
+    compression:
+        type: object
+        description: precompressed gzip and brotli copies of served pages
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: serve compressed pages to clients that accept them
+                defaultDescription: true
+            gzip_level:
+                type: integer
+                description: zlib compression level, 1-9
+                defaultDescription: 6
+            brotli_quality:
+                type: integer
+                description: brotli quality, 0-11
+                defaultDescription: 5
+            max_bytes:
+                type: integer
+                description: memory budget of the compressed pages
+                defaultDescription: a quarter of memory.max_bytes
+    memory:
+        type: object
+        description: in-process LRU in front of Redis
+        additionalProperties: false
+        properties:
+            shards:
+                type: integer
+                description: independently locked LRU shards
+                defaultDescription: 16
+            max_bytes:
+                type: integer
+                description: memory budget of all shards together
+                defaultDescription: 67108864
+)");
+}
+
+} // namespace news_aggregator::gateway
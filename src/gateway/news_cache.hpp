@@ -0,0 +1,179 @@
+#pragma once
+
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/concurrent/background_task_storage.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/rcu/rcu.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/yaml_config/schema.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include "compression.hpp"
+#include "redis_pool.hpp"
+#include "response_cache.hpp"
+#include "single_flight.hpp"
+
+namespace news_aggregator::gateway {
+
+// kUpstream: the body was just loaded from StorageService, by this request or
+// by a concurrent one for the same key
+enum class CacheTier { kNone, kMemory, kRedis, kUpstream };
+
+struct CacheLookup {
+    ResponseCache::Body body;  // nullptr on a miss in both tiers
+    CacheTier tier = CacheTier::kNone;
+    // Older than the soft TTL; a background refresh has been started
+    bool stale = false;
+};
+
+// Two-tier cache of gateway responses: the in-process ResponseCache (L1) in
+// front of Redis (L2). Both hold the exact bytes sent to the client.
+//
+// Entries have a soft and a hard TTL. Past the soft one they are still served
+// while a background task reloads them; past the hard one they are gone. The
+// most requested keys are reloaded shortly before they turn stale at all.
+//
+// StorageService publishes an event after every committed insert batch, with
+// the categories it touched. The all-news snapshot and the snapshots of those
+// categories stored before it turn stale at once, so TTLs can be long while
+// responses follow inserts within a reload. An event without categories makes
+// every key stale. Events also carry the highest id inserted; loaders pass it
+// on (GetChangedUpTo), so the reload cannot come back without those rows from
+// a lagging replica and be cached as fresh.
+//
+// Compressed pages live in a separate in-process LRU. They are built once per
+// page and encoding by a background task, never on the request path.
+class NewsCache final : public components::LoggableComponentBase {
+public:
+    static constexpr std::string_view kName = "news-cache";
+
+    NewsCache(const components::ComponentConfig& config,
+              const components::ComponentContext& component_context);
+
+    ~NewsCache() override;
+
+    static yaml_config::Schema GetStaticConfigSchema();
+
+    // Key of the /news snapshot for `category`, empty for all news; change
+    // events stale these keys by category
+    static std::string GetSnapshotKey(std::string_view category);
+    // Highest row id a change event announced for the scope of `key`, 0 when
+    // none did; a load of the key must include the rows up to it
+    int64_t GetChangedUpTo(const std::string& key) const;
+
+    // L1 first; an L2 hit is copied into L1 with its remaining lifetime
+    CacheLookup Lookup(const std::string& key);
+    // Writes both tiers; `stored_at` is when the body was read from upstream
+    void Store(const std::string& key, const std::string& body, ResponseCache::TimePoint stored_at);
+
+    // std::nullopt when the upstream fails
+    using Loader = std::function<std::optional<std::string>()>;
+    // Lookup, and on a miss in both tiers a single-flight load that is stored
+    // before being shared with every caller waiting on the same key. A stale
+    // hit is returned at once and reloaded in the background with `loader`.
+    CacheLookup GetOrLoad(const std::string& key, const Loader& loader);
+
+    // `page_key` must change whenever the rendered page does
+    using PageRenderer = std::function<std::string()>;
+    // The page in `encoding`, or nullptr until it is built. The first call for a
+    // page starts building it in the background from `render`.
+    ResponseCache::Body GetCompressed(const std::string& page_key, ContentEncoding encoding, PageRenderer render);
+
+private:
+    void OnAllComponentsLoaded() override;
+    void OnAllComponentsAreStopping() override;
+
+    // Runs the loader and stores its result; nullptr on failure
+    ResponseCache::Body Load(const std::string& key, const Loader& loader);
+    // Background reload, skipped while one for the same key is running
+    void StartRefresh(const std::string& key, Loader loader);
+    // Kept so refresh-ahead can reload keys no request is currently missing
+    void RememberLoader(const std::string& key, const Loader& loader);
+    void StartRefreshAheadLoop();
+    // Starts reloads of the hottest keys that are stale or about to be
+    void RefreshHotKeys();
+    // RefreshHotKeys now, or on the next tick of the refresh-ahead loop if it
+    // ran less than a tick ago, so a burst of events scans the cache once
+    void RequestHotRefresh();
+    void StartChangeSubscription();
+    void OnChange(const std::string& payload);
+    // Entries of `key` stored before this are stale
+    ResponseCache::TimePoint GetFreshAfter(const std::string& key, ResponseCache::TimePoint now) const;
+
+    std::unique_ptr<ResponseCache> memory_;
+    RedisPool& redis_pool_;
+    std::chrono::seconds soft_ttl_{30};
+    std::chrono::seconds hard_ttl_{300};
+    SingleFlight loads_;
+    // How long a request waits for a load started by another one
+    std::chrono::milliseconds load_timeout_{10000};
+
+    engine::TaskProcessor& fs_task_processor_;
+    size_t refresh_ahead_top_k_ = 32;
+    std::chrono::seconds refresh_ahead_lead_{5};
+    engine::Mutex refresh_mutex_;
+    std::unordered_set<std::string> refreshing_;
+    std::unordered_map<std::string, Loader> loaders_;
+    engine::TaskWithResult<void> refresh_ahead_task_;
+    std::atomic<bool> should_stop_{false};
+
+    bool compression_enabled_ = true;
+    CompressionLevels compression_levels_;
+    std::unique_ptr<ResponseCache> compressed_;
+    std::unordered_set<std::string> compressing_;
+
+    bool invalidation_enabled_ = false;
+    std::string invalidation_channel_ = "news:changes";
+    // Soft TTL while the subscription is down and events may be missed
+    std::chrono::seconds fallback_soft_ttl_{30};
+    std::atomic<bool> subscribed_{false};
+    // steady_clock times in native ticks: of the latest change event, which
+    // stales the all-news snapshot; of the latest one that may have touched
+    // any category; and of the latest one per category. Each comes with the
+    // highest id announced in that scope.
+    using ChangeTime = ResponseCache::TimePoint::rep;
+    struct CategoryChange {
+        ChangeTime time = 0;
+        int64_t max_id = 0;
+    };
+    std::atomic<ChangeTime> last_change_{0};
+    std::atomic<int64_t> last_max_id_{0};
+    std::atomic<ChangeTime> everything_changed_{0};
+    std::atomic<int64_t> everything_max_id_{0};
+    rcu::Variable<std::unordered_map<std::string, CategoryChange>> category_changes_;
+    std::atomic<ChangeTime> last_hot_refresh_{0};
+    std::atomic<bool> hot_refresh_pending_{false};
+    engine::TaskWithResult<void> subscription_task_;
+
+    std::atomic<uint64_t> redis_hits_{0};
+    std::atomic<uint64_t> redis_stale_hits_{0};
+    std::atomic<uint64_t> redis_misses_{0};
+    std::atomic<uint64_t> redis_unavailable_{0};
+    std::atomic<uint64_t> refreshes_{0};
+    std::atomic<uint64_t> refreshes_ahead_{0};
+    std::atomic<uint64_t> failed_refreshes_{0};
+    std::atomic<uint64_t> change_events_{0};
+    std::atomic<uint64_t> compressions_{0};
+    std::atomic<uint64_t> failed_compressions_{0};
+    // Sizes of the pages compressed so far, before and after
+    std::atomic<uint64_t> compression_input_bytes_{0};
+    std::atomic<uint64_t> compression_output_bytes_{0};
+    utils::statistics::Entry statistics_holder_;
+    // Declared last so refreshes stop before anything they use is destroyed
+    concurrent::BackgroundTaskStorage refresh_tasks_;
+};
+
+} // namespace news_aggregator::gateway
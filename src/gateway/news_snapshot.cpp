@@ -0,0 +1,194 @@
+#include "news_snapshot.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// The JSON listing carries no ids the gateway could fold without parsing it,
+// so its snapshots are versioned by their item bytes: FNV-1a over 8-byte
+// words, folding each product so high bits reach the low ones
+uint64_t HashItems(const std::vector<std::string_view>& items, size_t count) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < count; ++i) {
+        const auto bytes = items[i];
+        size_t pos = 0;
+        for (; pos + sizeof(uint64_t) <= bytes.size(); pos += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + pos, sizeof(word));
+            hash ^= word;
+            hash *= 1099511628211ULL;
+            hash ^= hash >> 32;
+        }
+        for (; pos < bytes.size(); ++pos) {
+            hash ^= static_cast<unsigned char>(bytes[pos]);
+            hash *= 1099511628211ULL;
+        }
+        // Item boundaries count: ["ab","c"] and ["a","bc"] differ
+        hash ^= bytes.size();
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool IsJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+size_t SkipSpace(std::string_view json, size_t pos) {
+    while (pos < json.size() && IsJsonSpace(json[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Returns the position just past the JSON value starting at `pos`, or npos when
+// it is cut off. Only the structure is checked; the bytes are copied verbatim.
+size_t SkipValue(std::string_view json, size_t pos) {
+    if (pos >= json.size()) {
+        return std::string_view::npos;
+    }
+    if (json[pos] != '"' && json[pos] != '{' && json[pos] != '[') {
+        while (pos < json.size() && json[pos] != ',' && json[pos] != '}' && json[pos] != ']' &&
+               !IsJsonSpace(json[pos])) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    size_t depth = 0;
+    bool in_string = false;
+    for (; pos < json.size(); ++pos) {
+        const char c = json[pos];
+        if (in_string) {
+            if (c == '\\') {
+                ++pos;
+            } else if (c == '"') {
+                in_string = false;
+                if (depth == 0) {
+                    return pos + 1;
+                }
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) {
+                return std::string_view::npos;
+            }
+            if (--depth == 0) {
+                return pos + 1;
+            }
+        }
+    }
+    return std::string_view::npos;
+}
+
+struct StorageListing {
+    std::string_view status;
+    std::string_view timestamp;
+    std::vector<std::string_view> items;
+};
+
+// Splits the top level of a /news/latest response without building a DOM.
+// std::nullopt when it is not an object with a "news" array.
+std::optional<StorageListing> ScanListing(std::string_view json) {
+    StorageListing listing;
+    bool has_news = false;
+    size_t pos = SkipSpace(json, 0);
+    if (pos >= json.size() || json[pos] != '{') {
+        return std::nullopt;
+    }
+    pos = SkipSpace(json, pos + 1);
+    while (pos < json.size() && json[pos] != '}') {
+        const auto key_end = SkipValue(json, pos);
+        if (json[pos] != '"' || key_end == std::string_view::npos) {
+            return std::nullopt;
+        }
+        const auto key = json.substr(pos + 1, key_end - pos - 2);
+        pos = SkipSpace(json, key_end);
+        if (pos >= json.size() || json[pos] != ':') {
+            return std::nullopt;
+        }
+        pos = SkipSpace(json, pos + 1);
+        const auto value_end = SkipValue(json, pos);
+        if (value_end == std::string_view::npos || value_end == pos) {
+            return std::nullopt;
+        }
+        const auto value = json.substr(pos, value_end - pos);
+
+        if (key == "status") {
+            listing.status = value;
+        } else if (key == "timestamp") {
+            listing.timestamp = value;
+        } else if (key == "news") {
+            if (value.front() != '[') {
+                return std::nullopt;
+            }
+            has_news = true;
+            size_t item = SkipSpace(value, 1);
+            while (item < value.size() - 1) {
+                const auto item_end = SkipValue(value, item);
+                if (item_end == std::string_view::npos || item_end == item) {
+                    return std::nullopt;
+                }
+                listing.items.push_back(value.substr(item, item_end - item));
+                item = SkipSpace(value, item_end);
+                if (item < value.size() - 1 && value[item] == ',') {
+                    item = SkipSpace(value, item + 1);
+                }
+            }
+        }
+
+        pos = SkipSpace(json, value_end);
+        if (pos < json.size() && json[pos] == ',') {
+            pos = SkipSpace(json, pos + 1);
+        }
+    }
+    if (pos >= json.size() || !has_news) {
+        return std::nullopt;
+    }
+    return listing;
+}
+
+}  // namespace
+
+std::optional<std::string> BuildNewsSnapshot(std::string_view storage_body) {
+    const auto listing = ScanListing(storage_body);
+    if (!listing || listing->status != "\"success\"") {
+        LOG_ERROR() << "Unexpected StorageService listing: " << storage_body.substr(0, 200);
+        return std::nullopt;
+    }
+
+    const auto count = std::min(listing->items.size(), common::kSnapshotItems);
+    return common::EncodeNewsSnapshot(HashItems(listing->items, count),
+                                      std::strtoll(std::string(listing->timestamp).c_str(), nullptr, 10),
+                                      listing->items);
+}
+
+std::string RenderNewsPage(const common::NewsSnapshotView& snapshot, int limit, std::string_view cache_status) {
+    const auto count = std::min(static_cast<size_t>(std::max(limit, 0)), snapshot.GetItemCount());
+    const auto items = snapshot.GetItems(count);
+
+    std::string body;
+    body.reserve(items.size() + 320);
+    body += "{\"status\":\"success\",\"count\":";
+    body += std::to_string(count);
+    body += ",\"limit\":";
+    body += std::to_string(limit);
+    body += ",\"timestamp\":";
+    body += std::to_string(snapshot.GetTimestampMs());
+    body += ",\"message\":\"Latest news from StorageService\",\"source\":\"PostgreSQL Database\",\"news\":[";
+    body += items;
+    body += "],\"gateway_info\":\"API Gateway successfully integrated with StorageService\",\"cache_status\":\"";
+    body += cache_status;
+    body += "\"}";
+    return body;
+}
+
+} // namespace news_aggregator::gateway
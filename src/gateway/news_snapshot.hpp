@@ -0,0 +1,19 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include "../common/news_snapshot.hpp"
+
+namespace news_aggregator::gateway {
+
+// Builds the cached snapshot from a StorageService /news/latest response: the
+// item bytes are copied as StorageService serialized them, followed by a table
+// of where each ends, so a page of any size is a prefix of them. std::nullopt
+// when the response is not a successful listing.
+std::optional<std::string> BuildNewsSnapshot(std::string_view storage_body);
+
+// The /news response for the first `limit` items of the snapshot
+std::string RenderNewsPage(const common::NewsSnapshotView& snapshot, int limit, std::string_view cache_status);
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,116 @@
+#include "redis_component.hpp"
+
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+namespace news_aggregator::gateway {
+
+RedisComponent::RedisComponent(const components::ComponentConfig& config,
+                               const components::ComponentContext& component_context)
+    : LoggableComponentBase(config, component_context),
+      fs_task_processor_(component_context.GetTaskProcessor(
+          config["fs-task-processor"].As<std::string>("fs-task-processor"))) {
+    RedisPoolConfig pool_config;
+    pool_config.host = config["host"].As<std::string>(pool_config.host);
+    pool_config.port = config["port"].As<int>(pool_config.port);
+    pool_config.size = config["pool_size"].As<size_t>(pool_config.size);
+    pool_config.timeout = std::chrono::milliseconds(config["timeout_ms"].As<int>(pool_config.timeout.count()));
+    pool_config.acquire_timeout =
+        std::chrono::milliseconds(config["acquire_timeout_ms"].As<int>(pool_config.acquire_timeout.count()));
+    pool_config.reconnect_backoff =
+        std::chrono::milliseconds(config["reconnect_backoff_ms"].As<int>(pool_config.reconnect_backoff.count()));
+    health_check_interval_ =
+        config["health_check_interval_seconds"].As<std::chrono::seconds>(health_check_interval_);
+
+    pool_ = std::make_unique<RedisPool>(pool_config);
+    // Redis being down is not fatal: the gateway serves uncached until it is back
+    pool_->ConnectAll();
+
+    statistics_holder_ = component_context.FindComponent<components::StatisticsStorage>()
+                             .GetStorage()
+                             .RegisterWriter("redis-pool", [this](utils::statistics::Writer& writer) {
+                                 const auto stats = pool_->GetStats();
+                                 writer["size"] = stats.size;
+                                 writer["idle"] = stats.idle;
+                                 writer["connected"] = stats.connected;
+                                 writer["acquired"] = stats.acquired;
+                                 writer["acquire_timeouts"] = stats.acquire_timeouts;
+                                 writer["connect_attempts"] = stats.connect_attempts;
+                                 writer["failed_checks"] = stats.failed_checks;
+                             });
+
+    LOG_INFO() << "Redis pool of " << pool_config.size << " connections to " << pool_config.host << ":"
+               << pool_config.port;
+}
+
+RedisComponent::~RedisComponent() {
+    statistics_holder_.Unregister();
+}
+
+void RedisComponent::OnAllComponentsLoaded() {
+    health_check_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        while (!should_stop_) {
+            for (int i = 0; i < health_check_interval_.count() && !should_stop_; ++i) {
+                engine::SleepFor(std::chrono::seconds(1));
+            }
+            if (should_stop_) {
+                break;
+            }
+            pool_->CheckConnections();
+        }
+    });
+}
+
+void RedisComponent::OnAllComponentsAreStopping() {
+    should_stop_ = true;
+    if (health_check_task_.IsValid()) {
+        health_check_task_.Wait();
+    }
+}
+
+yaml_config::Schema RedisComponent::GetStaticConfigSchema() {
+    return yaml_config::MergeSchemas<components::LoggableComponentBase>(R"(
+type: object
+description: Redis connection pool of the API gateway
+additionalProperties: false
+properties:
+    host:
+        type: string
+        description: Redis host
+        defaultDescription: localhost
+    port:
+        type: integer
+        description: Redis port
+        defaultDescription: 6379
+    pool_size:
+        type: integer
+        description: number of persistent connections
+        defaultDescription: 8
+    timeout_ms:
+        type: integer
+        description: connect and per-command timeout
+        defaultDescription: 200
+    acquire_timeout_ms:
+        type: integer
+        description: how long a request waits for a free connection before skipping the cache
+        defaultDescription: 50
+    reconnect_backoff_ms:
+        type: integer
+        description: minimum delay between connect attempts on one connection
+        defaultDescription: 1000
+    health_check_interval_seconds:
+        type: integer
+        description: how often idle connections are PINGed and broken ones reopened
+        defaultDescription: 5
+    fs-task-processor:
+        type: string
+        description: task processor for the blocking health checks
+        defaultDescription: fs-task-processor
+)");
+}
+
+} // namespace news_aggregator::gateway
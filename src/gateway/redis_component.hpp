@@ -0,0 +1,45 @@
+#pragma once
+
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/yaml_config/schema.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "redis_pool.hpp"
+
+namespace news_aggregator::gateway {
+
+// Gateway-wide Redis connection pool. Connections are opened at startup, kept
+// open across requests and health-checked in the background.
+class RedisComponent final : public components::LoggableComponentBase {
+public:
+    static constexpr std::string_view kName = "redis-pool";
+
+    RedisComponent(const components::ComponentConfig& config,
+                   const components::ComponentContext& component_context);
+
+    ~RedisComponent() override;
+
+    static yaml_config::Schema GetStaticConfigSchema();
+
+    RedisPool& GetPool() { return *pool_; }
+
+private:
+    void OnAllComponentsLoaded() override;
+    void OnAllComponentsAreStopping() override;
+
+    std::unique_ptr<RedisPool> pool_;
+    engine::TaskProcessor& fs_task_processor_;
+    std::chrono::seconds health_check_interval_{5};
+    engine::TaskWithResult<void> health_check_task_;
+    std::atomic<bool> should_stop_{false};
+    utils::statistics::Entry statistics_holder_;
+};
+
+} // namespace news_aggregator::gateway
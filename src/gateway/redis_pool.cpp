@@ -0,0 +1,137 @@
+#include "redis_pool.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace news_aggregator::gateway {
+
+RedisPool::Connection::Connection(RedisPool& pool, size_t index) : pool_(&pool), index_(index) {
+}
+
+RedisPool::Connection::Connection(Connection&& other) noexcept : pool_(other.pool_), index_(other.index_) {
+    other.pool_ = nullptr;
+}
+
+RedisPool::Connection::~Connection() {
+    if (pool_) {
+        pool_->Release(index_);
+    }
+}
+
+common::RedisClient* RedisPool::Connection::operator->() const {
+    return pool_->slots_[index_].client.get();
+}
+
+common::RedisClient& RedisPool::Connection::operator*() const {
+    return *pool_->slots_[index_].client;
+}
+
+RedisPool::RedisPool(RedisPoolConfig config) : config_(std::move(config)) {
+    const size_t size = std::max<size_t>(1, config_.size);
+    slots_.resize(size);
+    idle_.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        slots_[i].client = std::make_unique<common::RedisClient>(config_.host, config_.port,
+                                                         static_cast<int>(config_.timeout.count()));
+        idle_.push_back(i);
+    }
+}
+
+void RedisPool::ConnectAll() {
+    for (auto& slot : slots_) {
+        EnsureConnected(slot);
+    }
+}
+
+std::optional<RedisPool::Connection> RedisPool::Acquire() {
+    size_t index = 0;
+    {
+        std::unique_lock<engine::Mutex> lock(mutex_);
+        if (!released_.WaitFor(lock, config_.acquire_timeout, [this] { return !idle_.empty(); })) {
+            ++acquire_timeouts_;
+            return std::nullopt;
+        }
+        // Most recently released first: keeps hot connections hot
+        index = idle_.back();
+        idle_.pop_back();
+    }
+
+    Connection connection(*this, index);
+    if (!EnsureConnected(slots_[index])) {
+        return std::nullopt;
+    }
+    ++acquired_;
+    return connection;
+}
+
+void RedisPool::CheckConnections() {
+    // Only idle connections are checked, one at a time so requests never wait
+    // behind the whole round; busy ones prove themselves on use
+    for (size_t index = 0; index < slots_.size(); ++index) {
+        {
+            std::lock_guard<engine::Mutex> lock(mutex_);
+            const auto it = std::find(idle_.begin(), idle_.end(), index);
+            if (it == idle_.end()) {
+                continue;
+            }
+            idle_.erase(it);
+        }
+
+        auto& slot = slots_[index];
+        if (slot.client->IsConnected() && !slot.client->Ping()) {
+            ++failed_checks_;
+            LOG_WARNING() << "Redis connection " << index << " failed the health check";
+        }
+        EnsureConnected(slot);
+
+        {
+            std::lock_guard<engine::Mutex> lock(mutex_);
+            // Back at the cold end, since it was sitting idle
+            idle_.insert(idle_.begin(), index);
+        }
+        released_.NotifyOne();
+    }
+}
+
+RedisPoolStats RedisPool::GetStats() const {
+    RedisPoolStats stats;
+    stats.size = slots_.size();
+    {
+        std::lock_guard<engine::Mutex> lock(mutex_);
+        stats.idle = idle_.size();
+    }
+    for (const auto& slot : slots_) {
+        // Racy for borrowed slots, which is fine for monitoring
+        stats.connected += slot.client->IsConnected() ? 1 : 0;
+    }
+    stats.acquired = acquired_.load();
+    stats.acquire_timeouts = acquire_timeouts_.load();
+    stats.connect_attempts = connect_attempts_.load();
+    stats.failed_checks = failed_checks_.load();
+    return stats;
+}
+
+bool RedisPool::EnsureConnected(Slot& slot) {
+    if (slot.client->IsConnected()) {
+        return true;
+    }
+
+    // While Redis is down, requests skip the cache instead of each paying the connect timeout
+    const auto now = std::chrono::steady_clock::now();
+    if (now - slot.last_connect_attempt < config_.reconnect_backoff) {
+        return false;
+    }
+    slot.last_connect_attempt = now;
+    ++connect_attempts_;
+    return slot.client->Connect();
+}
+
+void RedisPool::Release(size_t index) {
+    {
+        std::lock_guard<engine::Mutex> lock(mutex_);
+        idle_.push_back(index);
+    }
+    released_.NotifyOne();
+}
+
+} // namespace news_aggregator::gateway
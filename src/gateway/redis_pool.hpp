@@ -0,0 +1,98 @@
+#pragma once
+
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../common/redis_client.hpp"
+
+namespace news_aggregator::gateway {
+
+struct RedisPoolConfig {
+    std::string host = "localhost";
+    int port = 6379;
+    size_t size = 8;
+    // Bounds connect and every command on a pooled connection
+    std::chrono::milliseconds timeout{200};
+    // How long a request waits for a free connection before going without cache
+    std::chrono::milliseconds acquire_timeout{50};
+    // Minimum delay between two connect attempts on the same slot
+    std::chrono::milliseconds reconnect_backoff{1000};
+};
+
+struct RedisPoolStats {
+    size_t size = 0;
+    size_t idle = 0;
+    size_t connected = 0;
+    uint64_t acquired = 0;
+    uint64_t acquire_timeouts = 0;
+    uint64_t connect_attempts = 0;
+    uint64_t failed_checks = 0;
+};
+
+// Fixed set of persistent Redis connections shared by all handlers. A request
+// borrows one for its whole cache lookup, so a cache hit costs one round trip
+// instead of a TCP connect plus the command.
+class RedisPool {
+public:
+    // Returns the connection to the pool when destroyed
+    class Connection {
+    public:
+        Connection(RedisPool& pool, size_t index);
+        Connection(Connection&& other) noexcept;
+        Connection& operator=(Connection&&) = delete;
+        ~Connection();
+
+        common::RedisClient* operator->() const;
+        common::RedisClient& operator*() const;
+
+    private:
+        RedisPool* pool_;
+        size_t index_;
+    };
+
+    explicit RedisPool(RedisPoolConfig config);
+
+    // Opens every connection; the ones that fail are retried lazily
+    void ConnectAll();
+
+    // std::nullopt when every connection is busy for longer than acquire_timeout
+    // or the borrowed one cannot be (re)connected; callers then skip the cache
+    std::optional<Connection> Acquire();
+
+    // PINGs idle connections one by one and reconnects broken ones. Blocking.
+    void CheckConnections();
+
+    RedisPoolStats GetStats() const;
+    const RedisPoolConfig& GetConfig() const { return config_; }
+
+private:
+    struct Slot {
+        std::unique_ptr<common::RedisClient> client;
+        std::chrono::steady_clock::time_point last_connect_attempt{};
+    };
+
+    // Connects the slot unless the previous attempt was too recent
+    bool EnsureConnected(Slot& slot);
+    void Release(size_t index);
+
+    const RedisPoolConfig config_;
+    std::vector<Slot> slots_;
+
+    mutable engine::Mutex mutex_;
+    engine::ConditionVariable released_;
+    std::vector<size_t> idle_;
+
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> acquire_timeouts_{0};
+    std::atomic<uint64_t> connect_attempts_{0};
+    std::atomic<uint64_t> failed_checks_{0};
+};
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,144 @@
+#include "response_cache.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// Approximate overhead of a list node, a hash node and the shared body
+constexpr size_t kEntryOverhead = 128;
+
+// A single hit halves away within a few decays; colder keys are not ranked
+constexpr double kMinHeat = 0.1;
+
+}  // namespace
+
+ResponseCache::ResponseCache(ResponseCacheConfig config)
+    : config_(config),
+      shard_max_bytes_(config.max_bytes / std::max<size_t>(1, config.shards)) {
+    shards_.reserve(std::max<size_t>(1, config_.shards));
+    for (size_t i = 0; i < std::max<size_t>(1, config_.shards); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+ResponseCache::Cached ResponseCache::Get(const std::string& key, TimePoint fresh_after) {
+    auto& shard = GetShard(key);
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<engine::Mutex> lock(shard.mutex);
+    const auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        ++misses_;
+        return {};
+    }
+    auto& entry = *found->second;
+    if (entry.expires_at <= now) {
+        Remove(shard, found->second);
+        ++expired_;
+        ++misses_;
+        return {};
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    ++entry.hits;
+    ++hits_;
+    const bool stale = entry.stored_at < fresh_after;
+    if (stale) {
+        ++stale_hits_;
+    }
+    return {entry.body, stale};
+}
+
+void ResponseCache::Put(const std::string& key, Body body, TimePoint stored_at, TimePoint expires_at) {
+    const size_t bytes = key.size() * 2 + body->size() + kEntryOverhead;
+    if (bytes > shard_max_bytes_) {
+        return;
+    }
+    auto& shard = GetShard(key);
+
+    std::lock_guard<engine::Mutex> lock(shard.mutex);
+    uint64_t hits = 0;
+    double heat = 0;
+    if (const auto found = shard.index.find(key); found != shard.index.end()) {
+        // A refreshed key stays as hot as it was
+        hits = found->second->hits;
+        heat = found->second->heat;
+        Remove(shard, found->second);
+    }
+    while (shard.bytes + bytes > shard_max_bytes_ && !shard.lru.empty()) {
+        Remove(shard, std::prev(shard.lru.end()));
+        ++evictions_;
+    }
+    shard.lru.push_front(Entry{key, std::move(body), stored_at, expires_at, bytes, hits, heat});
+    shard.index.emplace(key, shard.lru.begin());
+    shard.bytes += bytes;
+}
+
+void ResponseCache::Erase(const std::string& key) {
+    auto& shard = GetShard(key);
+    std::lock_guard<engine::Mutex> lock(shard.mutex);
+    if (const auto found = shard.index.find(key); found != shard.index.end()) {
+        Remove(shard, found->second);
+    }
+}
+
+std::vector<ResponseCache::HotKey> ResponseCache::GetHottest(size_t limit) const {
+    std::vector<HotKey> hottest;
+    for (const auto& shard : shards_) {
+        std::lock_guard<engine::Mutex> lock(shard->mutex);
+        for (const auto& entry : shard->lru) {
+            const double heat = entry.heat + static_cast<double>(entry.hits);
+            if (heat >= kMinHeat) {
+                hottest.push_back(HotKey{entry.key, heat, entry.stored_at});
+            }
+        }
+    }
+
+    const auto by_heat = [](const HotKey& lhs, const HotKey& rhs) { return lhs.heat > rhs.heat; };
+    if (hottest.size() > limit) {
+        std::partial_sort(hottest.begin(), hottest.begin() + limit, hottest.end(), by_heat);
+        hottest.resize(limit);
+    } else {
+        std::sort(hottest.begin(), hottest.end(), by_heat);
+    }
+    return hottest;
+}
+
+void ResponseCache::DecayHeat() {
+    for (const auto& shard : shards_) {
+        std::lock_guard<engine::Mutex> lock(shard->mutex);
+        for (auto& entry : shard->lru) {
+            entry.heat = entry.heat / 2 + static_cast<double>(entry.hits);
+            entry.hits = 0;
+        }
+    }
+}
+
+ResponseCacheStats ResponseCache::GetStats() const {
+    ResponseCacheStats stats;
+    for (const auto& shard : shards_) {
+        std::lock_guard<engine::Mutex> lock(shard->mutex);
+        stats.entries += shard->index.size();
+        stats.bytes += shard->bytes;
+    }
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    stats.stale_hits = stale_hits_.load();
+    stats.expired = expired_.load();
+    stats.evictions = evictions_.load();
+    return stats;
+}
+
+ResponseCache::Shard& ResponseCache::GetShard(const std::string& key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+void ResponseCache::Remove(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->key);
+    shard.lru.erase(it);
+}
+
+} // namespace news_aggregator::gateway
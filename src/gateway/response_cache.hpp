@@ -0,0 +1,104 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace news_aggregator::gateway {
+
+struct ResponseCacheConfig {
+    size_t shards = 16;
+    // Keys, bodies and bookkeeping of all shards together
+    size_t max_bytes = 64 * 1024 * 1024;
+};
+
+struct ResponseCacheStats {
+    size_t entries = 0;
+    size_t bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stale_hits = 0;
+    uint64_t expired = 0;
+    uint64_t evictions = 0;
+};
+
+// In-process L1 in front of Redis holding ready-to-send response bodies.
+// Keys are spread over independently locked LRU shards, each with its own
+// share of the byte budget; a lookup only touches one shard.
+class ResponseCache {
+public:
+    using Body = std::shared_ptr<const std::string>;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Cached {
+        Body body;  // nullptr on a miss or past the hard expiry
+        // Stored before `fresh_after`: still served, but due for a refresh
+        bool stale = false;
+    };
+
+    struct HotKey {
+        std::string key;
+        double heat = 0;
+        TimePoint stored_at;
+    };
+
+    explicit ResponseCache(ResponseCacheConfig config);
+
+    // Staleness is decided by the caller, so a soft TTL change or an
+    // invalidation applies to every entry at once without touching them
+    Cached Get(const std::string& key, TimePoint fresh_after);
+    // `stored_at` is when the body was read from upstream
+    void Put(const std::string& key, Body body, TimePoint stored_at, TimePoint expires_at);
+    void Erase(const std::string& key);
+
+    // The `limit` keys with the most heat, hottest first. Read-only, so it may
+    // be called as often as needed without skewing the ranking.
+    std::vector<HotKey> GetHottest(size_t limit) const;
+    // Ages the heat of every entry: hits since the previous call count fully,
+    // older ones half as much per call. Call at a fixed period.
+    void DecayHeat();
+
+    ResponseCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        Body body;
+        TimePoint stored_at;
+        TimePoint expires_at;
+        size_t bytes = 0;
+        uint64_t hits = 0;  // since the last DecayHeat
+        double heat = 0;    // decayed hits before that
+    };
+
+    // Most recently used at the front
+    struct Shard {
+        mutable engine::Mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    Shard& GetShard(const std::string& key);
+    // Caller holds the shard lock
+    void Remove(Shard& shard, std::list<Entry>::iterator it);
+
+    const ResponseCacheConfig config_;
+    const size_t shard_max_bytes_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stale_hits_{0};
+    std::atomic<uint64_t> expired_{0};
+    std::atomic<uint64_t> evictions_{0};
+};
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,75 @@
+#include "single_flight.hpp"
+#include <userver/utils/scope_guard.hpp>
+#include <mutex>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// A caller joins at most this many failed loads before giving up, so a
+// failing upstream is not hit once per waiter
+constexpr int kMaxAttempts = 2;
+
+}  // namespace
+
+SingleFlight::Body SingleFlight::Run(const std::string& key, std::chrono::steady_clock::time_point deadline,
+                                     const Loader& loader) {
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+        std::unique_lock<engine::Mutex> lock(mutex_);
+        const auto found = flights_.find(key);
+        if (found != flights_.end()) {
+            const auto flight = found->second;
+            const auto remaining = deadline - std::chrono::steady_clock::now();
+            if (remaining <= std::chrono::steady_clock::duration::zero() ||
+                !flight->finished.WaitFor(lock, std::chrono::duration_cast<std::chrono::milliseconds>(remaining),
+                                   [&flight] { return flight->done; })) {
+                ++timeouts_;
+                return nullptr;
+            }
+            if (flight->result) {
+                ++coalesced_;
+                return flight->result;
+            }
+            // The leader failed: retry, leading the next load if nobody else has yet
+            continue;
+        }
+
+        const auto flight = std::make_shared<Flight>();
+        flights_.emplace(key, flight);
+        lock.unlock();
+
+        ++loads_;
+        Body result;
+        // Waiters are released and the key freed however the loader exits,
+        // cancellation and exceptions not derived from std::exception included
+        utils::ScopeGuard complete([this, &lock, &key, &flight, &result] {
+            lock.lock();
+            flight->done = true;
+            flight->result = result;
+            flights_.erase(key);
+            lock.unlock();
+            flight->finished.NotifyAll();
+        });
+        try {
+            result = loader();
+        } catch (const std::exception&) {
+            result = nullptr;
+        }
+        if (!result) {
+            ++failed_loads_;
+        }
+        return result;
+    }
+    return nullptr;
+}
+
+SingleFlightStats SingleFlight::GetStats() const {
+    SingleFlightStats stats;
+    stats.loads = loads_.load();
+    stats.coalesced = coalesced_.load();
+    stats.failed_loads = failed_loads_.load();
+    stats.timeouts = timeouts_.load();
+    return stats;
+}
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace news_aggregator::gateway {
+
+struct SingleFlightStats {
+    uint64_t loads = 0;          // calls that ran the loader themselves
+    uint64_t coalesced = 0;      // calls answered by another caller's load
+    uint64_t failed_loads = 0;
+    uint64_t timeouts = 0;
+};
+
+// Collapses concurrent loads of the same key into one. The first caller runs
+// the loader; later callers wait for its result until their own deadline. When
+// that load fails, one of the waiters takes over instead of all of them failing.
+class SingleFlight {
+public:
+    using Body = std::shared_ptr<const std::string>;
+    // nullptr on failure
+    using Loader = std::function<Body()>;
+
+    // nullptr when the load failed or the deadline passed first
+    Body Run(const std::string& key, std::chrono::steady_clock::time_point deadline, const Loader& loader);
+
+    SingleFlightStats GetStats() const;
+
+private:
+    // Guarded by mutex_
+    struct Flight {
+        bool done = false;
+        Body result;
+        engine::ConditionVariable finished;
+    };
+
+    engine::Mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+
+    std::atomic<uint64_t> loads_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> failed_loads_{0};
+    std::atomic<uint64_t> timeouts_{0};
+};
+
+} // namespace news_aggregator::gateway
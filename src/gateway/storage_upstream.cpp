@@ -0,0 +1,303 @@
+#include "storage_upstream.hpp"
+
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/scope_guard.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// Hedge tokens a quiet period can bank, i.e. the largest burst of hedges
+constexpr double kMaxHedgeTokens = 10.0;
+
+int GetBreakerStateCode(BreakerState state) {
+    switch (state) {
+        case BreakerState::kClosed:
+            return 0;
+        case BreakerState::kOpen:
+            return 1;
+        case BreakerState::kHalfOpen:
+            return 2;
+    }
+    return 0;
+}
+
+}  // namespace
+
+// One Get: the attempts in flight and the first successful answer
+struct StorageUpstream::Call {
+    engine::Mutex mutex;
+    engine::ConditionVariable finished;
+    size_t pending = 0;
+    std::optional<HttpResponse> success;
+    std::optional<HttpResponse> failure;
+    bool hedge_won = false;
+    // Set once the caller stops waiting; aborts the attempts still running
+    std::atomic<bool> cancelled{false};
+};
+
+StorageUpstream::StorageUpstream(const components::ComponentConfig& config,
+                                 const components::ComponentContext& component_context)
+    : LoggableComponentBase(config, component_context),
+      fs_task_processor_(component_context.GetTaskProcessor(
+          config["fs-task-processor"].As<std::string>("fs-task-processor"))),
+      attempts_(fs_task_processor_) {
+    // Not thread-safe, so done once here before any request
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    UpstreamPoolConfig pool_config;
+    pool_config.endpoints =
+        config["endpoints"].As<std::vector<std::string>>(std::vector<std::string>{"http://localhost:8080"});
+    pool_config.idle_per_endpoint = config["idle_per_endpoint"].As<size_t>(pool_config.idle_per_endpoint);
+    pool_config.timeout = std::chrono::milliseconds(config["timeout_ms"].As<int>(pool_config.timeout.count()));
+    pool_config.connect_timeout =
+        std::chrono::milliseconds(config["connect_timeout_ms"].As<int>(pool_config.connect_timeout.count()));
+    const auto breaker_config = config["circuit_breaker"];
+    pool_config.failure_threshold =
+        std::max<size_t>(1, breaker_config["failure_threshold"].As<size_t>(pool_config.failure_threshold));
+    pool_config.open_duration =
+        std::chrono::milliseconds(breaker_config["open_ms"].As<int>(pool_config.open_duration.count()));
+    const auto hedging_config = config["hedging"];
+    hedging_enabled_ = hedging_config["enabled"].As<bool>(hedging_enabled_);
+    hedge_percentile_ = std::clamp(hedging_config["percentile"].As<double>(hedge_percentile_), 50.0, 99.9);
+    hedge_min_delay_ =
+        std::chrono::milliseconds(hedging_config["min_delay_ms"].As<int>(hedge_min_delay_.count()));
+    hedge_max_delay_ = std::max(
+        hedge_min_delay_, std::chrono::milliseconds(hedging_config["max_delay_ms"].As<int>(hedge_max_delay_.count())));
+    hedge_max_ratio_ = std::clamp(hedging_config["max_ratio"].As<double>(hedge_max_ratio_), 0.0, 1.0);
+
+    if (pool_config.endpoints.empty()) {
+        throw std::runtime_error("storage-upstream needs at least one endpoint");
+    }
+    pool_ = std::make_unique<UpstreamPool>(pool_config);
+
+    statistics_holder_ = component_context.FindComponent<components::StatisticsStorage>()
+                             .GetStorage()
+                             .RegisterWriter("storage-upstream", [this](utils::statistics::Writer& writer) {
+                                 writer["requests"] = requests_.load();
+                                 writer["rejected"] = rejected_.load();
+                                 writer["failed"] = failed_.load();
+                                 writer["hedges"] = hedges_.load();
+                                 writer["hedge_wins"] = hedge_wins_.load();
+                                 const auto percentile = pool_->GetLatencyPercentile(hedge_percentile_);
+                                 writer["hedge_delay_ms"] = GetHedgeDelay().count();
+                                 writer["latency_percentile_ms"] = percentile ? percentile->count() : 0;
+                                 const auto endpoints = pool_->GetStats();
+                                 for (size_t i = 0; i < endpoints.size(); ++i) {
+                                     auto endpoint_writer = writer["endpoints"][std::to_string(i)];
+                                     endpoint_writer["breaker_state"] = GetBreakerStateCode(endpoints[i].state);
+                                     endpoint_writer["in_flight"] = endpoints[i].in_flight;
+                                     endpoint_writer["idle_connections"] = endpoints[i].idle;
+                                     endpoint_writer["requests"] = endpoints[i].requests;
+                                     endpoint_writer["failures"] = endpoints[i].failures;
+                                     endpoint_writer["breaker_opens"] = endpoints[i].opens;
+                                 }
+                             });
+
+    LOG_INFO() << "Storage upstream: " << pool_config.endpoints.size() << " endpoints, timeout "
+               << pool_config.timeout.count() << "ms, hedging "
+               << (hedging_enabled_ ? "at p" + std::to_string(static_cast<int>(hedge_percentile_))
+                                    : std::string("disabled"));
+}
+
+StorageUpstream::~StorageUpstream() {
+    statistics_holder_.Unregister();
+}
+
+void StorageUpstream::OnAllComponentsAreStopping() {
+    attempts_.CancelAndWait();
+}
+
+HttpResponse StorageUpstream::Get(const std::string& path) {
+    ++requests_;
+    {
+        std::lock_guard<engine::Mutex> lock(hedge_tokens_mutex_);
+        hedge_tokens_ = std::min(kMaxHedgeTokens, hedge_tokens_ + hedge_max_ratio_);
+    }
+
+    const auto primary = pool_->Pick();
+    if (!primary) {
+        ++rejected_;
+        LOG_WARNING() << "Every StorageService circuit breaker is open, failing " << path << " fast";
+        return {false, 503, {}, {}};
+    }
+
+    auto call = std::make_shared<Call>();
+    StartAttempt(call, *primary, path, false);
+    // Every attempt gives up by then; the margin covers scheduling
+    const auto deadline =
+        std::chrono::steady_clock::now() + pool_->GetConfig().timeout + std::chrono::milliseconds(100);
+    const auto answered = [&call] { return call->success.has_value() || call->pending == 0; };
+
+    std::unique_lock<engine::Mutex> lock(call->mutex);
+    // Sent when the first attempt is slower than usual or has already failed
+    if (hedging_enabled_ && (!call->finished.WaitFor(lock, GetHedgeDelay(), answered) || !call->success)) {
+        lock.unlock();
+        // The token is taken first: a picked endpoint must get its request, since
+        // picking a half-open one claims its only probe
+        if (TakeHedgeToken()) {
+            // Another instance if there is a healthy one, otherwise another connection to the same
+            auto hedge = pool_->Pick(*primary);
+            if (!hedge) {
+                hedge = pool_->Pick();
+            }
+            if (hedge) {
+                ++hedges_;
+                StartAttempt(call, *hedge, path, true);
+            }
+        }
+        lock.lock();
+    }
+    const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    call->finished.WaitFor(lock, std::max(remaining, std::chrono::milliseconds(0)), answered);
+    call->cancelled = true;
+
+    if (call->success) {
+        if (call->hedge_won) {
+            ++hedge_wins_;
+        }
+        return std::move(*call->success);
+    }
+    ++failed_;
+    if (call->failure) {
+        return std::move(*call->failure);
+    }
+    return {false, 0, {}, {}};
+}
+
+void StorageUpstream::StartAttempt(const std::shared_ptr<Call>& call, size_t endpoint, const std::string& path,
+                                   bool hedge) {
+    {
+        std::lock_guard<engine::Mutex> lock(call->mutex);
+        ++call->pending;
+    }
+    // Critical, so the task always runs and its guard always fires: a task
+    // cancelled before it started would otherwise keep the endpoint's probe
+    // and leave the caller waiting on `pending`
+    attempts_.CriticalAsyncDetach("storage-upstream-attempt", [this, call, endpoint, path, hedge] {
+        HttpResponse response{false, 0, {}, {}};
+        bool sent = false;
+        utils::ScopeGuard finish([this, &call, endpoint, hedge, &response, &sent] {
+            if (!sent) {
+                pool_->Abandon(endpoint);
+            }
+            std::lock_guard<engine::Mutex> lock(call->mutex);
+            --call->pending;
+            if (response.success) {
+                if (!call->success) {
+                    call->success = std::move(response);
+                    call->hedge_won = hedge;
+                }
+            } else if (!call->failure || response.status_code != 0) {
+                // An HTTP error says more than an aborted or timed out transfer
+                call->failure = std::move(response);
+            }
+            call->finished.NotifyAll();
+        });
+        if (call->cancelled || engine::current_task::ShouldCancel()) {
+            return;
+        }
+        response = pool_->Get(endpoint, path, call->cancelled);
+        sent = true;
+    });
+}
+
+std::chrono::milliseconds StorageUpstream::GetHedgeDelay() const {
+    const auto percentile = pool_->GetLatencyPercentile(hedge_percentile_);
+    if (!percentile) {
+        return hedge_max_delay_;
+    }
+    return std::clamp(*percentile, hedge_min_delay_, hedge_max_delay_);
+}
+
+bool StorageUpstream::TakeHedgeToken() {
+    std::lock_guard<engine::Mutex> lock(hedge_tokens_mutex_);
+    if (hedge_tokens_ < 1.0) {
+        return false;
+    }
+    hedge_tokens_ -= 1.0;
+    return true;
+}
+
+yaml_config::Schema StorageUpstream::GetStaticConfigSchema() {
+    return yaml_config::MergeSchemas<components::LoggableComponentBase>(R"(
+type: object
+description: keep-alive, hedged and circuit-broken connections to StorageService
+additionalProperties: false
+properties:
+    endpoints:
+        type: array
+        description: base URLs of the StorageService instances
+        defaultDescription: '[http://localhost:8080]'
+        items:
+            type: string
+            description: base URL, e.g. http://localhost:8080
+    idle_per_endpoint:
+        type: integer
+        description: idle keep-alive connections kept per instance
+        defaultDescription: 8
+    timeout_ms:
+        type: integer
+        description: total timeout of one attempt
+        defaultDescription: 3000
+    connect_timeout_ms:
+        type: integer
+        description: TCP connect timeout of one attempt
+        defaultDescription: 200
+    fs-task-processor:
+        type: string
+        description: task processor for attempts, which block on libcurl
+        defaultDescription: fs-task-processor
+    hedging:
+        type: object
+        description: a second attempt when the first one is slower than usual
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: send hedged attempts
+                defaultDescription: true
+            percentile:
+                type: number
+                description: latency percentile of recent successes after which the hedge is sent
+                defaultDescription: 95
+            min_delay_ms:
+                type: integer
+                description: lower bound of the hedge delay
+                defaultDescription: 20
+            max_delay_ms:
+                type: integer
+                description: upper bound of the hedge delay, also used until enough latencies are known
+                defaultDescription: 1000
+            max_ratio:
+                type: number
+                description: hedges per request at most, averaged over time
+                defaultDescription: 0.1
+    circuit_breaker:
+        type: object
+        description: fail-fast for instances that keep failing
+        additionalProperties: false
+        properties:
+            failure_threshold:
+                type: integer
+                description: consecutive errors or 5xx answers that open an instance's breaker
+                defaultDescription: 5
+            open_ms:
+                type: integer
+                description: how long an open breaker rejects requests before a probe is let through
+                defaultDescription: 5000
+)");
+}
+
+} // namespace news_aggregator::gateway
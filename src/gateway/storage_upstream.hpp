@@ -0,0 +1,74 @@
+#pragma once
+
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/concurrent/background_task_storage.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/yaml_config/schema.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "upstream_pool.hpp"
+
+namespace news_aggregator::gateway {
+
+// Gateway side of every StorageService call: keep-alive connections to one or
+// more instances (UpstreamPool), hedging and circuit breaking.
+//
+// When the first attempt has failed or not answered within the recent p95
+// latency, a second one goes to the next least loaded instance and whichever
+// succeeds first is returned; the other is aborted. Hedges are capped at a fraction of
+// requests so a slow StorageService is not sent twice its load.
+class StorageUpstream final : public components::LoggableComponentBase {
+public:
+    static constexpr std::string_view kName = "storage-upstream";
+
+    StorageUpstream(const components::ComponentConfig& config,
+                    const components::ComponentContext& component_context);
+
+    ~StorageUpstream() override;
+
+    static yaml_config::Schema GetStaticConfigSchema();
+
+    // GET of `path` (with its query string), e.g. "/news/latest?limit=100".
+    // Fails at once with status 503 while every instance's breaker is open.
+    HttpResponse Get(const std::string& path);
+
+private:
+    struct Call;
+
+    void OnAllComponentsAreStopping() override;
+
+    void StartAttempt(const std::shared_ptr<Call>& call, size_t endpoint, const std::string& path, bool hedge);
+    std::chrono::milliseconds GetHedgeDelay() const;
+    // Token bucket refilled by every request; false when a hedge would exceed the ratio
+    bool TakeHedgeToken();
+
+    std::unique_ptr<UpstreamPool> pool_;
+    engine::TaskProcessor& fs_task_processor_;
+
+    bool hedging_enabled_ = true;
+    double hedge_percentile_ = 95.0;
+    std::chrono::milliseconds hedge_min_delay_{20};
+    std::chrono::milliseconds hedge_max_delay_{1000};
+    double hedge_max_ratio_ = 0.1;
+    engine::Mutex hedge_tokens_mutex_;
+    double hedge_tokens_ = 1.0;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> hedges_{0};
+    std::atomic<uint64_t> hedge_wins_{0};
+    utils::statistics::Entry statistics_holder_;
+    // Declared last so attempts stop before anything they use is destroyed
+    concurrent::BackgroundTaskStorage attempts_;
+};
+
+} // namespace news_aggregator::gateway
@@ -0,0 +1,249 @@
+#include "upstream_pool.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace news_aggregator::gateway {
+
+namespace {
+
+// Recent latencies needed before the percentile is trusted
+constexpr size_t kMinLatencySamples = 32;
+
+size_t WriteBody(void* contents, size_t size, size_t nmemb, std::string* body) {
+    body->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// Non-zero aborts the transfer; how a hedged request's loser is stopped
+int CheckCancelled(void* cancelled, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<const std::atomic<bool>*>(cancelled)->load() ? 1 : 0;
+}
+
+}  // namespace
+
+struct UpstreamPool::Endpoint {
+    std::string url;
+
+    engine::Mutex mutex;
+    std::vector<CURL*> idle;
+    size_t in_flight = 0;
+    BreakerState state = BreakerState::kClosed;
+    size_t consecutive_failures = 0;
+    std::chrono::steady_clock::time_point open_until;
+    // A half-open breaker lets exactly one request through
+    bool probing = false;
+
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t opens = 0;
+};
+
+UpstreamPool::UpstreamPool(UpstreamPoolConfig config) : config_(std::move(config)) {
+    for (const auto& url : config_.endpoints) {
+        auto endpoint = std::make_unique<Endpoint>();
+        endpoint->url = url;
+        while (!endpoint->url.empty() && endpoint->url.back() == '/') {
+            endpoint->url.pop_back();
+        }
+        endpoints_.push_back(std::move(endpoint));
+    }
+    latencies_.reserve(config_.latency_window);
+}
+
+UpstreamPool::~UpstreamPool() {
+    for (auto& endpoint : endpoints_) {
+        for (auto* handle : endpoint->idle) {
+            curl_easy_cleanup(handle);
+        }
+    }
+}
+
+std::optional<size_t> UpstreamPool::Pick(std::optional<size_t> exclude) {
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<size_t> best;
+    size_t best_load = 0;
+    // Rotating the start spreads ties over endpoints
+    const size_t start = next_++;
+    for (size_t offset = 0; offset < endpoints_.size(); ++offset) {
+        const size_t index = (start + offset) % endpoints_.size();
+        if (index == exclude) {
+            continue;
+        }
+        auto& endpoint = *endpoints_[index];
+        std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+        if (endpoint.state == BreakerState::kOpen && now >= endpoint.open_until) {
+            endpoint.state = BreakerState::kHalfOpen;
+            endpoint.probing = false;
+        }
+        if (endpoint.state == BreakerState::kOpen) {
+            continue;
+        }
+        if (endpoint.state == BreakerState::kHalfOpen) {
+            if (endpoint.probing) {
+                continue;
+            }
+            // The probe goes out now; nothing else is compared against it
+            endpoint.probing = true;
+            return index;
+        }
+        if (!best || endpoint.in_flight < best_load) {
+            best = index;
+            best_load = endpoint.in_flight;
+        }
+    }
+    return best;
+}
+
+HttpResponse UpstreamPool::Get(size_t index, const std::string& path, const std::atomic<bool>& cancelled) {
+    auto& endpoint = *endpoints_[index];
+    HttpResponse response{false, 0, {}, {}};
+    const std::string url = endpoint.url + path;
+
+    CURL* handle = AcquireHandle(endpoint);
+    if (!handle) {
+        LOG_ERROR() << "Failed to initialize CURL for " << url;
+        RecordResult(endpoint, false, {});
+        return response;
+    }
+
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteBody);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, "API-Gateway/1.0");
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(config_.timeout.count()));
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(config_.connect_timeout.count()));
+    // Signals cannot interrupt a fs-task-processor thread safely
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, CheckCancelled);
+    curl_easy_setopt(handle, CURLOPT_XFERINFODATA, const_cast<std::atomic<bool>*>(&cancelled));
+
+    const auto started = std::chrono::steady_clock::now();
+    const CURLcode result = curl_easy_perform(handle);
+    const auto latency = std::chrono::steady_clock::now() - started;
+
+    if (result == CURLE_OK) {
+        long status_code = 0;
+        curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status_code);
+        response.status_code = static_cast<int>(status_code);
+        response.success = response.status_code >= 200 && response.status_code < 300;
+    } else if (result != CURLE_ABORTED_BY_CALLBACK) {
+        LOG_WARNING() << "Upstream request to " << url << " failed: " << curl_easy_strerror(result);
+    }
+    ReleaseHandle(endpoint, handle);
+
+    if (result == CURLE_ABORTED_BY_CALLBACK) {
+        // Cancelled in favour of a faster copy; says nothing about the endpoint
+        std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+        --endpoint.in_flight;
+        endpoint.probing = false;
+        return response;
+    }
+    RecordResult(endpoint, result == CURLE_OK && response.status_code < 500, latency);
+    return response;
+}
+
+void UpstreamPool::Abandon(size_t index) {
+    auto& endpoint = *endpoints_[index];
+    std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+    endpoint.probing = false;
+}
+
+CURL* UpstreamPool::AcquireHandle(Endpoint& endpoint) {
+    CURL* handle = nullptr;
+    {
+        std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+        ++endpoint.in_flight;
+        ++endpoint.requests;
+        if (!endpoint.idle.empty()) {
+            handle = endpoint.idle.back();
+            endpoint.idle.pop_back();
+        }
+    }
+    if (handle) {
+        // Clears the options of the previous request but keeps its open connection
+        curl_easy_reset(handle);
+        return handle;
+    }
+    return curl_easy_init();
+}
+
+void UpstreamPool::ReleaseHandle(Endpoint& endpoint, CURL* handle) {
+    {
+        std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+        if (endpoint.idle.size() < config_.idle_per_endpoint) {
+            endpoint.idle.push_back(handle);
+            handle = nullptr;
+        }
+    }
+    if (handle) {
+        curl_easy_cleanup(handle);
+    }
+}
+
+void UpstreamPool::RecordResult(Endpoint& endpoint, bool success, std::chrono::steady_clock::duration latency) {
+    {
+        std::lock_guard<engine::Mutex> lock(endpoint.mutex);
+        --endpoint.in_flight;
+        const bool was_probe = endpoint.state == BreakerState::kHalfOpen && endpoint.probing;
+        endpoint.probing = false;
+        if (success) {
+            endpoint.consecutive_failures = 0;
+            if (endpoint.state != BreakerState::kClosed) {
+                LOG_INFO() << "Upstream " << endpoint.url << " recovered, closing its circuit breaker";
+                endpoint.state = BreakerState::kClosed;
+            }
+        } else {
+            ++endpoint.failures;
+            ++endpoint.consecutive_failures;
+            if (was_probe || (endpoint.state == BreakerState::kClosed &&
+                              endpoint.consecutive_failures >= config_.failure_threshold)) {
+                LOG_WARNING() << "Upstream " << endpoint.url << " failed " << endpoint.consecutive_failures
+                              << " times in a row, opening its circuit breaker for "
+                              << config_.open_duration.count() << "ms";
+                endpoint.state = BreakerState::kOpen;
+                endpoint.open_until = std::chrono::steady_clock::now() + config_.open_duration;
+                ++endpoint.opens;
+            }
+        }
+    }
+
+    if (success && config_.latency_window > 0) {
+        std::lock_guard<engine::Mutex> lock(latency_mutex_);
+        if (latencies_.size() < config_.latency_window) {
+            latencies_.push_back(latency);
+        } else {
+            latencies_[latency_pos_] = latency;
+            latency_pos_ = (latency_pos_ + 1) % latencies_.size();
+        }
+    }
+}
+
+std::optional<std::chrono::milliseconds> UpstreamPool::GetLatencyPercentile(double percentile) const {
+    std::vector<std::chrono::steady_clock::duration> latencies;
+    {
+        std::lock_guard<engine::Mutex> lock(latency_mutex_);
+        if (latencies_.size() < kMinLatencySamples) {
+            return std::nullopt;
+        }
+        latencies = latencies_;
+    }
+    const auto rank = std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * percentile / 100.0));
+    std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+    return std::chrono::duration_cast<std::chrono::milliseconds>(latencies[rank]);
+}
+
+std::vector<UpstreamEndpointStats> UpstreamPool::GetStats() const {
+    std::vector<UpstreamEndpointStats> stats;
+    stats.reserve(endpoints_.size());
+    for (const auto& endpoint : endpoints_) {
+        std::lock_guard<engine::Mutex> lock(endpoint->mutex);
+        stats.push_back({endpoint->url, endpoint->state, endpoint->in_flight, endpoint->idle.size(),
+                         endpoint->requests, endpoint->failures, endpoint->opens});
+    }
+    return stats;
+}
+
+} // namespace news_aggregator::gateway
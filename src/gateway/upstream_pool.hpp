@@ -0,0 +1,93 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "http_client.hpp"
+
+namespace news_aggregator::gateway {
+
+struct UpstreamPoolConfig {
+    // Base URLs of the StorageService instances, e.g. "http://localhost:8080"
+    std::vector<std::string> endpoints;
+    // Idle keep-alive handles kept per endpoint
+    size_t idle_per_endpoint = 8;
+    std::chrono::milliseconds timeout{3000};
+    std::chrono::milliseconds connect_timeout{200};
+    // Consecutive failures that open an endpoint's breaker
+    size_t failure_threshold = 5;
+    // How long an open breaker rejects requests before letting one probe through
+    std::chrono::milliseconds open_duration{5000};
+    // Successful latencies the percentile is taken over
+    size_t latency_window = 256;
+};
+
+enum class BreakerState { kClosed, kOpen, kHalfOpen };
+
+struct UpstreamEndpointStats {
+    std::string url;
+    BreakerState state = BreakerState::kClosed;
+    size_t in_flight = 0;
+    size_t idle = 0;
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t opens = 0;
+};
+
+// Keep-alive connections to a set of StorageService instances. Every request
+// goes to the least loaded endpoint whose circuit breaker lets it through;
+// libcurl handles are reused, so the TCP connection outlives the request.
+//
+// A breaker opens after `failure_threshold` consecutive transport errors or
+// 5xx answers, rejects requests to that endpoint for `open_duration`, then
+// admits a single probe that closes it again on success.
+class UpstreamPool {
+public:
+    explicit UpstreamPool(UpstreamPoolConfig config);
+    ~UpstreamPool();
+
+    UpstreamPool(const UpstreamPool&) = delete;
+    UpstreamPool& operator=(const UpstreamPool&) = delete;
+
+    // Index of the endpoint to send the next request to, skipping `exclude`;
+    // std::nullopt when every candidate's breaker is open
+    std::optional<size_t> Pick(std::optional<size_t> exclude = std::nullopt);
+
+    // Blocking GET of `path` on an endpoint returned by Pick. Returns early with
+    // a failed response once `cancelled` is set.
+    HttpResponse Get(size_t endpoint, const std::string& path, const std::atomic<bool>& cancelled);
+    // For an endpoint returned by Pick that will not get its Get after all:
+    // hands a half-open breaker's probe to the next request
+    void Abandon(size_t endpoint);
+
+    // Latency below which `percentile` of recent successful requests finished;
+    // std::nullopt until enough have been seen
+    std::optional<std::chrono::milliseconds> GetLatencyPercentile(double percentile) const;
+
+    std::vector<UpstreamEndpointStats> GetStats() const;
+    const UpstreamPoolConfig& GetConfig() const { return config_; }
+
+private:
+    struct Endpoint;
+
+    CURL* AcquireHandle(Endpoint& endpoint);
+    void ReleaseHandle(Endpoint& endpoint, CURL* handle);
+    void RecordResult(Endpoint& endpoint, bool success, std::chrono::steady_clock::duration latency);
+
+    const UpstreamPoolConfig config_;
+    std::vector<std::unique_ptr<Endpoint>> endpoints_;
+    std::atomic<size_t> next_{0};
+
+    mutable engine::Mutex latency_mutex_;
+    std::vector<std::chrono::steady_clock::duration> latencies_;
+    size_t latency_pos_ = 0;
+};
+
+} // namespace news_aggregator::gateway
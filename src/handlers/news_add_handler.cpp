@@ -5,10 +5,35 @@
 #include <userver/formats/json/parser/parser.hpp>
 #include <userver/http/common_headers.hpp>
 #include <userver/logging/log.hpp>
-#include "../storage/postgres_client.hpp"
+#include <stdexcept>
+#include <vector>
+#include "../storage/text_normalizer.hpp"
 
 namespace news_aggregator::handlers {
 
+namespace {
+
+storage::NewsItem ParseNewsItem(const formats::json::Value& json) {
+  storage::NewsItem item;
+  item.id = 0;
+  item.title = json["title"].As<std::string>();
+  item.content = json["content"].As<std::string>();
+  item.source = json["source"].As<std::string>();
+  item.category = json["category"].As<std::string>();
+  item.url = json["url"].As<std::string>("");
+  item.guid = json["guid"].As<std::string>("");
+  // Stored text is clean, so readers can serialize it without touching it again
+  storage::NormalizeNewsItem(item);
+  return item;
+}
+
+}  // namespace
+
+NewsAddHandler::NewsAddHandler(const components::ComponentConfig& config,
+                               const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
 std::string NewsAddHandler::HandleRequest(
     server::http::HttpRequest& request,
     server::request::RequestContext&) const {
@@ -23,32 +48,100 @@ std::string NewsAddHandler::HandleRequest(
     // Parse JSON from request body
     auto request_body = formats::json::FromString(body);
     
-    std::string title = request_body["title"].As<std::string>();
-    std::string content = request_body["content"].As<std::string>();
-    std::string source = request_body["source"].As<std::string>();
-    std::string category = request_body["category"].As<std::string>();
-    std::string url = request_body.HasMember("url") ? request_body["url"].As<std::string>() : "";
+    // Either a single news object or {"items": [...]} from a batching collector
+    std::vector<storage::NewsItem> items;
+    if (request_body.HasMember("items")) {
+      for (const auto& item_json : request_body["items"]) {
+        items.push_back(ParseNewsItem(item_json));
+      }
+    } else {
+      items.push_back(ParseNewsItem(request_body));
+    }
     
-    LOG_INFO() << "Saving news to PostgreSQL database: " << title;
+    LOG_INFO() << "Saving " << items.size() << " news items to PostgreSQL database";
     
-    // Create PostgreSQL client
-    std::string connection_string = "host=localhost port=5432 dbname=news_db user=news_user password=news_password";
-    news_aggregator::storage::PostgresClient postgres_client(connection_string);
+    // Save news to database; already stored stories are reported as duplicates
+    std::vector<storage::AddNewsResult> results;
+    uint64_t last_sequence = 0;
+    if (storage_service_.IsWriteBehindEnabled()) {
+      // All items of the request are queued or none are, so a 503 can be retried as is
+      auto tickets = storage_service_.EnqueueNews(std::move(items));
+      if (!tickets) {
+        LOG_WARNING() << "Write-behind queue is full, rejecting news";
+        
+        formats::json::ValueBuilder error_response;
+        error_response["status"] = "error";
+        error_response["message"] = "Write queue is full, retry later";
+        error_response["accepted_count"] = 0;
+        error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        
+        request.GetHttpResponse().SetStatus(server::http::HttpStatus::kServiceUnavailable);
+        request.GetHttpResponse().SetHeader(std::string("Retry-After"), std::string("1"));
+        return formats::json::ToString(error_response.ExtractValue());
+      }
+      if (!tickets->empty()) {
+        last_sequence = tickets->back().sequence;
+      }
+      
+      if (storage_service_.GetWriteBehindAckMode() == storage::AckMode::kAfterEnqueue) {
+        formats::json::ValueBuilder response;
+        response["status"] = "accepted";
+        response["message"] = "News queued for saving";
+        response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        response["accepted_count"] = tickets->size();
+        response["sequence"] = last_sequence;
+        response["source"] = "CollectorService";
+        
+        request.GetHttpResponse().SetStatus(server::http::HttpStatus::kAccepted);
+        return formats::json::ToString(response.ExtractValue());
+      }
+      
+      // Acknowledge after commit: wait for the group transactions holding our items
+      for (auto& ticket : *tickets) {
+        results.push_back(ticket.result->get());
+      }
+    } else {
+      results = storage_service_.AddNewsBatch(items);
+    }
     
-    if (!postgres_client.Connect()) {
-        throw std::runtime_error("Failed to connect to PostgreSQL");
+    int inserted_count = 0;
+    int duplicate_count = 0;
+    int failed_count = 0;
+    formats::json::ValueBuilder news_ids(formats::common::Type::kArray);
+    for (const auto& result : results) {
+      if (result.inserted) {
+        ++inserted_count;
+      } else if (result.duplicate) {
+        ++duplicate_count;
+      } else {
+        ++failed_count;
+      }
+      news_ids.PushBack(result.id);
     }
     
-    // Save news to database
-    int news_id = postgres_client.AddNews(title, content, source, category, url);
+    if (failed_count > 0 && failed_count == static_cast<int>(results.size())) {
+      throw std::runtime_error("Failed to insert news into PostgreSQL");
+    }
     
     formats::json::ValueBuilder response;
     response["status"] = "success";
     response["message"] = "News successfully saved to database";
     response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
-    response["saved_count"] = 1;
-    response["news_id"] = news_id;
+    response["saved_count"] = inserted_count;
+    response["inserted_count"] = inserted_count;
+    response["duplicate_count"] = duplicate_count;
+    response["failed_count"] = failed_count;
+    if (last_sequence != 0) {
+      response["sequence"] = last_sequence;
+    }
+    if (results.size() == 1) {
+      response["news_id"] = results.front().id;
+    } else {
+      response["news_ids"] = news_ids.ExtractValue();
+    }
     response["source"] = "CollectorService";
 
     return formats::json::ToString(response.ExtractValue());
@@ -0,0 +1,143 @@
+#include "news_archive_handler.hpp"
+
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <optional>
+
+#include "news_json.hpp"
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr int kDefaultLimit = 10;
+constexpr int kMaxLimit = 100;
+
+// "2024-03-01" or "2024-03-01T12:30:00Z", UTC, as microseconds since the epoch
+std::optional<int64_t> ParseUtcTime(const std::string& text) {
+  std::tm tm{};
+  int consumed = 0;
+  if (std::sscanf(text.c_str(), "%4d-%2d-%2d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &consumed) != 3) {
+    return std::nullopt;
+  }
+  if (static_cast<size_t>(consumed) != text.size()) {
+    int time_consumed = 0;
+    if (std::sscanf(text.c_str() + consumed, "T%2d:%2d:%2dZ%n", &tm.tm_hour, &tm.tm_min, &tm.tm_sec,
+                    &time_consumed) != 3 ||
+        static_cast<size_t>(consumed + time_consumed) != text.size()) {
+      return std::nullopt;
+    }
+  }
+  if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31) {
+    return std::nullopt;
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  return static_cast<int64_t>(timegm(&tm)) * 1000000;
+}
+
+std::string MakeErrorResponse(server::http::HttpRequest& request, server::http::HttpStatus status,
+                              const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  request.GetHttpResponse().SetStatus(status);
+  return formats::json::ToString(error_response.ExtractValue());
+}
+
+}  // namespace
+
+NewsArchiveHandler::NewsArchiveHandler(const components::ComponentConfig& config,
+                                       const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsArchiveHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    storage::ArchiveQuery query;
+    query.limit = kDefaultLimit;
+    if (request.HasArg("limit")) {
+      try {
+        query.limit = std::stoi(request.GetArg("limit"));
+      } catch (const std::exception&) {
+        query.limit = 0;
+      }
+      if (query.limit <= 0 || query.limit > kMaxLimit) {
+        return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                                 "limit must be 1-" + std::to_string(kMaxLimit));
+      }
+    }
+    for (const auto& [arg, bound] : {std::pair{"from", &query.from_us}, std::pair{"to", &query.to_us}}) {
+      if (!request.HasArg(arg)) {
+        continue;
+      }
+      const auto parsed = ParseUtcTime(request.GetArg(arg));
+      if (!parsed) {
+        return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                                 std::string("'") + arg + "' must be YYYY-MM-DD or YYYY-MM-DDThh:mm:ssZ");
+      }
+      *bound = *parsed;
+    }
+    if (request.HasArg("before")) {
+      query.before = storage::ParseCursor(request.GetArg("before"));
+      if (!query.before) {
+        return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest, "Invalid 'before' cursor");
+      }
+    }
+    query.category = request.GetArg("category");
+    query.source = request.GetArg("source");
+    query.with_content = request.GetArg("full") == "true";
+
+    const auto items = storage_service_.GetArchivedNews(query);
+    if (!items) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kNotFound, "The archive is disabled");
+    }
+
+    // Archived rows never change, but partitions are still archived at the
+    // newest end: only a range ending below the newest archived row is final
+    int64_t range_end_us = query.to_us;
+    if (query.before) {
+      range_end_us = std::min(range_end_us, query.before->created_at_us + 1);
+    }
+    const auto archived_before = storage_service_.GetArchivedBeforeUs();
+    if (archived_before && range_end_us <= *archived_before) {
+      request.GetHttpResponse().SetHeader(http::headers::kCacheControl, "public, max-age=3600");
+    }
+
+    std::string body = "{\"status\":\"success\",\"count\":";
+    body += std::to_string(items->size());
+    body += ",\"news\":[";
+    for (size_t i = 0; i < items->size(); ++i) {
+      if (i != 0) {
+        body += ',';
+      }
+      body += query.with_content ? SerializeNewsItem((*items)[i]) : SerializeNewsSummary((*items)[i]);
+    }
+    body += ']';
+    if (static_cast<int>(items->size()) == query.limit) {
+      body += ",\"next_cursor\":";
+      AppendJsonString(body, storage::EncodeCursor(storage::CursorOf(items->back())));
+    }
+    body += '}';
+    return body;
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsArchiveHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+}  // namespace news_aggregator::handlers
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <userver/components/component_context.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include "../storage/storage_service.hpp"
+
+namespace news_aggregator::handlers {
+
+// GET /news/archive?from=&to=&category=&source=&before=&limit=&full=: pages
+// through rows moved to the cold archive, newest first
+class NewsArchiveHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-archive-handler";
+
+  NewsArchiveHandler(const components::ComponentConfig& config,
+                     const components::ComponentContext& component_context);
+
+  std::string HandleRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+};
+
+}  // namespace news_aggregator::handlers
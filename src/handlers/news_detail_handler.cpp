@@ -0,0 +1,164 @@
+#include "news_detail_handler.hpp"
+
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+#include <charconv>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include "news_json.hpp"
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr size_t kMaxBatchIds = 100;
+
+std::optional<int> ParseId(std::string_view text) {
+  int id = 0;
+  const auto result = std::from_chars(text.data(), text.data() + text.size(), id);
+  if (result.ec != std::errc{} || result.ptr != text.data() + text.size() || id <= 0) {
+    return std::nullopt;
+  }
+  return id;
+}
+
+// Comma-separated ids in first-seen order without repeats; std::nullopt if
+// any of them is malformed
+std::optional<std::vector<int>> ParseIds(std::string_view text) {
+  std::vector<int> ids;
+  std::unordered_set<int> seen;
+  while (!text.empty()) {
+    const auto comma = text.find(',');
+    const auto id = ParseId(text.substr(0, comma));
+    if (!id) {
+      return std::nullopt;
+    }
+    if (seen.insert(*id).second) {
+      ids.push_back(*id);
+    }
+    text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+  }
+  return ids;
+}
+
+std::string MakeErrorResponse(server::http::HttpRequest& request, server::http::HttpStatus status,
+                              const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  request.GetHttpResponse().SetStatus(status);
+  return formats::json::ToString(error_response.ExtractValue());
+}
+
+}  // namespace
+
+NewsDetailHandler::NewsDetailHandler(const components::ComponentConfig& config,
+                                     const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsDetailHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    const auto id = ParseId(request.GetPathArg("id"));
+    if (!id) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest, "Invalid news id");
+    }
+
+    const auto items = storage_service_.GetNewsByIds({*id});
+    if (items.empty()) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kNotFound, "News not found");
+    }
+
+    // Stored articles never change
+    request.GetHttpResponse().SetHeader(http::headers::kCacheControl, "public, max-age=3600");
+
+    std::string body = "{\"status\":\"success\",\"news\":";
+    body += SerializeNewsItem(*items.front());
+    body += '}';
+    return body;
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsDetailHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+NewsBatchHandler::NewsBatchHandler(const components::ComponentConfig& config,
+                                   const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsBatchHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    const auto ids = ParseIds(request.GetArg("ids"));
+    if (!ids || ids->empty()) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                               "Expected ?ids= with comma-separated news ids");
+    }
+    if (ids->size() > kMaxBatchIds) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                               "At most " + std::to_string(kMaxBatchIds) + " ids per request");
+    }
+
+    const auto items = storage_service_.GetNewsByIds(*ids);
+
+    std::unordered_set<int> found;
+    size_t body_size = 64;
+    std::vector<std::string> fragments;
+    fragments.reserve(items.size());
+    for (const auto& item : items) {
+      found.insert(item->id);
+      fragments.push_back(SerializeNewsItem(*item));
+      body_size += fragments.back().size() + 1;
+    }
+
+    std::string body;
+    body.reserve(body_size);
+    body += "{\"status\":\"success\",\"count\":";
+    body += std::to_string(fragments.size());
+    body += ",\"news\":[";
+    for (size_t i = 0; i < fragments.size(); ++i) {
+      if (i != 0) {
+        body += ',';
+      }
+      body += fragments[i];
+    }
+    body += "],\"missing\":[";
+    bool first = true;
+    for (const int id : *ids) {
+      if (found.count(id)) {
+        continue;
+      }
+      if (!first) {
+        body += ',';
+      }
+      body += std::to_string(id);
+      first = false;
+    }
+    body += "]}";
+    return body;
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsBatchHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+}  // namespace news_aggregator::handlers
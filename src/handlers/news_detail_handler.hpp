@@ -0,0 +1,43 @@
+#pragma once
+
+#include <userver/components/component_context.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include "../storage/storage_service.hpp"
+
+namespace news_aggregator::handlers {
+
+// GET /news/{id}: one full article including its content
+class NewsDetailHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-detail-handler";
+
+  NewsDetailHandler(const components::ComponentConfig& config,
+                    const components::ComponentContext& component_context);
+
+  std::string HandleRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+};
+
+// GET /news/items?ids=1,2,3: several full articles in one round trip
+class NewsBatchHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-batch-handler";
+
+  NewsBatchHandler(const components::ComponentConfig& config,
+                   const components::ComponentContext& component_context);
+
+  std::string HandleRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+};
+
+}  // namespace news_aggregator::handlers
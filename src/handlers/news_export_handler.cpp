@@ -0,0 +1,144 @@
+#include "news_export_handler.hpp"
+
+#include <userver/engine/deadline.hpp>
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+
+#include "news_json.hpp"
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+// Rows are sent in chunks of about this size; the first row goes out alone
+// so the client sees data as soon as PostgreSQL produces it
+constexpr size_t kChunkSize = 64 * 1024;
+constexpr std::chrono::seconds kChunkTimeout{30};
+
+void SendError(server::http::ResponseBodyStream& stream, server::http::HttpStatus status,
+               const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  stream.SetStatusCode(status);
+  stream.SetHeader(std::string(http::headers::kContentType), "application/json");
+  stream.SetEndOfHeaders();
+  stream.PushBodyChunk(formats::json::ToString(error_response.ExtractValue()),
+                       engine::Deadline::FromDuration(kChunkTimeout));
+}
+
+// {"status":"complete"|"error","count":N} after the last row
+void AppendExportTrailer(std::string& out, std::string_view status, size_t rows) {
+  out += "{\"status\":";
+  AppendJsonString(out, status);
+  out += ",\"count\":";
+  out += std::to_string(rows);
+  out += "}\n";
+}
+
+}  // namespace
+
+NewsExportHandler::NewsExportHandler(const components::ComponentConfig& config,
+                                     const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+void NewsExportHandler::HandleStreamRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&,
+    server::http::ResponseBodyStream& response_body_stream) const {
+
+  const auto& from = request.GetArg("from");
+  const auto& to = request.GetArg("to");
+  const auto& format = request.GetArg("format");
+  if (from.empty() || to.empty()) {
+    SendError(response_body_stream, server::http::HttpStatus::kBadRequest,
+              "Both 'from' and 'to' timestamps are required");
+    return;
+  }
+  if (!format.empty() && format != "ndjson") {
+    SendError(response_body_stream, server::http::HttpStatus::kBadRequest,
+              "Unsupported format, only 'ndjson' is available");
+    return;
+  }
+
+  // Headers go out with the first row, so a rejected range can still get a 400
+  bool headers_sent = false;
+  size_t rows = 0;
+  std::string chunk;
+  chunk.reserve(kChunkSize + 4096);
+
+  auto flush = [&]() {
+    if (!headers_sent) {
+      response_body_stream.SetStatusCode(server::http::HttpStatus::kOk);
+      response_body_stream.SetHeader(std::string(http::headers::kContentType), "application/x-ndjson");
+      response_body_stream.SetEndOfHeaders();
+      headers_sent = true;
+    }
+    if (!chunk.empty()) {
+      response_body_stream.PushBodyChunk(std::move(chunk), engine::Deadline::FromDuration(kChunkTimeout));
+      chunk = std::string();
+      chunk.reserve(kChunkSize + 4096);
+    }
+  };
+
+  const auto started = std::chrono::steady_clock::now();
+  storage::PostgresClient::StreamStatus status = storage::PostgresClient::StreamStatus::kFailed;
+  try {
+    status = storage_service_.ExportNews(from, to, [&](storage::NewsItem&& item) {
+      AppendNewsExportLine(chunk, item);
+      ++rows;
+      if (rows == 1 || chunk.size() >= kChunkSize) {
+        try {
+          flush();
+        } catch (const std::exception& ex) {
+          // The client went away: stop reading from PostgreSQL
+          LOG_WARNING() << "News export aborted after " << rows << " rows: " << ex.what();
+          return false;
+        }
+      }
+      return true;
+    });
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsExportHandler: " << ex.what();
+  }
+
+  if (!headers_sent) {
+    if (status == storage::PostgresClient::StreamStatus::kInvalidInput) {
+      SendError(response_body_stream, server::http::HttpStatus::kBadRequest,
+                "'from' and 'to' must be timestamps");
+      return;
+    }
+    if (status == storage::PostgresClient::StreamStatus::kFailed) {
+      SendError(response_body_stream, server::http::HttpStatus::kInternalServerError, "Internal server error");
+      return;
+    }
+  }
+
+  // The last line tells a complete export from a truncated one, whose status
+  // code went out with the first row
+  if (status == storage::PostgresClient::StreamStatus::kDone) {
+    AppendExportTrailer(chunk, "complete", rows);
+    flush();
+  } else if (headers_sent && status == storage::PostgresClient::StreamStatus::kFailed) {
+    LOG_ERROR() << "News export failed after " << rows << " rows";
+    AppendExportTrailer(chunk, "error", rows);
+    try {
+      flush();
+    } catch (const std::exception& ex) {
+      LOG_WARNING() << "Failed to send the export error record: " << ex.what();
+    }
+  }
+
+  LOG_INFO() << "Exported " << rows << " news rows in "
+             << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - started).count()
+             << "ms";
+}
+
+}  // namespace news_aggregator::handlers
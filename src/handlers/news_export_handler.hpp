@@ -0,0 +1,30 @@
+#pragma once
+
+#include <userver/components/component_context.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/server/http/http_response_body_stream.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include "../storage/storage_service.hpp"
+
+namespace news_aggregator::handlers {
+
+// GET /news/export?from=&to=&format=ndjson: every article created in [from, to)
+// as a chunked NDJSON stream, oldest first, closed by a {"status":...,"count":N} line
+class NewsExportHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-export-handler";
+
+  NewsExportHandler(const components::ComponentConfig& config,
+                    const components::ComponentContext& component_context);
+
+  void HandleStreamRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&,
+      server::http::ResponseBodyStream& response_body_stream) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+};
+
+}  // namespace news_aggregator::handlers
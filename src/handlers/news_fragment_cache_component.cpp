@@ -0,0 +1,24 @@
+#include "news_fragment_cache_component.hpp"
+
+#include <userver/yaml_config/merge_schemas.hpp>
+
+namespace news_aggregator::handlers {
+
+NewsFragmentCacheComponent::NewsFragmentCacheComponent(const components::ComponentConfig& config,
+                                                       const components::ComponentContext& component_context)
+    : LoggableComponentBase(config, component_context), cache_(config["size"].As<size_t>(10000)) {}
+
+yaml_config::Schema NewsFragmentCacheComponent::GetStaticConfigSchema() {
+  return yaml_config::MergeSchemas<components::LoggableComponentBase>(R"(
+type: object
+description: serialized listing entries shared by the news handlers
+additionalProperties: false
+properties:
+    size:
+        type: integer
+        description: number of serialized news items kept for reuse
+        defaultDescription: 10000
+)");
+}
+
+}  // namespace news_aggregator::handlers
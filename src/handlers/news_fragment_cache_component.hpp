@@ -0,0 +1,30 @@
+#pragma once
+
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <userver/yaml_config/schema.hpp>
+
+#include "news_json.hpp"
+
+namespace news_aggregator::handlers {
+
+// One NewsFragmentCache for every handler that lists news, so /news/latest and
+// /internal/news/latest serialize each item once between them
+class NewsFragmentCacheComponent final : public components::LoggableComponentBase {
+ public:
+  static constexpr std::string_view kName = "news-fragment-cache";
+
+  NewsFragmentCacheComponent(const components::ComponentConfig& config,
+                             const components::ComponentContext& component_context);
+
+  static yaml_config::Schema GetStaticConfigSchema();
+
+  NewsFragmentCache& GetCache() { return cache_; }
+
+ private:
+  NewsFragmentCache cache_;
+};
+
+}  // namespace news_aggregator::handlers
@@ -5,13 +5,112 @@
 #include <userver/formats/json/parser/parser.hpp>
 #include <userver/http/common_headers.hpp>
 #include <userver/logging/log.hpp>
-#include <map>
-#include "../gateway/redis_client.hpp"
-#include "../gateway/http_client.hpp"
-#include <sstream>
+#include <userver/yaml_config/merge_schemas.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include "../gateway/compression.hpp"
+#include "../gateway/news_snapshot.hpp"
+#include "../gateway/storage_upstream.hpp"
 
 namespace news_aggregator::handlers {
 
+namespace {
+
+// Category names are passed to StorageService unescaped, so only plain slugs are
+// accepted; this also bounds how many snapshot variants can be cached
+bool IsValidCategory(const std::string& category) {
+    if (category.empty() || category.size() > 32) {
+        return false;
+    }
+    return std::all_of(category.begin(), category.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+    });
+}
+
+// Fetches the newest kSnapshotItems items from StorageService and packs them into
+// the snapshot every limit is cut from; std::nullopt when StorageService fails
+// or answers garbage. /internal/news/latest already answers in the snapshot
+// layout; /news/latest is the public JSON listing and has to be scanned. With
+// `min_id`, StorageService answers from the primary unless its hot set holds
+// that row, so a change event is never followed by a snapshot without it.
+std::optional<std::string> FetchNewsSnapshot(gateway::StorageUpstream& storage_upstream,
+                                             bool binary_protocol, const std::string& category,
+                                             int64_t min_id) {
+    std::string path = binary_protocol ? "/internal/news/latest" : "/news/latest";
+    path += "?limit=" + std::to_string(common::kSnapshotItems);
+    if (!category.empty()) {
+        path += "&category=" + category;
+    }
+    if (min_id > 0) {
+        path += "&min_id=" + std::to_string(min_id);
+    }
+    
+    auto storage_response = storage_upstream.Get(path);
+    if (!storage_response.success) {
+        LOG_ERROR() << "Failed to get response from StorageService, status: " << storage_response.status_code;
+        return std::nullopt;
+    }
+    
+    if (binary_protocol) {
+        if (!common::NewsSnapshotView::Parse(storage_response.body)) {
+            LOG_ERROR() << "Malformed snapshot from StorageService, " << storage_response.body.size() << " bytes";
+            return std::nullopt;
+        }
+        return std::move(storage_response.body);
+    }
+
+    // StorageService stores normalized text, so its item bytes are cached as they are
+    return gateway::BuildNewsSnapshot(storage_response.body);
+}
+
+// Weak validator for one page: the listing is fully determined by the
+// snapshot version and the limit it is cut at, but the body also carries the
+// snapshot timestamp and cache_status, so equal tags mean equivalent pages,
+// not identical bytes. The same tag covers every encoding of the page.
+std::string MakeETag(const common::NewsSnapshotView& snapshot, int limit) {
+    char etag[64];
+    std::snprintf(etag, sizeof(etag), "W/\"%016llx-%d\"", static_cast<unsigned long long>(snapshot.GetVersion()),
+                  limit);
+    return etag;
+}
+
+// If-None-Match holds "*" or a comma-separated list of tags; GET compares them
+// weakly, so a W/ prefix is ignored on both sides
+bool MatchesETag(std::string_view if_none_match, std::string_view etag) {
+    if (etag.substr(0, 2) == "W/") {
+        etag.remove_prefix(2);
+    }
+    while (!if_none_match.empty()) {
+        const auto comma = if_none_match.find(',');
+        auto candidate = if_none_match.substr(0, comma);
+        if_none_match = comma == std::string_view::npos ? std::string_view{} : if_none_match.substr(comma + 1);
+
+        while (!candidate.empty() && candidate.front() == ' ') {
+            candidate.remove_prefix(1);
+        }
+        while (!candidate.empty() && candidate.back() == ' ') {
+            candidate.remove_suffix(1);
+        }
+        if (candidate.substr(0, 2) == "W/") {
+            candidate.remove_prefix(2);
+        }
+        if (candidate == "*" || candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+NewsHandler::NewsHandler(const components::ComponentConfig& config,
+                         const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      news_cache_(component_context.FindComponent<gateway::NewsCache>()),
+      storage_upstream_(component_context.FindComponent<gateway::StorageUpstream>()),
+      binary_storage_protocol_(config["storage_protocol"].As<std::string>("binary") == "binary") {}
+
 std::string NewsHandler::HandleRequest(
     server::http::HttpRequest& request,
     server::request::RequestContext&) const {
@@ -39,107 +138,73 @@ std::string NewsHandler::HandleRequest(
               }
             }
 
-            // Create cache key
-            std::stringstream cache_key_stream;
-            cache_key_stream << "news:latest:" << limit;
-            std::string cache_key = cache_key_stream.str();
+            std::string category = request.GetArg("category");
+            if (!category.empty() && !IsValidCategory(category)) {
+              formats::json::ValueBuilder error_response;
+              error_response["status"] = "error";
+              error_response["message"] = "Invalid category";
+              request.GetHttpResponse().SetStatus(server::http::HttpStatus::kBadRequest);
+              return formats::json::ToString(error_response.ExtractValue());
+            }
 
-            // Connect to Redis
-            news_aggregator::gateway::RedisClient redis_client("localhost", 6379, 1000); // 1 second timeout
-            bool redis_connected = redis_client.Connect();
-            
-            if (redis_connected) {
-                // Check cache
-                std::string cached_data = redis_client.GetJson(cache_key);
-                if (!cached_data.empty()) {
-                    request.GetHttpResponse().SetHeader(std::string("X-Cache"), std::string("HIT"));
-                    
-                    // Parse JSON and add cache_status
-                    try {
-                        auto cached_json = formats::json::FromString(cached_data);
-                        formats::json::ValueBuilder builder(cached_json);
-                        builder["cache_status"] = "HIT";
-                        return formats::json::ToString(builder.ExtractValue());
-                    } catch (const std::exception& ex) {
-                        LOG_WARNING() << "Failed to parse cached JSON, returning as is: " << ex.what();
-                        return cached_data;
-                    }
+            // One snapshot per category serves every limit: memory, then Redis,
+            // then one StorageService call shared by every concurrent request
+            const auto cache_key = gateway::NewsCache::GetSnapshotKey(category);
+            const auto cached = news_cache_.GetOrLoad(
+                cache_key, [&news_cache = news_cache_, &storage_upstream = storage_upstream_,
+                            binary = binary_storage_protocol_, category, cache_key] {
+                  return FetchNewsSnapshot(storage_upstream, binary, category,
+                                           news_cache.GetChangedUpTo(cache_key));
+                });
+            const auto snapshot =
+                cached.body ? common::NewsSnapshotView::Parse(*cached.body) : std::nullopt;
+            if (snapshot) {
+                std::string cache_status = "MISS";
+                if (cached.tier != gateway::CacheTier::kUpstream) {
+                  // A stale copy is sent at once; the cache reloads it in the background
+                  cache_status = cached.stale ? "STALE" : "HIT";
+                  request.GetHttpResponse().SetHeader(
+                      std::string("X-Cache-Tier"),
+                      std::string(cached.tier == gateway::CacheTier::kMemory ? "memory" : "redis"));
                 }
-                
-            } else {
-                LOG_WARNING() << "Redis not available, proceeding without cache";
-            }
+                request.GetHttpResponse().SetHeader(std::string("X-Cache"), cache_status);
+                request.GetHttpResponse().SetHeader(std::string("X-Snapshot-Version"),
+                                                    std::to_string(snapshot->GetVersion()));
 
-            // Make HTTP request to StorageService
-            news_aggregator::gateway::HttpClient http_client;
-            http_client.SetUserAgent("API-Gateway/1.0");
-            http_client.SetTimeout(10);
-            
-            std::string storage_url = "http://localhost:8080/news/latest?limit=" + std::to_string(limit);
-            
-            auto storage_response = http_client.Get(storage_url, 10);
-            
-            if (storage_response.success) {
-                
-                // Parse response from StorageService
-                try {
-                    // Clean HTML entities from JSON before parsing
-                    std::string cleaned_json = storage_response.body;
-                    
-                    // Replace common HTML entities that can break JSON parsing
-                    std::map<std::string, std::string> html_entities = {
-                        {"&#8217;", "'"},
-                        {"&#8216;", "'"},
-                        {"&#8220;", "\""},
-                        {"&#8221;", "\""},
-                        {"&#8211;", "–"},
-                        {"&#8212;", "—"},
-                        {"&#8230;", "…"},
-                        {"&amp;", "&"},
-                        {"&lt;", "<"},
-                        {"&gt;", ">"},
-                        {"&quot;", "\""},
-                        {"&#39;", "'"}
-                    };
-                    
-                    for (const auto& entity : html_entities) {
-                        size_t pos = 0;
-                        while ((pos = cleaned_json.find(entity.first, pos)) != std::string::npos) {
-                            cleaned_json.replace(pos, entity.first.length(), entity.second);
-                            pos += entity.second.length();
-                        }
-                    }
-                    
-                    auto storage_json = formats::json::FromString(cleaned_json);
-                    
-                    // Add cache information
-                    formats::json::ValueBuilder response_builder(storage_json);
-                    response_builder["cache_status"] = redis_connected ? "MISS" : "DISABLED";
-                    response_builder["gateway_info"] = "API Gateway successfully integrated with StorageService";
-                    
-                    // Save to cache if Redis is available
-                    if (redis_connected) {
-                        redis_client.SetJson(cache_key, formats::json::ToString(response_builder.ExtractValue()), 300); // 5 minutes TTL
-                    }
-                    
-                    return formats::json::ToString(response_builder.ExtractValue());
-                    
-                } catch (const std::exception& ex) {
-                    LOG_ERROR() << "Failed to parse StorageService response: " << ex.what();
-                    // Fallback to error response
-                    formats::json::ValueBuilder error_response;
-                    error_response["status"] = "error";
-                    error_response["message"] = "Failed to parse StorageService response";
-                    error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        std::chrono::system_clock::now().time_since_epoch()).count();
-                    error_response["cache_status"] = "ERROR";
-                    error_response["news"] = formats::json::ValueBuilder{}.ExtractValue(); // Empty array
-                    
-                    request.GetHttpResponse().SetHeader(std::string("X-Cache"), std::string("ERROR"));
-                    return formats::json::ToString(error_response.ExtractValue());
+                // The body depends on Accept-Encoding, so shared caches must key on it
+                request.GetHttpResponse().SetHeader(http::headers::kVary, std::string("Accept-Encoding"));
+                const auto accepted =
+                    gateway::NegotiateEncoding(request.GetHeader(http::headers::kAcceptEncoding));
+
+                // A client that already has this page, in any encoding, gets an
+                // empty 304 instead
+                auto etag = MakeETag(*snapshot, limit);
+                if (MatchesETag(request.GetHeader(http::headers::kIfNoneMatch), etag)) {
+                  request.GetHttpResponse().SetHeader(http::headers::kETag, std::move(etag));
+                  request.GetHttpResponse().SetStatus(server::http::HttpStatus::kNotModified);
+                  return {};
+                }
+
+                // Compressed pages are built once in the background and carry the
+                // HIT status in the body; until one is ready the page goes out as is
+                if (accepted != gateway::ContentEncoding::kIdentity) {
+                  const auto page_key =
+                      cache_key + ':' + std::to_string(snapshot->GetVersion()) + ':' + std::to_string(limit);
+                  const auto compressed = news_cache_.GetCompressed(page_key, accepted, [body = cached.body, limit] {
+                    return gateway::RenderNewsPage(*common::NewsSnapshotView::Parse(*body), limit, "HIT");
+                  });
+                  if (compressed) {
+                    request.GetHttpResponse().SetHeader(http::headers::kETag, std::move(etag));
+                    request.GetHttpResponse().SetHeader(http::headers::kContentEncoding,
+                                                        std::string(gateway::GetEncodingName(accepted)));
+                    return *compressed;
+                  }
                 }
-            } else {
-                LOG_ERROR() << "Failed to get response from StorageService, status: " << storage_response.status_code;
+                request.GetHttpResponse().SetHeader(http::headers::kETag, std::move(etag));
+                return gateway::RenderNewsPage(*snapshot, limit, cache_status);
+            }
+            if (cached.body) {
+              LOG_ERROR() << "Malformed news snapshot under " << cache_key;
             }
             
             // Fallback: return error if failed to get data from StorageService
@@ -168,4 +233,18 @@ std::string NewsHandler::HandleRequest(
   }
 }
 
-}  // namespace news_aggregator::handlers
\ No newline at end of file
+yaml_config::Schema NewsHandler::GetStaticConfigSchema() {
+  return yaml_config::MergeSchemas<server::handlers::HttpHandlerBase>(R"(
+type: object
+description: /news handler config
+additionalProperties: false
+properties:
+    storage_protocol:
+        type: string
+        description: how snapshots are fetched from StorageService; binary uses /internal/news/latest, json the public /news/latest
+        defaultDescription: binary
+        enum: [binary, json]
+)");
+}
+
+}  // namespace news_aggregator::handlers
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <userver/components/component_context.hpp>
 #include <userver/server/handlers/http_handler_base.hpp>
 #include <userver/utest/using_namespace_userver.hpp>
+#include <userver/yaml_config/schema.hpp>
+
+#include "../gateway/news_cache.hpp"
+#include "../gateway/storage_upstream.hpp"
 
 namespace news_aggregator::handlers {
 
@@ -9,11 +14,20 @@ class NewsHandler final : public server::handlers::HttpHandlerBase {
  public:
   static constexpr std::string_view kName = "news-handler";
 
-  using HttpHandlerBase::HttpHandlerBase;
+  NewsHandler(const components::ComponentConfig& config,
+              const components::ComponentContext& component_context);
 
   std::string HandleRequest(
       server::http::HttpRequest& request,
       server::request::RequestContext&) const override;
+
+  static yaml_config::Schema GetStaticConfigSchema();
+
+ private:
+  gateway::NewsCache& news_cache_;
+  gateway::StorageUpstream& storage_upstream_;
+  // Fetch snapshots from /internal/news/latest rather than /news/latest
+  const bool binary_storage_protocol_;
 };
 
 }  // namespace news_aggregator::handlers
\ No newline at end of file
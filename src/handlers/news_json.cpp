@@ -0,0 +1,135 @@
+#include "news_json.hpp"
+
+#include <algorithm>
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr size_t kCacheWays = 16;
+
+// Writes the fields without the closing brace
+void AppendNewsFields(std::string& out, const storage::NewsItem& item, bool with_content) {
+  out += "{\"id\":";
+  out += std::to_string(item.id);
+  out += ",\"title\":";
+  AppendJsonString(out, item.title);
+  if (with_content) {
+    out += ",\"content\":";
+    AppendJsonString(out, item.content);
+  } else {
+    out += ",\"snippet\":";
+    AppendJsonString(out, item.snippet);
+  }
+  out += ",\"source\":";
+  AppendJsonString(out, item.source);
+  out += ",\"category\":";
+  AppendJsonString(out, item.category);
+  out += ",\"published_at\":";
+  AppendJsonString(out, item.published_at);
+  if (!item.url.empty()) {
+    out += ",\"url\":";
+    AppendJsonString(out, item.url);
+  }
+}
+
+}  // namespace
+
+void AppendJsonString(std::string& out, std::string_view value) {
+  static constexpr char kHex[] = "0123456789abcdef";
+
+  out.push_back('"');
+  size_t plain_from = 0;
+  for (size_t i = 0; i < value.size(); ++i) {
+    const auto c = static_cast<unsigned char>(value[i]);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    // Copy the run of characters that need no escaping in one go
+    out.append(value.data() + plain_from, i - plain_from);
+    plain_from = i + 1;
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      default:
+        out += "\\u00";
+        out.push_back(kHex[c >> 4]);
+        out.push_back(kHex[c & 0xF]);
+    }
+  }
+  out.append(value.data() + plain_from, value.size() - plain_from);
+  out.push_back('"');
+}
+
+std::string SerializeNewsItem(const storage::NewsItem& item) {
+  std::string out;
+  out.reserve(128 + item.title.size() + item.content.size() + item.url.size());
+  AppendNewsFields(out, item, true);
+  out += '}';
+  return out;
+}
+
+std::string SerializeNewsSummary(const storage::NewsItem& item) {
+  std::string out;
+  out.reserve(128 + item.title.size() + item.snippet.size() + item.url.size());
+  AppendNewsFields(out, item, false);
+  out += '}';
+  return out;
+}
+
+void AppendNewsExportLine(std::string& out, const storage::NewsItem& item) {
+  AppendNewsFields(out, item, true);
+  out += ",\"created_at_us\":";
+  out += std::to_string(item.created_at_us);
+  out += "}\n";
+}
+
+std::string BuildNewsLatestBody(const std::vector<std::shared_ptr<const std::string>>& fragments, int limit,
+                                int64_t timestamp_ms, std::string_view next_cursor) {
+  // A response is mostly copies of cached fragments into a buffer sized up front
+  size_t body_size = 256 + next_cursor.size();
+  for (const auto& fragment : fragments) {
+    body_size += fragment->size() + 1;
+  }
+
+  std::string body;
+  body.reserve(body_size);
+  body += "{\"status\":\"success\",\"count\":";
+  body += std::to_string(fragments.size());
+  body += ",\"limit\":";
+  body += std::to_string(limit);
+  body += ",\"timestamp\":";
+  body += std::to_string(timestamp_ms);
+  body += ",\"message\":\"Latest news from StorageService\",\"source\":\"PostgreSQL Database\",\"news\":[";
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    if (i != 0) {
+      body += ',';
+    }
+    body += *fragments[i];
+  }
+  body += ']';
+  if (!next_cursor.empty()) {
+    body += ",\"next_cursor\":";
+    AppendJsonString(body, next_cursor);
+  }
+  body += '}';
+  return body;
+}
+
+NewsFragmentCache::NewsFragmentCache(size_t size) : cache_(kCacheWays, std::max(size, kCacheWays)) {}
+
+std::shared_ptr<const std::string> NewsFragmentCache::Get(const storage::NewsItem& item) {
+  if (auto cached = cache_.Get(item.id)) {
+    return std::move(*cached);
+  }
+  auto fragment = std::make_shared<const std::string>(SerializeNewsSummary(item));
+  cache_.Put(item.id, fragment);
+  return fragment;
+}
+
+}  // namespace news_aggregator::handlers
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <userver/cache/nway_lru_cache.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../storage/postgres_client.hpp"
+
+namespace news_aggregator::handlers {
+
+// Appends `value` as a quoted JSON string
+void AppendJsonString(std::string& out, std::string_view value);
+
+// Serialize one item as a JSON object without going through a DOM: the
+// full article, or the listing entry with the snippet instead of the body
+std::string SerializeNewsItem(const storage::NewsItem& item);
+std::string SerializeNewsSummary(const storage::NewsItem& item);
+// Full article plus created_at_us, appended as one NDJSON line
+void AppendNewsExportLine(std::string& out, const storage::NewsItem& item);
+
+// /news/latest response around already serialized listing entries; the
+// cursor is left out when empty
+std::string BuildNewsLatestBody(const std::vector<std::shared_ptr<const std::string>>& fragments, int limit,
+                                int64_t timestamp_ms, std::string_view next_cursor);
+
+// LRU of serialized listing entries keyed by id. Stored rows never change, so
+// a cached fragment stays valid for the lifetime of the id.
+class NewsFragmentCache {
+ public:
+  explicit NewsFragmentCache(size_t size);
+
+  std::shared_ptr<const std::string> Get(const storage::NewsItem& item);
+
+ private:
+  cache::NWayLRU<int, std::shared_ptr<const std::string>> cache_;
+};
+
+}  // namespace news_aggregator::handlers
@@ -4,10 +4,16 @@
 #include <userver/formats/json/serialize.hpp>
 #include <userver/http/common_headers.hpp>
 #include <userver/logging/log.hpp>
-#include "../storage/postgres_client.hpp"
+#include <algorithm>
 
 namespace news_aggregator::handlers {
 
+NewsLatestHandler::NewsLatestHandler(const components::ComponentConfig& config,
+                                     const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()),
+      fragment_cache_(component_context.FindComponent<NewsFragmentCacheComponent>().GetCache()) {}
+
 std::string NewsLatestHandler::HandleRequest(
     server::http::HttpRequest& request,
     server::request::RequestContext&) const {
@@ -29,46 +35,56 @@ std::string NewsLatestHandler::HandleRequest(
       }
     }
 
-    // Create PostgreSQL client
-    std::string connection_string = "host=localhost port=5432 dbname=news_db user=news_user password=news_password";
-    news_aggregator::storage::PostgresClient postgres_client(connection_string);
-    
-    if (!postgres_client.Connect()) {
-        throw std::runtime_error("Failed to connect to PostgreSQL");
+    storage::NewsQuery query;
+    query.limit = limit;
+    if (request.HasArg("category")) {
+      query.category = request.GetArg("category");
+    }
+    if (request.HasArg("source")) {
+      query.source = request.GetArg("source");
+    }
+    // Sent by the gateway after a change event: the rows up to this id must be in the answer
+    if (request.HasArg("min_id")) {
+      try {
+        query.min_id = std::max(0, std::stoi(request.GetArg("min_id")));
+      } catch (const std::exception&) {
+        query.min_id = 0;
+      }
+    }
+    if (request.HasArg("before")) {
+      query.before = storage::ParseCursor(request.GetArg("before"));
+      if (!query.before) {
+        formats::json::ValueBuilder error_response;
+        error_response["status"] = "error";
+        error_response["message"] = "Invalid 'before' cursor";
+        error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        request.GetHttpResponse().SetStatus(server::http::HttpStatus::kBadRequest);
+        return formats::json::ToString(error_response.ExtractValue());
+      }
     }
     
     // Get news from database
-    auto news_items = postgres_client.GetLatestNews(limit);
-    
-    // Create response with news from database
-    formats::json::ValueBuilder response;
-    response["status"] = "success";
-    response["count"] = news_items.size();
-    response["limit"] = limit;
-    response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto news_items = storage_service_.GetLatestNews(query);
     
-    response["message"] = "Latest news from StorageService";
-    response["source"] = "PostgreSQL Database";
-    
-    // Create news array from query result
-    formats::json::ValueBuilder news_array;
+    // Items are serialized once and reused
+    std::vector<std::shared_ptr<const std::string>> fragments;
+    fragments.reserve(news_items.size());
     for (const auto& item : news_items) {
-        formats::json::ValueBuilder news_item;
-        news_item["id"] = item.id;
-        news_item["title"] = item.title;
-        news_item["content"] = item.content;
-        news_item["source"] = item.source;
-        news_item["category"] = item.category;
-        news_item["published_at"] = item.published_at;
-        if (!item.url.empty()) {
-            news_item["url"] = item.url;
-        }
-        news_array.PushBack(news_item.ExtractValue());
+      fragments.push_back(fragment_cache_.Get(*item));
+    }
+
+    const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // A full page means there may be more rows behind the last item
+    std::string next_cursor;
+    if (static_cast<int>(news_items.size()) == limit) {
+      next_cursor = storage::EncodeCursor(storage::CursorOf(*news_items.back()));
     }
-    response["news"] = news_array.ExtractValue();
 
-    return formats::json::ToString(response.ExtractValue());
+    return BuildNewsLatestBody(fragments, limit, timestamp, next_cursor);
 
   } catch (const std::exception& ex) {
     LOG_ERROR() << "Error in NewsLatestHandler: " << ex.what();
@@ -1,19 +1,28 @@
 #pragma once
 
+#include <userver/components/component_context.hpp>
 #include <userver/server/handlers/http_handler_base.hpp>
 #include <userver/utest/using_namespace_userver.hpp>
 
+#include "../storage/storage_service.hpp"
+#include "news_fragment_cache_component.hpp"
+
 namespace news_aggregator::handlers {
 
 class NewsLatestHandler final : public server::handlers::HttpHandlerBase {
  public:
   static constexpr std::string_view kName = "news-latest-handler";
 
-  using HttpHandlerBase::HttpHandlerBase;
+  NewsLatestHandler(const components::ComponentConfig& config,
+                    const components::ComponentContext& component_context);
 
   std::string HandleRequest(
       server::http::HttpRequest& request,
       server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+  NewsFragmentCache& fragment_cache_;
 };
 
 }  // namespace news_aggregator::handlers
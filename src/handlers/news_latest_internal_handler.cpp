@@ -0,0 +1,84 @@
+#include "news_latest_internal_handler.hpp"
+
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+#include <algorithm>
+
+#include "../common/news_snapshot.hpp"
+
+namespace news_aggregator::handlers {
+
+NewsLatestInternalHandler::NewsLatestInternalHandler(const components::ComponentConfig& config,
+                                                     const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()),
+      fragment_cache_(component_context.FindComponent<NewsFragmentCacheComponent>().GetCache()) {}
+
+std::string NewsLatestInternalHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationOctetStream);
+  request.GetHttpResponse().SetHeader(http::headers::kCacheControl, "no-store");
+
+  try {
+    // The gateway asks for a full snapshot; smaller pages are prefixes of it
+    int limit = static_cast<int>(common::kSnapshotItems);
+    if (request.HasArg("limit")) {
+      try {
+        limit = std::stoi(request.GetArg("limit"));
+        if (limit <= 0 || limit > static_cast<int>(common::kSnapshotItems)) {
+          limit = static_cast<int>(common::kSnapshotItems);
+        }
+      } catch (const std::exception&) {
+        limit = static_cast<int>(common::kSnapshotItems);
+      }
+    }
+
+    storage::NewsQuery query;
+    query.limit = limit;
+    if (request.HasArg("category")) {
+      query.category = request.GetArg("category");
+    }
+    if (request.HasArg("source")) {
+      query.source = request.GetArg("source");
+    }
+    // Sent by the gateway after a change event: the rows up to this id must be in the answer
+    if (request.HasArg("min_id")) {
+      try {
+        query.min_id = std::max(0, std::stoi(request.GetArg("min_id")));
+      } catch (const std::exception&) {
+        query.min_id = 0;
+      }
+    }
+
+    auto news_items = storage_service_.GetLatestNews(query);
+
+    // The fragments /news/latest caches too; only the framing differs
+    std::vector<std::shared_ptr<const std::string>> fragments;
+    fragments.reserve(news_items.size());
+    std::vector<std::string_view> items;
+    items.reserve(news_items.size());
+    std::vector<int64_t> ids;
+    ids.reserve(news_items.size());
+    for (const auto& item : news_items) {
+      fragments.push_back(fragment_cache_.Get(*item));
+      items.push_back(*fragments.back());
+      ids.push_back(item->id);
+    }
+
+    const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return common::EncodeNewsSnapshot(common::FoldSnapshotVersion(ids), timestamp, items);
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsLatestInternalHandler: " << ex.what();
+
+    // The gateway only checks the status; there is no envelope to put a message in
+    request.GetHttpResponse().SetContentType(http::content_type::kTextPlain);
+    request.GetHttpResponse().SetStatus(server::http::HttpStatus::kInternalServerError);
+    return "Internal server error";
+  }
+}
+
+}  // namespace news_aggregator::handlers
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <userver/components/component_context.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include "../storage/storage_service.hpp"
+#include "news_fragment_cache_component.hpp"
+
+namespace news_aggregator::handlers {
+
+// /internal/news/latest: the newest items in the gateway snapshot layout
+// (see common/news_snapshot.hpp) instead of the public JSON envelope, so the
+// gateway validates a header and caches the body without scanning it
+class NewsLatestInternalHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-latest-internal-handler";
+
+  NewsLatestInternalHandler(const components::ComponentConfig& config,
+                            const components::ComponentContext& component_context);
+
+  std::string HandleRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+  NewsFragmentCache& fragment_cache_;
+};
+
+}  // namespace news_aggregator::handlers
@@ -0,0 +1,118 @@
+#include "news_search_handler.hpp"
+
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+#include <charconv>
+#include <optional>
+
+#include "news_json.hpp"
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr int kDefaultLimit = 10;
+constexpr int kMaxLimit = 50;
+constexpr int kMaxOffset = 1000;
+constexpr size_t kMaxQueryLength = 256;
+
+// Empty text gives `fallback`; malformed or out-of-range text gives std::nullopt
+std::optional<int> ParseBounded(std::string_view text, int fallback, int min, int max) {
+  if (text.empty()) {
+    return fallback;
+  }
+  int value = 0;
+  const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (result.ec != std::errc{} || result.ptr != text.data() + text.size() || value < min || value > max) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::string MakeErrorResponse(server::http::HttpRequest& request, server::http::HttpStatus status,
+                              const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  request.GetHttpResponse().SetStatus(status);
+  return formats::json::ToString(error_response.ExtractValue());
+}
+
+}  // namespace
+
+NewsSearchHandler::NewsSearchHandler(const components::ComponentConfig& config,
+                                     const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsSearchHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    storage::SearchQuery query;
+    query.text = request.GetArg("q");
+    query.category = request.GetArg("category");
+    query.source = request.GetArg("source");
+    if (query.text.empty() || query.text.size() > kMaxQueryLength) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                               "Expected ?q= with at most " + std::to_string(kMaxQueryLength) + " bytes");
+    }
+
+    const auto limit = ParseBounded(request.GetArg("limit"), kDefaultLimit, 1, kMaxLimit);
+    const auto offset = ParseBounded(request.GetArg("offset"), 0, 0, kMaxOffset);
+    if (!limit || !offset) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                               "limit must be 1-" + std::to_string(kMaxLimit) + ", offset 0-" +
+                                   std::to_string(kMaxOffset));
+    }
+    query.limit = *limit;
+    query.offset = *offset;
+
+    const auto result = storage_service_.SearchNews(query);
+    if (!result) {
+      request.GetHttpResponse().SetHeader(std::string("Retry-After"), std::string("5"));
+      return MakeErrorResponse(request, server::http::HttpStatus::kServiceUnavailable,
+                               "Search index is not ready");
+    }
+
+    std::vector<int> ids;
+    ids.reserve(result->hits.size());
+    for (const auto& hit : result->hits) {
+      ids.push_back(hit.news_id);
+    }
+
+    // Listing columns only: the page never shows the article body. A row
+    // removed since the search comes back missing and is left out of the page.
+    const auto items = storage_service_.GetNewsSummariesByIds(ids);
+
+    std::string body = "{\"status\":\"success\",\"query\":";
+    AppendJsonString(body, query.text);
+    body += ",\"total\":";
+    body += std::to_string(result->total_matches);
+    body += ",\"count\":";
+    body += std::to_string(items.size());
+    body += ",\"news\":[";
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (i != 0) {
+        body += ',';
+      }
+      body += SerializeNewsSummary(*items[i]);
+    }
+    body += "]}";
+    return body;
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsSearchHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+}  // namespace news_aggregator::handlers
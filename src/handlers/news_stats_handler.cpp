@@ -0,0 +1,86 @@
+#include "news_stats_handler.hpp"
+
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr std::string_view kDefaultWindow = "1h";
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+formats::json::Value MakeCountList(const std::vector<std::pair<std::string, uint64_t>>& counts) {
+  formats::json::ValueBuilder list(formats::common::Type::kArray);
+  for (const auto& [name, count] : counts) {
+    formats::json::ValueBuilder entry;
+    entry["name"] = name;
+    entry["count"] = count;
+    list.PushBack(std::move(entry));
+  }
+  return list.ExtractValue();
+}
+
+std::string MakeErrorResponse(server::http::HttpRequest& request, server::http::HttpStatus status,
+                              const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = NowMs();
+
+  request.GetHttpResponse().SetStatus(status);
+  return formats::json::ToString(error_response.ExtractValue());
+}
+
+}  // namespace
+
+NewsStatsHandler::NewsStatsHandler(const components::ComponentConfig& config,
+                                   const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsStatsHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    std::string window_text = request.GetArg("window");
+    if (window_text.empty()) {
+      window_text = std::string(kDefaultWindow);
+    }
+    const auto window = storage::ParseStatsWindow(window_text);
+    if (!window) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                               "window must be 1-60m, 1-48h or 1-90d");
+    }
+
+    const auto stats = storage_service_.GetIngestStats(*window);
+    if (!stats) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kNotFound, "Ingest stats are disabled");
+    }
+
+    formats::json::ValueBuilder response;
+    response["status"] = "success";
+    response["window"] = window_text;
+    response["from"] = stats->from_us / 1000;
+    response["to"] = NowMs();
+    response["total"] = stats->total;
+    response["sources"] = MakeCountList(stats->by_source);
+    response["categories"] = MakeCountList(stats->by_category);
+    return formats::json::ToString(response.ExtractValue());
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsStatsHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+}  // namespace news_aggregator::handlers
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <userver/components/component_context.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+
+#include "../storage/storage_service.hpp"
+
+namespace news_aggregator::handlers {
+
+// GET /news/stats?window=1h: rows ingested per source and category across all
+// instances, served from in-memory counters instead of scanning the news
+// table. The window is 1-60m, 1-48h or 1-90d and defaults to 1h.
+class NewsStatsHandler final : public server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "news-stats-handler";
+
+  NewsStatsHandler(const components::ComponentConfig& config,
+                   const components::ComponentContext& component_context);
+
+  std::string HandleRequest(
+      server::http::HttpRequest& request,
+      server::request::RequestContext&) const override;
+
+ private:
+  storage::StorageService& storage_service_;
+};
+
+}  // namespace news_aggregator::handlers
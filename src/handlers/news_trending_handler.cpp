@@ -0,0 +1,84 @@
+#include "news_trending_handler.hpp"
+
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/logging/log.hpp>
+#include <cmath>
+
+namespace news_aggregator::handlers {
+
+namespace {
+
+constexpr int kDefaultLimit = 20;
+constexpr int kMaxLimit = 100;
+
+std::string MakeErrorResponse(server::http::HttpRequest& request, server::http::HttpStatus status,
+                              const std::string& message) {
+  formats::json::ValueBuilder error_response;
+  error_response["status"] = "error";
+  error_response["message"] = message;
+  error_response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  request.GetHttpResponse().SetStatus(status);
+  return formats::json::ToString(error_response.ExtractValue());
+}
+
+}  // namespace
+
+NewsTrendingHandler::NewsTrendingHandler(const components::ComponentConfig& config,
+                                         const components::ComponentContext& component_context)
+    : HttpHandlerBase(config, component_context),
+      storage_service_(component_context.FindComponent<storage::StorageService>()) {}
+
+std::string NewsTrendingHandler::HandleRequest(
+    server::http::HttpRequest& request,
+    server::request::RequestContext&) const {
+
+  request.GetHttpResponse().SetContentType(http::content_type::kApplicationJson);
+
+  try {
+    int limit = kDefaultLimit;
+    const auto& limit_arg = request.GetArg("limit");
+    if (!limit_arg.empty()) {
+      try {
+        limit = std::stoi(limit_arg);
+      } catch (const std::exception&) {
+        limit = 0;
+      }
+      if (limit <= 0 || limit > kMaxLimit) {
+        return MakeErrorResponse(request, server::http::HttpStatus::kBadRequest,
+                                 "limit must be 1-" + std::to_string(kMaxLimit));
+      }
+    }
+
+    const auto trending = storage_service_.GetTrending(limit);
+    if (!trending) {
+      return MakeErrorResponse(request, server::http::HttpStatus::kNotFound, "Trending is disabled");
+    }
+
+    formats::json::ValueBuilder terms(formats::common::Type::kArray);
+    for (const auto& term : *trending) {
+      formats::json::ValueBuilder entry;
+      entry["term"] = term.term;
+      entry["count"] = term.count;
+      entry["expected"] = std::round(term.expected * 10) / 10;
+      entry["score"] = std::round(term.score * 100) / 100;
+      entry["sources"] = term.sources;
+      terms.PushBack(std::move(entry));
+    }
+
+    formats::json::ValueBuilder response;
+    response["status"] = "success";
+    response["count"] = trending->size();
+    response["terms"] = std::move(terms);
+    return formats::json::ToString(response.ExtractValue());
+
+  } catch (const std::exception& ex) {
+    LOG_ERROR() << "Error in NewsTrendingHandler: " << ex.what();
+    return MakeErrorResponse(request, server::http::HttpStatus::kInternalServerError, "Internal server error");
+  }
+}
+
+}  // namespace news_aggregator::handlers
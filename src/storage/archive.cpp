@@ -0,0 +1,160 @@
+#include "archive.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+#include "partitions.hpp"
+
+namespace news_aggregator::storage {
+
+namespace {
+
+// Serializes archiving between instances, see kMigrationLockKey
+constexpr std::string_view kArchiveLockKey = "727174003";
+constexpr std::string_view kSegmentExtension = ".seg";
+
+}  // namespace
+
+ArchiveStore::ArchiveStore(std::string directory) : directory_(std::move(directory)) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        throw std::runtime_error("Cannot create archive directory " + directory_ + ": " + error.message());
+    }
+}
+
+void ArchiveStore::Refresh() {
+    auto segments = segments_.StartWrite();
+    std::unordered_set<std::string> mapped;
+    for (const auto& segment : *segments) {
+        mapped.insert(segment->GetPath());
+    }
+    
+    bool changed = false;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        const auto path = entry.path().string();
+        if (!entry.is_regular_file() || entry.path().extension() != kSegmentExtension || mapped.count(path)) {
+            continue;
+        }
+        if (auto reader = SegmentReader::Open(path)) {
+            LOG_INFO() << "Mapped archive segment " << path << " with " << reader->GetRowCount() << " rows";
+            segments->push_back(std::move(reader));
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+    
+    std::sort(segments->begin(), segments->end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->GetMaxCreatedUs() > rhs->GetMaxCreatedUs();
+    });
+    segments.Commit();
+}
+
+std::vector<NewsItem> ArchiveStore::Query(const ArchiveQuery& query) const {
+    const auto segments = segments_.Read();
+    std::vector<NewsItem> result;
+    for (const auto& segment : *segments) {
+        if (static_cast<int>(result.size()) >= query.limit) {
+            break;
+        }
+        if (segment->GetRowCount() == 0 || segment->GetMinCreatedUs() >= query.to_us ||
+            segment->GetMaxCreatedUs() < query.from_us ||
+            (query.before && segment->GetMinCreatedUs() > query.before->created_at_us)) {
+            continue;
+        }
+        if (!segment->Scan(query, result)) {
+            throw std::runtime_error("Corrupt archive segment " + segment->GetPath());
+        }
+    }
+    return result;
+}
+
+int64_t ArchiveStore::GetArchivedBeforeUs() const {
+    int64_t archived_before = std::numeric_limits<int64_t>::min();
+    for (const auto& segment : *segments_.Read()) {
+        if (segment->GetRowCount() != 0) {
+            archived_before = std::max(archived_before, segment->GetMaxCreatedUs() + 1);
+        }
+    }
+    return archived_before;
+}
+
+size_t ArchiveStore::GetSegmentCount() const {
+    return segments_.Read()->size();
+}
+
+size_t ArchiveStore::GetRowCount() const {
+    size_t rows = 0;
+    for (const auto& segment : *segments_.Read()) {
+        rows += segment->GetRowCount();
+    }
+    return rows;
+}
+
+bool ArchiveExpiredPartitions(PostgresClient& client, ArchiveStore& store, int older_than_days) {
+    const auto locked = client.QueryScalar("SELECT pg_try_advisory_lock(" + std::string(kArchiveLockKey) + ")");
+    if (!locked) {
+        return false;
+    }
+    if (*locked != "t") {
+        LOG_DEBUG() << "Archiving is running on another instance";
+        return true;
+    }
+    
+    bool success = true;
+    const auto partitions = ListPartitionsEndedBefore(client, older_than_days);
+    if (!partitions) {
+        success = false;
+    }
+    for (const auto& partition : partitions.value_or(std::vector<PartitionRange>{})) {
+        const auto path = (std::filesystem::path(store.GetDirectory()) /
+                           (partition.name + std::string(kSegmentExtension))).string();
+        
+        // A segment left by a run that stopped before the drop is complete:
+        // it was only renamed into place after fsync. Its directory entry
+        // may not have been synced yet, so that is repeated before the drop.
+        size_t rows = 0;
+        if (std::filesystem::exists(path)) {
+            if (!SyncDirectory(store.GetDirectory())) {
+                success = false;
+                break;
+            }
+        } else {
+            SegmentWriter writer(path);
+            bool written = true;
+            const auto status = client.StreamNewsCreatedBetween(
+                partition.lower_bound, partition.upper_bound,
+                [&writer, &written](NewsItem&& item) { return written = writer.Add(item); });
+            if (status != PostgresClient::StreamStatus::kDone || !written) {
+                LOG_ERROR() << "Failed to read partition " << partition.name << " for archiving";
+                success = false;
+                break;
+            }
+            rows = writer.GetRowCount();
+            if (rows != 0 && !writer.Finish()) {
+                success = false;
+                break;
+            }
+        }
+        store.Refresh();
+        
+        // Expires this partition; older ones are already gone
+        const auto dropped = client.QueryScalar(
+            "SELECT COUNT(*) FROM news_expire_partitions(" + client.EscapeString(partition.upper_bound) +
+            "::TIMESTAMPTZ, TRUE)");
+        if (!dropped) {
+            success = false;
+            break;
+        }
+        LOG_INFO() << "Archived partition " << partition.name << " (" << rows << " rows) to " << path;
+    }
+    
+    client.Execute("SELECT pg_advisory_unlock(" + std::string(kArchiveLockKey) + ")");
+    return success;
+}
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <userver/rcu/rcu.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "archive_segment.hpp"
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// The segment files of one archive directory, mapped into memory. Queries run
+// against an RCU snapshot of the segment list and never block the archiver.
+class ArchiveStore {
+public:
+    explicit ArchiveStore(std::string directory);
+
+    const std::string& GetDirectory() const { return directory_; }
+
+    // Maps segment files of the directory that are not mapped yet
+    void Refresh();
+
+    // Newest first across every segment
+    std::vector<NewsItem> Query(const ArchiveQuery& query) const;
+
+    // Every row created before this is archived: one past the newest archived
+    // row, whose partition and all older ones are gone from the table. The
+    // minimum int64_t while no segment is mapped.
+    int64_t GetArchivedBeforeUs() const;
+
+    size_t GetSegmentCount() const;
+    size_t GetRowCount() const;
+
+private:
+    // Ordered by time, newest first
+    using Segments = std::vector<std::shared_ptr<const SegmentReader>>;
+
+    const std::string directory_;
+    rcu::Variable<Segments> segments_;
+};
+
+// Writes every partition that ended more than `older_than_days` ago into a
+// segment file, then drops the partition. Safe to run from several instances
+// sharing the archive directory.
+bool ArchiveExpiredPartitions(PostgresClient& client, ArchiveStore& store, int older_than_days);
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,522 @@
+#include "archive_segment.hpp"
+#include <userver/logging/log.hpp>
+#include <zstd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr std::string_view kMagic = "NEWSSEG1";
+constexpr size_t kTrailerSize = 8 + 4 + 8;  // footer offset, footer size, magic
+constexpr int kZstdLevel = 9;              // written once, read rarely
+constexpr size_t kMaxColumnBytes = 256 * 1024 * 1024;
+
+enum Column : size_t {
+    kCreatedAt,
+    kId,
+    kSource,
+    kCategory,
+    kTitle,
+    kSnippet,
+    kUrl,
+    kPublishedAt,
+    kContent,
+    kColumnCount,
+};
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(static_cast<uint8_t>(value) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void PutFixed(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void PutString(std::string& out, std::string_view value) {
+    PutVarint(out, value.size());
+    out.append(value);
+}
+
+uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Bounds-checked decoding: a truncated or corrupt file sets `ok` instead of
+// reading past the mapping
+struct ByteReader {
+    const uint8_t* data;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data == end) {
+                ok = false;
+                return 0;
+            }
+            const uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint64_t Fixed(size_t bytes) {
+        if (static_cast<size_t>(end - data) < bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        }
+        data += bytes;
+        return value;
+    }
+
+    std::string_view Bytes(uint64_t size) {
+        if (static_cast<uint64_t>(end - data) < size) {
+            ok = false;
+            return {};
+        }
+        std::string_view value(reinterpret_cast<const char*>(data), size);
+        data += size;
+        return value;
+    }
+};
+
+// Lengths of every row first, then the concatenated values, as one zstd frame
+std::optional<std::string> EncodeText(const std::vector<std::string_view>& values) {
+    std::string raw;
+    size_t total = 0;
+    for (const auto value : values) {
+        PutVarint(raw, value.size());
+        total += value.size();
+    }
+    raw.reserve(raw.size() + total);
+    for (const auto value : values) {
+        raw.append(value);
+    }
+    
+    std::string compressed(ZSTD_compressBound(raw.size()), '\0');
+    const size_t size = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), kZstdLevel);
+    if (ZSTD_isError(size)) {
+        LOG_ERROR() << "zstd compression failed: " << ZSTD_getErrorName(size);
+        return std::nullopt;
+    }
+    compressed.resize(size);
+    return compressed;
+}
+
+// Decompresses into `buffer`; the returned views point into it
+std::optional<std::vector<std::string_view>> DecodeText(std::string_view frame, size_t rows, std::string& buffer) {
+    const auto raw_size = ZSTD_getFrameContentSize(frame.data(), frame.size());
+    if (raw_size == ZSTD_CONTENTSIZE_ERROR || raw_size == ZSTD_CONTENTSIZE_UNKNOWN || raw_size > kMaxColumnBytes) {
+        return std::nullopt;
+    }
+    buffer.resize(raw_size);
+    const size_t size = ZSTD_decompress(buffer.data(), buffer.size(), frame.data(), frame.size());
+    if (ZSTD_isError(size) || size != raw_size) {
+        return std::nullopt;
+    }
+    
+    ByteReader reader{reinterpret_cast<const uint8_t*>(buffer.data()),
+                      reinterpret_cast<const uint8_t*>(buffer.data()) + buffer.size()};
+    std::vector<uint64_t> lengths(rows);
+    for (auto& length : lengths) {
+        length = reader.Varint();
+    }
+    std::vector<std::string_view> values(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        values[i] = reader.Bytes(lengths[i]);
+    }
+    if (!reader.ok) {
+        return std::nullopt;
+    }
+    return values;
+}
+
+}  // namespace
+
+SegmentWriter::SegmentWriter(std::string path) : path_(std::move(path)), temp_path_(path_ + ".tmp") {
+    file_ = std::fopen(temp_path_.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR() << "Failed to create archive segment " << temp_path_ << ": " << std::strerror(errno);
+        failed_ = true;
+        return;
+    }
+    failed_ = !Write(kMagic);
+}
+
+SegmentWriter::~SegmentWriter() {
+    if (file_) {
+        std::fclose(file_);
+        std::remove(temp_path_.c_str());
+    }
+}
+
+bool SegmentWriter::Write(std::string_view data) {
+    if (failed_ || std::fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+        failed_ = true;
+        return false;
+    }
+    offset_ += data.size();
+    return true;
+}
+
+uint32_t SegmentWriter::Code(std::unordered_map<std::string, uint32_t>& codes, std::vector<std::string>& dictionary,
+                             const std::string& value) {
+    const auto [it, inserted] = codes.emplace(value, static_cast<uint32_t>(dictionary.size()));
+    if (inserted) {
+        dictionary.push_back(value);
+    }
+    return it->second;
+}
+
+bool SegmentWriter::Add(const NewsItem& item) {
+    if (failed_) {
+        return false;
+    }
+    pending_.push_back(item);
+    ++row_count_;
+    return pending_.size() < kBlockRows || FlushBlock();
+}
+
+bool SegmentWriter::FlushBlock() {
+    if (pending_.empty()) {
+        return !failed_;
+    }
+    
+    std::array<std::string, kColumnCount> columns;
+    int64_t previous_created_us = pending_.front().created_at_us;
+    int64_t previous_id = 0;
+    for (const auto& item : pending_) {
+        PutVarint(columns[kCreatedAt], static_cast<uint64_t>(item.created_at_us - previous_created_us));
+        previous_created_us = item.created_at_us;
+        PutVarint(columns[kId], ZigZag(static_cast<int64_t>(item.id) - previous_id));
+        previous_id = item.id;
+        PutVarint(columns[kSource], Code(source_codes_, sources_, item.source));
+        PutVarint(columns[kCategory], Code(category_codes_, categories_, item.category));
+    }
+    
+    const std::array<std::pair<Column, std::string NewsItem::*>, 5> text_columns = {{
+        {kTitle, &NewsItem::title},
+        {kSnippet, &NewsItem::snippet},
+        {kUrl, &NewsItem::url},
+        {kPublishedAt, &NewsItem::published_at},
+        {kContent, &NewsItem::content},
+    }};
+    std::vector<std::string_view> values(pending_.size());
+    for (const auto& [column, field] : text_columns) {
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            values[i] = pending_[i].*field;
+        }
+        auto encoded = EncodeText(values);
+        if (!encoded) {
+            failed_ = true;
+            return false;
+        }
+        columns[column] = std::move(*encoded);
+    }
+    
+    BlockInfo block{pending_.front().created_at_us, pending_.back().created_at_us,
+                    static_cast<uint32_t>(pending_.size()), offset_, {}};
+    for (const auto& column : columns) {
+        block.column_sizes.push_back(static_cast<uint32_t>(column.size()));
+        if (!Write(column)) {
+            return false;
+        }
+    }
+    blocks_.push_back(std::move(block));
+    pending_.clear();
+    return true;
+}
+
+bool SegmentWriter::Finish() {
+    if (!file_ || !FlushBlock()) {
+        return false;
+    }
+    
+    std::string footer;
+    PutVarint(footer, blocks_.size());
+    for (const auto& block : blocks_) {
+        PutFixed(footer, static_cast<uint64_t>(block.first_created_us), 8);
+        PutFixed(footer, static_cast<uint64_t>(block.last_created_us), 8);
+        PutVarint(footer, block.rows);
+        PutFixed(footer, block.offset, 8);
+        for (const auto size : block.column_sizes) {
+            PutVarint(footer, size);
+        }
+    }
+    for (const auto* dictionary : {&sources_, &categories_}) {
+        PutVarint(footer, dictionary->size());
+        for (const auto& value : *dictionary) {
+            PutString(footer, value);
+        }
+    }
+    
+    std::string trailer;
+    PutFixed(trailer, offset_, 8);
+    PutFixed(trailer, footer.size(), 4);
+    trailer.append(kMagic);
+    if (!Write(footer) || !Write(trailer)) {
+        return false;
+    }
+    
+    // The rename publishes the file, so its contents must be durable first
+    const bool flushed = std::fflush(file_) == 0 && fsync(fileno(file_)) == 0;
+    const bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    if (!flushed || !closed || std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        LOG_ERROR() << "Failed to publish archive segment " << path_ << ": " << std::strerror(errno);
+        std::remove(temp_path_.c_str());
+        return false;
+    }
+    // ...and so must the directory entry, before the caller drops the rows
+    return SyncDirectory(std::filesystem::path(path_).parent_path().string());
+}
+
+bool SyncDirectory(const std::string& directory) {
+    const int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR() << "Failed to open directory " << directory << ": " << std::strerror(errno);
+        return false;
+    }
+    const bool synced = fsync(fd) == 0;
+    if (!synced) {
+        LOG_ERROR() << "Failed to fsync directory " << directory << ": " << std::strerror(errno);
+    }
+    close(fd);
+    return synced;
+}
+
+std::unique_ptr<SegmentReader> SegmentReader::Open(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR() << "Failed to open archive segment " << path << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kMagic.size() + kTrailerSize) {
+        close(fd);
+        LOG_ERROR() << "Archive segment " << path << " is truncated";
+        return nullptr;
+    }
+    
+    const size_t size = info.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR() << "Failed to map archive segment " << path << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    // Queries touch a few blocks, not the whole file
+    madvise(mapping, size, MADV_RANDOM);
+    
+    std::unique_ptr<SegmentReader> reader(new SegmentReader());
+    reader->path_ = path;
+    reader->data_ = static_cast<const uint8_t*>(mapping);
+    reader->size_ = size;
+    
+    const auto* data = reader->data_;
+    ByteReader trailer{data + size - kTrailerSize, data + size};
+    const uint64_t footer_offset = trailer.Fixed(8);
+    const uint64_t footer_size = trailer.Fixed(4);
+    const bool magic_ok = std::memcmp(data, kMagic.data(), kMagic.size()) == 0 &&
+                          trailer.Bytes(kMagic.size()) == kMagic;
+    if (!magic_ok || footer_offset < kMagic.size() || footer_offset + footer_size != size - kTrailerSize) {
+        LOG_ERROR() << "Archive segment " << path << " has an invalid trailer";
+        return nullptr;
+    }
+    
+    ByteReader footer{data + footer_offset, data + footer_offset + footer_size};
+    const uint64_t block_count = footer.Varint();
+    for (uint64_t i = 0; i < block_count && footer.ok; ++i) {
+        BlockInfo block;
+        block.first_created_us = static_cast<int64_t>(footer.Fixed(8));
+        block.last_created_us = static_cast<int64_t>(footer.Fixed(8));
+        block.rows = static_cast<uint32_t>(footer.Varint());
+        block.offset = footer.Fixed(8);
+        uint64_t block_size = 0;
+        for (size_t column = 0; column < kColumnCount; ++column) {
+            block.column_sizes.push_back(static_cast<uint32_t>(footer.Varint()));
+            block_size += block.column_sizes.back();
+        }
+        if (block.offset + block_size > footer_offset) {
+            footer.ok = false;
+        }
+        reader->row_count_ += block.rows;
+        reader->blocks_.push_back(std::move(block));
+    }
+    for (auto* dictionary : {&reader->sources_, &reader->categories_}) {
+        const uint64_t count = footer.Varint();
+        for (uint64_t i = 0; i < count && footer.ok; ++i) {
+            dictionary->emplace_back(footer.Bytes(footer.Varint()));
+        }
+    }
+    if (!footer.ok) {
+        LOG_ERROR() << "Archive segment " << path << " has a corrupt footer";
+        return nullptr;
+    }
+    return reader;
+}
+
+SegmentReader::~SegmentReader() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+int64_t SegmentReader::GetMinCreatedUs() const {
+    return blocks_.empty() ? 0 : blocks_.front().first_created_us;
+}
+
+int64_t SegmentReader::GetMaxCreatedUs() const {
+    return blocks_.empty() ? 0 : blocks_.back().last_created_us;
+}
+
+bool SegmentReader::Scan(const ArchiveQuery& query, std::vector<NewsItem>& out) const {
+    auto find_code = [](const std::vector<std::string>& dictionary, const std::string& value) -> std::optional<int64_t> {
+        if (value.empty()) {
+            return -1;  // no filter
+        }
+        const auto it = std::find(dictionary.begin(), dictionary.end(), value);
+        if (it == dictionary.end()) {
+            return std::nullopt;
+        }
+        return it - dictionary.begin();
+    };
+    const auto source_code = find_code(sources_, query.source);
+    const auto category_code = find_code(categories_, query.category);
+    if (!source_code || !category_code) {
+        return true;
+    }
+    
+    const size_t limit = static_cast<size_t>(std::max(0, query.limit));
+    std::vector<int64_t> created(SegmentWriter::kBlockRows);
+    std::vector<int> ids(SegmentWriter::kBlockRows);
+    std::vector<uint32_t> sources(SegmentWriter::kBlockRows);
+    std::vector<uint32_t> categories(SegmentWriter::kBlockRows);
+    std::vector<size_t> matches;
+    
+    // Blocks are ordered by time, so walk them backwards for newest first
+    for (auto block = blocks_.rbegin(); block != blocks_.rend() && out.size() < limit; ++block) {
+        if (block->last_created_us < query.from_us) {
+            break;
+        }
+        if (block->first_created_us >= query.to_us ||
+            (query.before && block->first_created_us > query.before->created_at_us)) {
+            continue;
+        }
+        
+        std::array<std::string_view, kColumnCount> columns;
+        uint64_t offset = block->offset;
+        for (size_t column = 0; column < kColumnCount; ++column) {
+            columns[column] = std::string_view(reinterpret_cast<const char*>(data_ + offset), block->column_sizes[column]);
+            offset += block->column_sizes[column];
+        }
+        auto reader_of = [](std::string_view column) {
+            return ByteReader{reinterpret_cast<const uint8_t*>(column.data()),
+                              reinterpret_cast<const uint8_t*>(column.data()) + column.size()};
+        };
+        
+        const size_t rows = std::min<size_t>(block->rows, SegmentWriter::kBlockRows);
+        auto created_reader = reader_of(columns[kCreatedAt]);
+        auto id_reader = reader_of(columns[kId]);
+        auto source_reader = reader_of(columns[kSource]);
+        auto category_reader = reader_of(columns[kCategory]);
+        int64_t created_us = block->first_created_us;
+        int64_t id = 0;
+        for (size_t row = 0; row < rows; ++row) {
+            created_us += static_cast<int64_t>(created_reader.Varint());
+            created[row] = created_us;
+            id += UnZigZag(id_reader.Varint());
+            ids[row] = static_cast<int>(id);
+            sources[row] = static_cast<uint32_t>(source_reader.Varint());
+            categories[row] = static_cast<uint32_t>(category_reader.Varint());
+        }
+        const bool codes_ok = std::all_of(sources.begin(), sources.begin() + rows,
+                                          [this](uint32_t code) { return code < sources_.size(); }) &&
+                              std::all_of(categories.begin(), categories.begin() + rows,
+                                          [this](uint32_t code) { return code < categories_.size(); });
+        if (!created_reader.ok || !id_reader.ok || !source_reader.ok || !category_reader.ok || !codes_ok) {
+            LOG_ERROR() << "Corrupt block in archive segment " << path_;
+            return false;
+        }
+        
+        matches.clear();
+        for (size_t row = rows; row-- > 0 && out.size() + matches.size() < limit;) {
+            if (created[row] < query.from_us || created[row] >= query.to_us) {
+                continue;
+            }
+            if (query.before && (created[row] > query.before->created_at_us ||
+                                 (created[row] == query.before->created_at_us && ids[row] >= query.before->id))) {
+                continue;
+            }
+            if ((*source_code >= 0 && sources[row] != *source_code) ||
+                (*category_code >= 0 && categories[row] != *category_code)) {
+                continue;
+            }
+            matches.push_back(row);
+        }
+        if (matches.empty()) {
+            continue;
+        }
+        
+        // Only now pay for decompression, and only for the columns asked for
+        std::array<std::string, kColumnCount> buffers;
+        std::array<std::vector<std::string_view>, kColumnCount> text;
+        for (const Column column : {kTitle, kSnippet, kUrl, kPublishedAt, kContent}) {
+            if (column == kContent && !query.with_content) {
+                continue;
+            }
+            auto values = DecodeText(columns[column], rows, buffers[column]);
+            if (!values) {
+                LOG_ERROR() << "Corrupt text column in archive segment " << path_;
+                return false;
+            }
+            text[column] = std::move(*values);
+        }
+        
+        for (const size_t row : matches) {
+            NewsItem item;
+            item.id = ids[row];
+            item.created_at_us = created[row];
+            item.source = sources_[sources[row]];
+            item.category = categories_[categories[row]];
+            item.title = std::string(text[kTitle][row]);
+            item.snippet = std::string(text[kSnippet][row]);
+            item.url = std::string(text[kUrl][row]);
+            item.published_at = std::string(text[kPublishedAt][row]);
+            if (query.with_content) {
+                item.content = std::string(text[kContent][row]);
+            }
+            out.push_back(std::move(item));
+        }
+    }
+    return true;
+}
+
+}  // namespace news_aggregator::storage
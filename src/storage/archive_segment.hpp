@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+struct ArchiveQuery {
+    int64_t from_us = std::numeric_limits<int64_t>::min();  // inclusive
+    int64_t to_us = std::numeric_limits<int64_t>::max();    // exclusive
+    std::optional<NewsCursor> before;
+    std::string category;  // empty = any category
+    std::string source;    // empty = any source
+    int limit = 10;
+    bool with_content = false;  // summaries only read the small text columns
+};
+
+// Immutable columnar file of archived rows ordered by (created_at, id).
+//
+// Rows are grouped into blocks of kBlockRows. Inside a block every column is
+// stored separately: created_at as varint deltas, id as zigzag varint deltas,
+// source and category as varint codes into per-file dictionaries, and each text
+// column as its own zstd frame, so a listing never decompresses `content`.
+// The footer holds the dictionaries and one entry per block with its time
+// range and column sizes, which is the sparse time index used to skip blocks.
+//
+//   "NEWSSEG1" | block... | footer | footer offset (8) | footer size (4) | "NEWSSEG1"
+class SegmentWriter {
+public:
+    static constexpr size_t kBlockRows = 256;
+
+    // Writes to `path` + ".tmp" and renames it into place on Finish()
+    explicit SegmentWriter(std::string path);
+    ~SegmentWriter();
+
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+    // Rows must arrive ordered by (created_at, id)
+    bool Add(const NewsItem& item);
+    // Flushes, fsyncs and publishes the file, then fsyncs the directory so the
+    // rename survives a crash. False means the file may not be durable.
+    bool Finish();
+
+    size_t GetRowCount() const { return row_count_; }
+
+private:
+    struct BlockInfo {
+        int64_t first_created_us;
+        int64_t last_created_us;
+        uint32_t rows;
+        uint64_t offset;
+        std::vector<uint32_t> column_sizes;
+    };
+
+    bool FlushBlock();
+    bool Write(std::string_view data);
+    uint32_t Code(std::unordered_map<std::string, uint32_t>& codes, std::vector<std::string>& dictionary,
+                  const std::string& value);
+
+    std::string path_;
+    std::string temp_path_;
+    std::FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    bool failed_ = false;
+    size_t row_count_ = 0;
+    std::vector<NewsItem> pending_;
+    std::vector<BlockInfo> blocks_;
+    std::unordered_map<std::string, uint32_t> source_codes_;
+    std::vector<std::string> sources_;
+    std::unordered_map<std::string, uint32_t> category_codes_;
+    std::vector<std::string> categories_;
+};
+
+// fsyncs `directory`, which makes renames into it durable
+bool SyncDirectory(const std::string& directory);
+
+// Read-only view of a segment file through mmap. Thread-safe.
+class SegmentReader {
+public:
+    // nullptr when the file cannot be mapped or is not a valid segment
+    static std::unique_ptr<SegmentReader> Open(const std::string& path);
+    ~SegmentReader();
+
+    SegmentReader(const SegmentReader&) = delete;
+    SegmentReader& operator=(const SegmentReader&) = delete;
+
+    const std::string& GetPath() const { return path_; }
+    int64_t GetMinCreatedUs() const;
+    int64_t GetMaxCreatedUs() const;
+    size_t GetRowCount() const { return row_count_; }
+
+    // Appends the rows matching `query`, newest first, until `out` holds
+    // query.limit rows; false if a block turns out to be corrupt
+    bool Scan(const ArchiveQuery& query, std::vector<NewsItem>& out) const;
+
+private:
+    struct BlockInfo {
+        int64_t first_created_us;
+        int64_t last_created_us;
+        uint32_t rows;
+        uint64_t offset;
+        std::vector<uint32_t> column_sizes;
+    };
+
+    SegmentReader() = default;
+
+    std::string path_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t row_count_ = 0;
+    std::vector<BlockInfo> blocks_;
+    std::vector<std::string> sources_;
+    std::vector<std::string> categories_;
+};
+
+}  // namespace news_aggregator::storage
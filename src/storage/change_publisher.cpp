@@ -0,0 +1,106 @@
+#include "change_publisher.hpp"
+#include <userver/formats/json/serialize.hpp>
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr size_t kMaxNames = 32;
+constexpr std::chrono::seconds kReconnectBackoff{1};
+constexpr int kRedisTimeoutMs = 200;
+
+}  // namespace
+
+void ChangePublisher::Merge(PendingEvent& into, const PendingEvent& from) {
+    into.max_id = std::max(into.max_id, from.max_id);
+    into.count += from.count;
+    into.names_truncated = into.names_truncated || from.names_truncated;
+    if (!into.names_truncated) {
+        into.categories.insert(from.categories.begin(), from.categories.end());
+        into.sources.insert(from.sources.begin(), from.sources.end());
+        into.names_truncated = into.categories.size() > kMaxNames || into.sources.size() > kMaxNames;
+    }
+    if (into.names_truncated) {
+        into.categories.clear();
+        into.sources.clear();
+    }
+}
+
+ChangePublisher::ChangePublisher(const std::string& host, int port, std::string channel)
+    : channel_(std::move(channel)), client_(std::make_unique<common::RedisClient>(host, port, kRedisTimeoutMs)) {
+}
+
+void ChangePublisher::Record(const std::vector<NewsItem>& inserted) {
+    PendingEvent batch;
+    for (const auto& item : inserted) {
+        batch.max_id = std::max(batch.max_id, item.id);
+        ++batch.count;
+        batch.categories.insert(item.category);
+        batch.sources.insert(item.source);
+    }
+    std::lock_guard<engine::Mutex> lock(mutex_);
+    Merge(pending_, batch);
+}
+
+void ChangePublisher::Flush() {
+    PendingEvent event;
+    {
+        std::lock_guard<engine::Mutex> lock(mutex_);
+        if (pending_.count == 0) {
+            return;
+        }
+        event = std::move(pending_);
+        pending_ = PendingEvent{};
+    }
+
+    if (!client_->IsConnected()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_connect_attempt_ >= kReconnectBackoff) {
+            last_connect_attempt_ = now;
+            client_->Connect();
+        }
+    }
+    if (client_->IsConnected() && client_->Publish(channel_, Serialize(event))) {
+        ++published_;
+        return;
+    }
+
+    // Put it back; caches fall back to their TTL until an event gets through
+    ++failed_;
+    std::lock_guard<engine::Mutex> lock(mutex_);
+    Merge(pending_, event);
+}
+
+ChangePublisherStats ChangePublisher::GetStats() const {
+    ChangePublisherStats stats;
+    stats.published = published_.load();
+    stats.failed = failed_.load();
+    std::lock_guard<engine::Mutex> lock(mutex_);
+    stats.pending_rows = pending_.count;
+    return stats;
+}
+
+std::string ChangePublisher::Serialize(const PendingEvent& event) {
+    formats::json::ValueBuilder builder;
+    builder["max_id"] = event.max_id;
+    builder["count"] = event.count;
+    if (!event.names_truncated) {
+        formats::json::ValueBuilder categories(formats::common::Type::kArray);
+        for (const auto& category : event.categories) {
+            categories.PushBack(category);
+        }
+        builder["categories"] = categories.ExtractValue();
+        formats::json::ValueBuilder sources(formats::common::Type::kArray);
+        for (const auto& source : event.sources) {
+            sources.PushBack(source);
+        }
+        builder["sources"] = sources.ExtractValue();
+    }
+    return formats::json::ToString(builder.ExtractValue());
+}
+
+}  // namespace news_aggregator::storage
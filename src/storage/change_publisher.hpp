@@ -0,0 +1,65 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "postgres_client.hpp"
+#include "../common/redis_client.hpp"
+
+namespace news_aggregator::storage {
+
+struct ChangePublisherStats {
+    uint64_t published = 0;
+    uint64_t failed = 0;
+    uint64_t pending_rows = 0;
+};
+
+// Tells caches that news changed. Committed inserts are merged into one
+// pending event, which a background task publishes on a Redis channel at most
+// once per flush interval, e.g.
+//   {"max_id":1234,"count":3,"categories":["technology"],"sources":["TechCrunch"]}
+// The name lists are left out when a batch touches more than a few dozen names.
+class ChangePublisher {
+public:
+    ChangePublisher(const std::string& host, int port, std::string channel);
+
+    // Never blocks on Redis
+    void Record(const std::vector<NewsItem>& inserted);
+    // Publishes the pending event, if any. Blocking. On failure the event is
+    // kept and merged with later inserts.
+    void Flush();
+
+    ChangePublisherStats GetStats() const;
+
+private:
+    struct PendingEvent {
+        int max_id = 0;
+        uint64_t count = 0;
+        std::set<std::string> categories;
+        std::set<std::string> sources;
+        bool names_truncated = false;
+    };
+
+    // Keeps the name lists only while they stay short
+    static void Merge(PendingEvent& into, const PendingEvent& from);
+    static std::string Serialize(const PendingEvent& event);
+
+    const std::string channel_;
+    // Only used by Flush, which runs on one background task
+    std::unique_ptr<common::RedisClient> client_;
+    std::chrono::steady_clock::time_point last_connect_attempt_{};
+
+    mutable engine::Mutex mutex_;
+    PendingEvent pending_;
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> failed_{0};
+};
+
+}  // namespace news_aggregator::storage
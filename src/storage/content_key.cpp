@@ -0,0 +1,140 @@
+#include "content_key.hpp"
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t Hash64(std::string_view tag, std::string_view value) {
+    uint64_t hash = kFnvOffsetBasis;
+    auto feed = [&hash](std::string_view bytes) {
+        for (unsigned char c : bytes) {
+            hash ^= c;
+            hash *= kFnvPrime;
+        }
+    };
+    feed(tag);
+    feed(std::string_view("\0", 1));
+    feed(value);
+    
+    // splitmix64 finalizer: FNV alone mixes the high bits poorly
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool IsTrackingParameter(std::string_view param) {
+    const auto name = param.substr(0, param.find('='));
+    return name.substr(0, 4) == "utm_" || name == "fbclid" || name == "gclid" ||
+           name == "yclid" || name == "mc_cid" || name == "mc_eid";
+}
+
+bool LooksLikeUrl(std::string_view text) {
+    return text.find("://") != std::string_view::npos;
+}
+
+}  // namespace
+
+std::string NormalizeUrl(std::string_view url) {
+    url = Trim(url);
+    
+    const auto fragment = url.find('#');
+    if (fragment != std::string_view::npos) {
+        url = url.substr(0, fragment);
+    }
+    
+    // http and https copies of a story are the same story
+    const auto scheme_end = url.find("://");
+    if (scheme_end != std::string_view::npos) {
+        url.remove_prefix(scheme_end + 3);
+    }
+    
+    const auto authority_end = std::min(url.find('/'), url.find('?'));
+    std::string host(url.substr(0, authority_end));
+    url = authority_end == std::string_view::npos ? std::string_view{} : url.substr(authority_end);
+    std::transform(host.begin(), host.end(), host.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    
+    const auto port = host.rfind(':');
+    if (port != std::string::npos) {
+        const auto port_value = std::string_view(host).substr(port + 1);
+        if (port_value == "80" || port_value == "443" || port_value.empty()) {
+            host.erase(port);
+        }
+    }
+    if (host.substr(0, 4) == "www.") {
+        host.erase(0, 4);
+    }
+    
+    std::string_view path = url.substr(0, url.find('?'));
+    std::string_view query = path.size() < url.size() ? url.substr(path.size() + 1) : std::string_view{};
+    while (path.size() > 1 && path.back() == '/') {
+        path.remove_suffix(1);
+    }
+    if (path == "/") {
+        path = {};
+    }
+    
+    std::vector<std::string_view> params;
+    while (!query.empty()) {
+        const auto amp = query.find('&');
+        const auto param = query.substr(0, amp);
+        if (!param.empty() && !IsTrackingParameter(param)) {
+            params.push_back(param);
+        }
+        query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+    }
+    std::sort(params.begin(), params.end());
+    
+    std::string normalized = host;
+    normalized.append(path);
+    for (size_t i = 0; i < params.size(); ++i) {
+        normalized += i == 0 ? '?' : '&';
+        normalized.append(params[i]);
+    }
+    return normalized;
+}
+
+int64_t ComputeContentKey(std::string_view url, std::string_view guid,
+                          std::string_view source, std::string_view title) {
+    url = Trim(url);
+    guid = Trim(guid);
+    
+    uint64_t hash = 0;
+    if (!url.empty()) {
+        hash = Hash64("url", NormalizeUrl(url));
+    } else if (!guid.empty()) {
+        // Permalink GUIDs must agree with the key of the same story seen by URL
+        hash = LooksLikeUrl(guid) ? Hash64("url", NormalizeUrl(guid)) : Hash64("guid", guid);
+    } else {
+        std::string fallback(Trim(source));
+        fallback += '\n';
+        fallback.append(Trim(title));
+        hash = Hash64("title", fallback);
+    }
+    return static_cast<int64_t>(hash);
+}
+
+int64_t ComputeContentKey(const NewsItem& item) {
+    return ComputeContentKey(item.url, item.guid, item.source, item.title);
+}
+
+}  // namespace news_aggregator::storage
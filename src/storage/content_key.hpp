@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// Canonical form of a story URL: no scheme, lower-case host, no default port,
+// fragment or tracking parameters (utm_*, fbclid, gclid), no trailing slash.
+std::string NormalizeUrl(std::string_view url);
+
+// Stable 64-bit identity of a story, stored in news.content_key.
+// The normalized URL is preferred, then the feed GUID, then source + title.
+int64_t ComputeContentKey(std::string_view url, std::string_view guid,
+                          std::string_view source, std::string_view title);
+int64_t ComputeContentKey(const NewsItem& item);
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,281 @@
+#include "hot_set.hpp"
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+bool IsNewer(const NewsItemPtr& lhs, const NewsItemPtr& rhs) {
+    if (lhs->created_at_us != rhs->created_at_us) {
+        return lhs->created_at_us > rhs->created_at_us;
+    }
+    return lhs->id > rhs->id;
+}
+
+bool IsBefore(const NewsItem& item, const NewsCursor& cursor) {
+    if (item.created_at_us != cursor.created_at_us) {
+        return item.created_at_us < cursor.created_at_us;
+    }
+    return item.id < cursor.id;
+}
+
+struct MergeResult {
+    // Newest first, at most `capacity`
+    std::vector<NewsItemPtr> items;
+    // Incoming rows that made it into `items`
+    std::vector<NewsItemPtr> added;
+    // Current rows that did not: replaced by an incoming copy or past capacity
+    std::vector<NewsItemPtr> dropped;
+    bool truncated = false;
+};
+
+// Merges two newest-first lists, preferring the incoming copy of a row that
+// is in both: it is the fresher read
+MergeResult MergeNewest(const std::vector<NewsItemPtr>& current, const std::vector<NewsItemPtr>& incoming,
+                        size_t capacity) {
+    MergeResult result;
+    result.items.reserve(std::min(capacity, current.size() + incoming.size()));
+    std::unordered_set<int> seen;
+    seen.reserve(result.items.capacity());
+
+    const auto take = [&](const NewsItemPtr& item, bool is_incoming) {
+        const bool duplicate = !seen.insert(item->id).second;
+        if (duplicate || result.items.size() == capacity) {
+            result.truncated = result.truncated || !duplicate;
+            if (!is_incoming) {
+                result.dropped.push_back(item);
+            }
+            return;
+        }
+        result.items.push_back(item);
+        if (is_incoming) {
+            result.added.push_back(item);
+        }
+    };
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < current.size() || j < incoming.size()) {
+        if (j < incoming.size() && (i == current.size() || !IsNewer(current[i], incoming[j]))) {
+            take(incoming[j++], true);
+        } else {
+            take(current[i++], false);
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+HotSet::HotSet(size_t capacity) : capacity_(capacity) {
+}
+
+uint64_t HotSet::GetVersion() const {
+    return snapshot_.Read()->version;
+}
+
+std::vector<NewsItemPtr> HotSet::ToPointers(std::vector<NewsItem> items) {
+    std::vector<NewsItemPtr> pointers;
+    pointers.reserve(items.size());
+    for (auto& item : items) {
+        pointers.push_back(std::make_shared<const NewsItem>(std::move(item)));
+    }
+    std::sort(pointers.begin(), pointers.end(), IsNewer);
+    return pointers;
+}
+
+void HotSet::Reset(std::vector<NewsItem> items, bool complete, uint64_t loaded_at_version) {
+    const auto incoming = ToPointers(std::move(items));
+    std::lock_guard<engine::Mutex> lock(write_mutex_);
+    const auto current = snapshot_.Read();
+
+    // Only the rows inserted while the load ran survive: the load may have missed them
+    std::vector<NewsItemPtr> kept;
+    for (const auto& item : current->items) {
+        const auto it = inserted_at_.find(item->id);
+        if (it != inserted_at_.end() && it->second > loaded_at_version) {
+            kept.push_back(item);
+        }
+    }
+    const auto merged = MergeNewest(kept, incoming, capacity_);
+
+    HotSetSnapshot next;
+    next.complete = !merged.truncated && complete;
+    next.version = current->version;
+    std::unordered_map<std::string, std::vector<NewsItemPtr>> by_category;
+    std::unordered_map<std::string, std::vector<NewsItemPtr>> by_source;
+    for (const auto& item : merged.items) {
+        by_category[item->category].push_back(item);
+        by_source[item->source].push_back(item);
+        next.id_sum += item->id;
+    }
+    for (auto& [category, list] : by_category) {
+        next.by_category.emplace(category, std::make_shared<const std::vector<NewsItemPtr>>(std::move(list)));
+    }
+    for (auto& [source, list] : by_source) {
+        next.by_source.emplace(source, std::make_shared<const std::vector<NewsItemPtr>>(std::move(list)));
+    }
+    next.items = std::move(merged.items);
+    snapshot_.Assign(std::move(next));
+
+    // Later resets start later, so older insert versions can no longer matter
+    for (auto it = inserted_at_.begin(); it != inserted_at_.end();) {
+        it = it->second <= loaded_at_version ? inserted_at_.erase(it) : std::next(it);
+    }
+}
+
+void HotSet::Insert(std::vector<NewsItem> items) {
+    const auto incoming = ToPointers(std::move(items));
+    std::lock_guard<engine::Mutex> lock(write_mutex_);
+    const auto current = snapshot_.Read();
+    auto merged = MergeNewest(current->items, incoming, capacity_);
+
+    HotSetSnapshot next;
+    next.complete = !merged.truncated && current->complete;
+    next.version = current->version + 1;
+    next.id_sum = current->id_sum;
+
+    // Only the lists of names that gained or lost a row are rebuilt; the
+    // others are shared with the current snapshot
+    std::unordered_set<int> added_ids;
+    std::unordered_map<std::string, std::vector<NewsItemPtr>> added_by_category;
+    std::unordered_map<std::string, std::vector<NewsItemPtr>> added_by_source;
+    for (const auto& item : merged.added) {
+        added_ids.insert(item->id);
+        added_by_category[item->category].push_back(item);
+        added_by_source[item->source].push_back(item);
+        next.id_sum += item->id;
+        inserted_at_[item->id] = next.version;
+    }
+    std::unordered_set<std::string> dropped_categories;
+    std::unordered_set<std::string> dropped_sources;
+    for (const auto& item : merged.dropped) {
+        dropped_categories.insert(item->category);
+        dropped_sources.insert(item->source);
+        next.id_sum -= item->id;
+        if (added_ids.count(item->id) == 0) {
+            inserted_at_.erase(item->id);
+        }
+    }
+
+    // Dropped rows are replaced copies or the oldest ones, past the new tail
+    const NewsItemPtr oldest = merged.truncated ? merged.items.back() : nullptr;
+    const auto update = [&added_ids, &oldest](std::unordered_map<std::string, NewsItemList>& lists,
+                                              const std::string& name, const std::vector<NewsItemPtr>& added) {
+        const auto found = lists.find(name);
+        static const std::vector<NewsItemPtr> kEmpty;
+        const auto& old = found == lists.end() ? kEmpty : *found->second;
+        std::vector<NewsItemPtr> list;
+        list.reserve(old.size() + added.size());
+        size_t i = 0;
+        size_t j = 0;
+        while (i < old.size() || j < added.size()) {
+            if (i < old.size() && (added_ids.count(old[i]->id) != 0 || (oldest && IsNewer(oldest, old[i])))) {
+                ++i;
+            } else if (j < added.size() && (i == old.size() || !IsNewer(old[i], added[j]))) {
+                list.push_back(added[j++]);
+            } else {
+                list.push_back(old[i++]);
+            }
+        }
+        if (list.empty()) {
+            lists.erase(name);
+        } else {
+            lists[name] = std::make_shared<const std::vector<NewsItemPtr>>(std::move(list));
+        }
+    };
+
+    next.by_category = current->by_category;
+    next.by_source = current->by_source;
+    static const std::vector<NewsItemPtr> kNone;
+    for (const auto& [category, added] : added_by_category) {
+        update(next.by_category, category, added);
+        dropped_categories.erase(category);
+    }
+    for (const auto& category : dropped_categories) {
+        update(next.by_category, category, kNone);
+    }
+    for (const auto& [source, added] : added_by_source) {
+        update(next.by_source, source, added);
+        dropped_sources.erase(source);
+    }
+    for (const auto& source : dropped_sources) {
+        update(next.by_source, source, kNone);
+    }
+
+    next.items = std::move(merged.items);
+    snapshot_.Assign(std::move(next));
+}
+
+bool HotSet::Verify(PostgresClient& client) {
+    const auto snapshot = snapshot_.Read();
+    std::optional<NewsCursor> from;
+    if (!snapshot->complete) {
+        if (snapshot->items.empty()) {
+            verified_ = false;
+            return false;
+        }
+        from = CursorOf(*snapshot->items.back());
+    }
+
+    const auto checksum = client.GetNewsChecksum(from);
+    verified_ = checksum && checksum->count == static_cast<int64_t>(snapshot->items.size()) &&
+                checksum->id_sum == snapshot->id_sum;
+    return verified_;
+}
+
+std::optional<std::vector<NewsItemPtr>> HotSet::TryGetLatest(const NewsQuery& query) const {
+    if (!verified_) {
+        return std::nullopt;
+    }
+    const auto snapshot = snapshot_.Read();
+    // Only that very row proves its insert reached the set: a higher id
+    // inserted here says nothing about rows another instance wrote. It is
+    // among the newest, so the scan stops early.
+    if (query.min_id > 0 &&
+        std::none_of(snapshot->items.begin(), snapshot->items.end(),
+                     [&query](const NewsItemPtr& item) { return item->id == query.min_id; })) {
+        return std::nullopt;
+    }
+
+    const std::vector<NewsItemPtr>* view = &snapshot->items;
+    static const std::vector<NewsItemPtr> kEmpty;
+    if (!query.category.empty()) {
+        const auto it = snapshot->by_category.find(query.category);
+        view = it == snapshot->by_category.end() ? &kEmpty : it->second.get();
+    } else if (!query.source.empty()) {
+        const auto it = snapshot->by_source.find(query.source);
+        view = it == snapshot->by_source.end() ? &kEmpty : it->second.get();
+    }
+
+    auto begin = view->begin();
+    if (query.before) {
+        const auto& cursor = *query.before;
+        begin = std::partition_point(view->begin(), view->end(),
+                                     [&cursor](const NewsItemPtr& item) { return !IsBefore(*item, cursor); });
+    }
+
+    std::vector<NewsItemPtr> result;
+    result.reserve(query.limit);
+    for (auto it = begin; it != view->end() && static_cast<int>(result.size()) < query.limit; ++it) {
+        if (!query.source.empty() && (*it)->source != query.source) {
+            continue;
+        }
+        result.push_back(*it);
+    }
+
+    // Every row newer than the oldest cached one is cached, so a full page is
+    // exact; a short page is only exact when the whole table fits in memory
+    if (static_cast<int>(result.size()) < query.limit && !snapshot->complete) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+size_t HotSet::GetSize() const {
+    return snapshot_.Read()->items.size();
+}
+
+}  // namespace news_aggregator::storage
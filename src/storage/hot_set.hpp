@@ -0,0 +1,76 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/rcu/rcu.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+using NewsItemPtr = std::shared_ptr<const NewsItem>;
+using NewsItemList = std::shared_ptr<const std::vector<NewsItemPtr>>;
+
+// Immutable view of the newest rows; replaced as a whole on every write.
+// Per-name lists are shared between snapshots, so an insert only rebuilds
+// the lists of the names it touches.
+struct HotSetSnapshot {
+    // Newest first by (created_at, id), at most `capacity` items
+    std::vector<NewsItemPtr> items;
+    // Same order, restricted to one category / source
+    std::unordered_map<std::string, NewsItemList> by_category;
+    std::unordered_map<std::string, NewsItemList> by_source;
+    // True when `items` holds every row of the table
+    bool complete = false;
+    // Sum of the ids in `items`, compared with PostgreSQL by Verify
+    int64_t id_sum = 0;
+    // Bumped by every Insert; rows inserted after a load started survive its Reset
+    uint64_t version = 0;
+};
+
+// Bounded write-through index of the most recent news. Readers take an RCU
+// snapshot and never lock; writers build the next snapshot copy-on-write.
+class HotSet {
+public:
+    explicit HotSet(size_t capacity);
+
+    // Version to pass to Reset for a load that starts now
+    uint64_t GetVersion() const;
+    // Replaces the snapshot with a freshly loaded set of newest rows. Rows
+    // inserted since `loaded_at_version` are kept, everything else is dropped.
+    void Reset(std::vector<NewsItem> items, bool complete, uint64_t loaded_at_version);
+    // Write-through of newly committed rows
+    void Insert(std::vector<NewsItem> items);
+
+    // Rows written by other instances or the bulk importer never reach Insert.
+    // Verify compares the cached window with what PostgreSQL holds in it; until
+    // a check matches, every query falls back to PostgreSQL.
+    bool Verify(PostgresClient& client);
+    void Invalidate() { verified_ = false; }
+
+    // Answers the query from memory, or returns std::nullopt when the page may
+    // reach past the oldest cached row, or the row query.min_id is not cached,
+    // and it has to come from PostgreSQL
+    std::optional<std::vector<NewsItemPtr>> TryGetLatest(const NewsQuery& query) const;
+
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetSize() const;
+
+private:
+    static std::vector<NewsItemPtr> ToPointers(std::vector<NewsItem> items);
+
+    const size_t capacity_;
+    rcu::Variable<HotSetSnapshot> snapshot_;
+    // Serializes writers; guards inserted_at_, which readers never need
+    engine::Mutex write_mutex_;
+    // Version of the Insert that added each row since the last Reset began
+    std::unordered_map<int, uint64_t> inserted_at_;
+    std::atomic<bool> verified_{false};
+};
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,368 @@
+#include "ingest_stats.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <charconv>
+#include <mutex>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+struct ResolutionInfo {
+    std::string_view name;
+    char suffix;
+    int64_t width_us;
+    int retention;  // buckets kept, which is also the longest window
+};
+
+constexpr std::array<ResolutionInfo, 3> kResolutions = {{
+    {"minute", 'm', 60LL * 1000000, 60},
+    {"hour", 'h', 3600LL * 1000000, 48},
+    {"day", 'd', 86400LL * 1000000, 90},
+}};
+
+constexpr std::string_view kOtherKey = "(other)";
+
+const ResolutionInfo& Info(StatsResolution resolution) {
+    return kResolutions[static_cast<size_t>(resolution)];
+}
+
+int64_t Floor(int64_t timestamp_us, int64_t width_us) {
+    return timestamp_us - ((timestamp_us % width_us) + width_us) % width_us;
+}
+
+int64_t ToMicroseconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+size_t ShardIndex() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard++ % IngestStats::kShards;
+    return shard;
+}
+
+void AddCounts(std::vector<uint64_t>& to, const std::vector<uint64_t>& from) {
+    if (to.size() < from.size()) {
+        to.resize(from.size());
+    }
+    for (size_t i = 0; i < from.size(); ++i) {
+        to[i] += from[i];
+    }
+}
+
+// Counters only grow, so the difference is never negative
+std::vector<uint64_t> SubtractCounts(const std::vector<uint64_t>& current, const std::vector<uint64_t>& previous) {
+    std::vector<uint64_t> delta = current;
+    for (size_t i = 0; i < previous.size() && i < delta.size(); ++i) {
+        delta[i] -= previous[i];
+    }
+    return delta;
+}
+
+std::vector<std::pair<std::string, uint64_t>> Ranked(const std::vector<uint64_t>& counts,
+                                                     const std::vector<std::string>& names) {
+    std::vector<std::pair<std::string, uint64_t>> ranked;
+    for (size_t i = 0; i < counts.size() && i < names.size(); ++i) {
+        if (counts[i] != 0) {
+            ranked.emplace_back(names[i], counts[i]);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    });
+    return ranked;
+}
+
+}  // namespace
+
+std::optional<StatsWindow> ParseStatsWindow(std::string_view text) {
+    if (text.size() < 2) {
+        return std::nullopt;
+    }
+    const char suffix = text.back();
+    text.remove_suffix(1);
+    
+    int count = 0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), count);
+    if (result.ec != std::errc{} || result.ptr != text.data() + text.size() || count <= 0) {
+        return std::nullopt;
+    }
+    for (size_t i = 0; i < kResolutions.size(); ++i) {
+        if (kResolutions[i].suffix == suffix && count <= kResolutions[i].retention) {
+            return StatsWindow{static_cast<StatsResolution>(i), count};
+        }
+    }
+    return std::nullopt;
+}
+
+IngestStats::CounterSet::CounterSet() {
+    auto keys = keys_.StartWrite();
+    keys->ids.emplace(std::string(kOtherKey), 0);
+    keys->names.emplace_back(kOtherKey);
+    keys.Commit();
+}
+
+void IngestStats::CounterSet::Add(const std::string& name) {
+    shards_[ShardIndex()].counts[Intern(name)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t IngestStats::CounterSet::Intern(const std::string& name) {
+    {
+        const auto keys = keys_.Read();
+        const auto it = keys->ids.find(name);
+        if (it != keys->ids.end()) {
+            return it->second;
+        }
+    }
+    
+    // Writers are serialized by rcu::Variable, so check again under the write
+    auto keys = keys_.StartWrite();
+    const auto it = keys->ids.find(name);
+    if (it != keys->ids.end()) {
+        return it->second;
+    }
+    if (keys->names.size() == kMaxKeys) {
+        return 0;
+    }
+    const auto id = static_cast<uint32_t>(keys->names.size());
+    keys->ids.emplace(name, id);
+    keys->names.push_back(name);
+    keys.Commit();
+    return id;
+}
+
+std::vector<uint64_t> IngestStats::CounterSet::Sum() const {
+    const size_t size = keys_.Read()->names.size();
+    std::vector<uint64_t> sums(size, 0);
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i < size; ++i) {
+            sums[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+    return sums;
+}
+
+std::vector<std::string> IngestStats::CounterSet::GetNames() const {
+    return keys_.Read()->names;
+}
+
+IngestStats::IngestStats() = default;
+
+void IngestStats::Record(const std::string& source, const std::string& category) {
+    sources_.Add(source);
+    categories_.Add(category);
+    totals_[ShardIndex()].count.fetch_add(1, std::memory_order_relaxed);
+}
+
+IngestStats::Counts IngestStats::Snapshot() const {
+    Counts counts;
+    for (const auto& shard : totals_) {
+        counts.total += shard.count.load(std::memory_order_relaxed);
+    }
+    counts.sources = sources_.Sum();
+    counts.categories = categories_.Sum();
+    return counts;
+}
+
+IngestStats::Bucket& IngestStats::GetBucket(StatsResolution resolution, int64_t start_us) {
+    auto& buckets = history_[static_cast<size_t>(resolution)];
+    auto it = std::lower_bound(buckets.begin(), buckets.end(), start_us,
+                               [](const Bucket& bucket, int64_t start) { return bucket.start_us < start; });
+    if (it == buckets.end() || it->start_us != start_us) {
+        Bucket bucket;
+        bucket.start_us = start_us;
+        it = buckets.insert(it, std::move(bucket));
+    }
+    return *it;
+}
+
+void IngestStats::Prune(int64_t now_us) {
+    for (size_t i = 0; i < kResolutions.size(); ++i) {
+        const auto& info = kResolutions[i];
+        const int64_t oldest_us = Floor(now_us, info.width_us) - (info.retention - 1) * info.width_us;
+        auto& buckets = history_[i];
+        while (!buckets.empty() && buckets.front().start_us < oldest_us) {
+            buckets.pop_front();
+        }
+    }
+}
+
+std::vector<StatsBucketRow> IngestStats::Rotate(std::chrono::system_clock::time_point bucket_time) {
+    const int64_t time_us = ToMicroseconds(bucket_time);
+    const auto source_names = sources_.GetNames();
+    const auto category_names = categories_.GetNames();
+    
+    std::lock_guard<engine::Mutex> lock(history_mutex_);
+    auto current = Snapshot();
+    Counts delta;
+    delta.total = current.total - rotated_.total;
+    delta.sources = SubtractCounts(current.sources, rotated_.sources);
+    delta.categories = SubtractCounts(current.categories, rotated_.categories);
+    rotated_ = std::move(current);
+    
+    std::vector<StatsBucketRow> rows;
+    if (delta.total == 0) {
+        Prune(time_us);
+        return rows;
+    }
+    
+    for (size_t i = 0; i < kResolutions.size(); ++i) {
+        const auto resolution = static_cast<StatsResolution>(i);
+        const int64_t start_us = Floor(time_us, kResolutions[i].width_us);
+        auto& counts = GetBucket(resolution, start_us).counts;
+        counts.total += delta.total;
+        AddCounts(counts.sources, delta.sources);
+        AddCounts(counts.categories, delta.categories);
+        
+        rows.push_back(StatsBucketRow{resolution, start_us, "total", "", delta.total});
+        for (size_t key = 0; key < delta.sources.size() && key < source_names.size(); ++key) {
+            if (delta.sources[key] != 0) {
+                rows.push_back(StatsBucketRow{resolution, start_us, "source", source_names[key], delta.sources[key]});
+            }
+        }
+        for (size_t key = 0; key < delta.categories.size() && key < category_names.size(); ++key) {
+            if (delta.categories[key] != 0) {
+                rows.push_back(
+                    StatsBucketRow{resolution, start_us, "category", category_names[key], delta.categories[key]});
+            }
+        }
+    }
+    Prune(time_us);
+    return rows;
+}
+
+uint64_t& IngestStats::GetCount(const StatsBucketRow& row) {
+    auto& counts = GetBucket(row.resolution, row.bucket_start_us).counts;
+    if (row.dimension == "total") {
+        return counts.total;
+    }
+    const bool is_source = row.dimension == "source";
+    auto& values = is_source ? counts.sources : counts.categories;
+    const auto id = (is_source ? sources_ : categories_).Intern(row.name);
+    if (values.size() <= id) {
+        values.resize(id + 1);
+    }
+    return values[id];
+}
+
+void IngestStats::Replace(const std::vector<StatsBucketRow>& rows) {
+    std::lock_guard<engine::Mutex> lock(history_mutex_);
+    for (auto& buckets : history_) {
+        buckets.clear();
+    }
+    for (const auto& row : rows) {
+        GetCount(row) += row.count;
+    }
+    Prune(ToMicroseconds(std::chrono::system_clock::now()));
+}
+
+void IngestStats::Update(const std::vector<StatsBucketRow>& rows) {
+    std::lock_guard<engine::Mutex> lock(history_mutex_);
+    // Cleared first: names past kMaxKeys share the "(other)" counter, so
+    // several rows may add up into it
+    for (const auto& row : rows) {
+        GetCount(row) = 0;
+    }
+    for (const auto& row : rows) {
+        GetCount(row) += row.count;
+    }
+    Prune(ToMicroseconds(std::chrono::system_clock::now()));
+}
+
+StatsWindowResult IngestStats::Query(const StatsWindow& window, std::chrono::system_clock::time_point now) const {
+    const int64_t now_us = ToMicroseconds(now);
+    const auto& info = Info(window.resolution);
+    const auto source_names = sources_.GetNames();
+    const auto category_names = categories_.GetNames();
+    
+    StatsWindowResult result;
+    result.from_us = Floor(now_us, info.width_us) - (window.count - 1) * info.width_us;
+    
+    Counts sum;
+    {
+        std::lock_guard<engine::Mutex> lock(history_mutex_);
+        // Not rotated yet: belongs to the current bucket of every resolution
+        const auto current = Snapshot();
+        sum.total = current.total - rotated_.total;
+        sum.sources = SubtractCounts(current.sources, rotated_.sources);
+        sum.categories = SubtractCounts(current.categories, rotated_.categories);
+        
+        for (const auto& bucket : history_[static_cast<size_t>(window.resolution)]) {
+            if (bucket.start_us < result.from_us) {
+                continue;
+            }
+            sum.total += bucket.counts.total;
+            AddCounts(sum.sources, bucket.counts.sources);
+            AddCounts(sum.categories, bucket.counts.categories);
+        }
+    }
+    
+    result.total = sum.total;
+    result.by_source = Ranked(sum.sources, source_names);
+    result.by_category = Ranked(sum.categories, category_names);
+    return result;
+}
+
+bool CheckpointIngestStats(PostgresClient& client, const std::vector<StatsBucketRow>& rows) {
+    if (!rows.empty()) {
+        std::string sql = "INSERT INTO news_ingest_stats (resolution, bucket_start, dimension, name, count) VALUES ";
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto& row = rows[i];
+            if (i != 0) {
+                sql += ", ";
+            }
+            sql += "('" + std::string(Info(row.resolution).name) + "', TIMESTAMPTZ 'epoch' + " +
+                   std::to_string(row.bucket_start_us) + " * INTERVAL '1 microsecond', '" + row.dimension + "', " +
+                   client.EscapeString(row.name) + ", " + std::to_string(row.count) + ")";
+        }
+        sql += " ON CONFLICT (resolution, bucket_start, dimension, name) "
+               "DO UPDATE SET count = news_ingest_stats.count + EXCLUDED.count, updated_at = now()";
+        if (!client.Execute(sql)) {
+            return false;
+        }
+    }
+    
+    std::string expire = "DELETE FROM news_ingest_stats WHERE ";
+    for (size_t i = 0; i < kResolutions.size(); ++i) {
+        const auto& info = kResolutions[i];
+        if (i != 0) {
+            expire += " OR ";
+        }
+        expire += "(resolution = '" + std::string(info.name) + "' AND bucket_start < CURRENT_TIMESTAMP - " +
+                  std::to_string(info.retention * info.width_us) + " * INTERVAL '1 microsecond')";
+    }
+    return client.Execute(expire);
+}
+
+std::optional<std::vector<StatsBucketRow>> LoadIngestStats(PostgresClient& client,
+                                                           std::optional<std::chrono::microseconds> touched_within) {
+    std::string sql =
+        "SELECT resolution, (EXTRACT(EPOCH FROM bucket_start) * 1000000)::BIGINT, dimension, name, count "
+        "FROM news_ingest_stats";
+    if (touched_within) {
+        // A duration rather than a timestamp, so the clocks of the instances
+        // and of the database never have to agree
+        sql += " WHERE updated_at >= now() - " + std::to_string(touched_within->count()) +
+               " * INTERVAL '1 microsecond'";
+    }
+    const auto values = client.QueryRows(sql + " ORDER BY resolution, bucket_start");
+    if (!values) {
+        return std::nullopt;
+    }
+    
+    std::vector<StatsBucketRow> rows;
+    rows.reserve(values->size());
+    for (const auto& value : *values) {
+        const auto info = std::find_if(kResolutions.begin(), kResolutions.end(),
+                                       [&value](const ResolutionInfo& info) { return info.name == value[0]; });
+        if (info == kResolutions.end()) {
+            LOG_WARNING() << "Skipping ingest stats row with unknown resolution " << value[0];
+            continue;
+        }
+        rows.push_back(StatsBucketRow{static_cast<StatsResolution>(info - kResolutions.begin()), std::stoll(value[1]),
+                                      value[2], value[3], std::stoull(value[4])});
+    }
+    return rows;
+}
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/rcu/rcu.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+enum class StatsResolution { kMinute, kHour, kDay };
+
+// The current bucket of `resolution` plus the `count - 1` buckets before it
+struct StatsWindow {
+    StatsResolution resolution = StatsResolution::kHour;
+    int count = 1;
+};
+
+// "15m", "6h", "7d"; std::nullopt when malformed or longer than the history kept
+std::optional<StatsWindow> ParseStatsWindow(std::string_view text);
+
+// Rows ingested for one source / category in one bucket
+struct StatsBucketRow {
+    StatsResolution resolution = StatsResolution::kMinute;
+    int64_t bucket_start_us = 0;
+    std::string dimension;  // "source", "category" or "total"
+    std::string name;       // empty for "total"
+    uint64_t count = 0;
+};
+
+struct StatsWindowResult {
+    int64_t from_us = 0;
+    uint64_t total = 0;
+    // Most rows first
+    std::vector<std::pair<std::string, uint64_t>> by_source;
+    std::vector<std::pair<std::string, uint64_t>> by_category;
+};
+
+// Ingest counters per source and category. Record() only does relaxed atomic
+// increments on a per-thread shard. Once a minute Rotate() turns the growth of
+// the counters into minute, hour and day buckets and returns it for the
+// checkpoint to PostgreSQL. After each checkpoint the buckets any instance
+// touched since the previous one are overwritten by the checkpointed rows,
+// which add up every instance, so queries always cover the whole cluster: its
+// checkpoints plus what this instance has not rotated yet.
+class IngestStats {
+public:
+    static constexpr size_t kShards = 16;
+    // Per dimension; names seen after the table is full are counted as "(other)"
+    static constexpr size_t kMaxKeys = 512;
+
+    IngestStats();
+
+    void Record(const std::string& source, const std::string& category);
+
+    // Closes everything recorded since the previous rotation into the buckets
+    // containing `bucket_time` and returns the increments
+    std::vector<StatsBucketRow> Rotate(std::chrono::system_clock::time_point bucket_time);
+    // Replaces the buckets with the checkpointed ones of every instance; the
+    // increments this instance has not rotated yet are kept
+    void Replace(const std::vector<StatsBucketRow>& rows);
+    // Overwrites the counts of the given rows only; everything else is kept
+    void Update(const std::vector<StatsBucketRow>& rows);
+
+    StatsWindowResult Query(const StatsWindow& window, std::chrono::system_clock::time_point now) const;
+
+private:
+    struct Counts {
+        uint64_t total = 0;
+        std::vector<uint64_t> sources;  // by key id
+        std::vector<uint64_t> categories;
+    };
+
+    struct Bucket {
+        int64_t start_us = 0;
+        Counts counts;
+    };
+
+    // Sharded counters of one dimension. Names are interned into dense ids
+    // through an RCU map, so only the first sighting of a name takes a lock.
+    class CounterSet {
+    public:
+        CounterSet();
+
+        void Add(const std::string& name);
+        uint32_t Intern(const std::string& name);
+        std::vector<uint64_t> Sum() const;
+        std::vector<std::string> GetNames() const;
+
+    private:
+        struct Keys {
+            std::unordered_map<std::string, uint32_t> ids;
+            std::vector<std::string> names;
+        };
+
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, kMaxKeys> counts{};
+        };
+
+        rcu::Variable<Keys> keys_;
+        std::array<Shard, kShards> shards_;
+    };
+
+    struct alignas(64) TotalShard {
+        std::atomic<uint64_t> count{0};
+    };
+
+    Counts Snapshot() const;
+    // Finds or creates the bucket, keeping the history ordered by start
+    Bucket& GetBucket(StatsResolution resolution, int64_t start_us);
+    void Prune(int64_t now_us);
+    // The counter of the row's name in its bucket, created when missing
+    uint64_t& GetCount(const StatsBucketRow& row);
+
+    CounterSet sources_;
+    CounterSet categories_;
+    std::array<TotalShard, kShards> totals_;
+
+    mutable engine::Mutex history_mutex_;
+    Counts rotated_;  // cumulative counters at the last rotation
+    std::array<std::deque<Bucket>, 3> history_;
+};
+
+// Adds the increments to news_ingest_stats and drops rows past the history kept
+bool CheckpointIngestStats(PostgresClient& client, const std::vector<StatsBucketRow>& rows);
+// Every row, or only those checkpointed within `touched_within` by any instance
+std::optional<std::vector<StatsBucketRow>> LoadIngestStats(
+    PostgresClient& client, std::optional<std::chrono::microseconds> touched_within = std::nullopt);
+
+}  // namespace news_aggregator::storage
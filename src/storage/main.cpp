@@ -1,16 +1,37 @@
 #include <userver/utest/using_namespace_userver.hpp>
 
 #include <userver/components/minimal_server_component_list.hpp>
+#include <userver/server/handlers/server_monitor.hpp>
 #include <userver/utils/daemon_run.hpp>
 
 #include "../handlers/health_handler.hpp"
 #include "../handlers/news_latest_handler.hpp"
+#include "../handlers/news_latest_internal_handler.hpp"
 #include "../handlers/news_add_handler.hpp"
+#include "../handlers/news_detail_handler.hpp"
+#include "../handlers/news_fragment_cache_component.hpp"
+#include "../handlers/news_export_handler.hpp"
+#include "../handlers/news_search_handler.hpp"
+#include "../handlers/news_stats_handler.hpp"
+#include "../handlers/news_trending_handler.hpp"
+#include "../handlers/news_archive_handler.hpp"
+#include "storage_service.hpp"
 
 int main(int argc, char* argv[]) {
   const auto component_list = components::MinimalServerComponentList()
+                                      .Append<news_aggregator::storage::StorageService>()
+                                      .Append<server::handlers::ServerMonitor>()
+                                      .Append<news_aggregator::handlers::NewsFragmentCacheComponent>()
                                       .Append<news_aggregator::handlers::PingHandler>()
                                       .Append<news_aggregator::handlers::NewsLatestHandler>()
-                                      .Append<news_aggregator::handlers::NewsAddHandler>();
+                                      .Append<news_aggregator::handlers::NewsLatestInternalHandler>()
+                                      .Append<news_aggregator::handlers::NewsAddHandler>()
+                                      .Append<news_aggregator::handlers::NewsDetailHandler>()
+                                      .Append<news_aggregator::handlers::NewsBatchHandler>()
+                                      .Append<news_aggregator::handlers::NewsExportHandler>()
+                                      .Append<news_aggregator::handlers::NewsSearchHandler>()
+                                      .Append<news_aggregator::handlers::NewsStatsHandler>()
+                                      .Append<news_aggregator::handlers::NewsTrendingHandler>()
+                                      .Append<news_aggregator::handlers::NewsArchiveHandler>();
   return utils::DaemonMain(argc, argv, component_list);
 }
@@ -0,0 +1,510 @@
+#include "migrations.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <string>
+#include "content_key.hpp"
+#include "partitions.hpp"
+#include "snippet.hpp"
+#include "text_normalizer.hpp"
+
+namespace news_aggregator::storage {
+
+namespace {
+
+// Arbitrary application-wide keys for pg_advisory_lock
+constexpr std::string_view kMigrationLockKey = "727174001";
+constexpr std::string_view kBackfillLockKey = "727174004";
+
+constexpr int kContentKeyBackfillBatch = 1000;
+constexpr int kTextNormalizationBatch = 500;
+
+constexpr std::string_view kCreateNewsTable = R"sql(
+CREATE TABLE IF NOT EXISTS news (
+    id SERIAL PRIMARY KEY,
+    title TEXT NOT NULL,
+    content TEXT NOT NULL DEFAULT '',
+    source TEXT NOT NULL,
+    category TEXT NOT NULL DEFAULT 'general',
+    url TEXT,
+    published_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP
+);
+
+-- Databases bootstrapped from sql/001_create_news_table.sql use text/date columns
+DO $$
+BEGIN
+    IF EXISTS (SELECT 1 FROM information_schema.columns
+               WHERE table_schema = current_schema() AND table_name = 'news' AND column_name = 'text') THEN
+        ALTER TABLE news RENAME COLUMN text TO content;
+    END IF;
+    IF EXISTS (SELECT 1 FROM information_schema.columns
+               WHERE table_schema = current_schema() AND table_name = 'news' AND column_name = 'date') THEN
+        ALTER TABLE news RENAME COLUMN date TO published_at;
+    END IF;
+END $$;
+
+ALTER TABLE news ADD COLUMN IF NOT EXISTS category TEXT NOT NULL DEFAULT 'general';
+ALTER TABLE news ADD COLUMN IF NOT EXISTS url TEXT;
+ALTER TABLE news ALTER COLUMN title TYPE TEXT, ALTER COLUMN source TYPE TEXT;
+
+UPDATE news SET published_at = COALESCE(published_at, created_at, CURRENT_TIMESTAMP),
+                created_at = COALESCE(created_at, CURRENT_TIMESTAMP)
+WHERE published_at IS NULL OR created_at IS NULL;
+ALTER TABLE news ALTER COLUMN published_at SET NOT NULL, ALTER COLUMN created_at SET NOT NULL;
+
+DROP INDEX IF EXISTS idx_news_date;
+DROP INDEX IF EXISTS idx_news_source;
+)sql";
+
+// Keyset pagination orders by (created_at DESC, id DESC); each index matches
+// that order exactly so filtered and deep pages are a bounded index range scan
+constexpr std::string_view kCreateLatestNewsIndexes = R"sql(
+CREATE INDEX IF NOT EXISTS idx_news_created_at_id ON news (created_at DESC, id DESC);
+CREATE INDEX IF NOT EXISTS idx_news_category_created_at ON news (category, created_at DESC, id DESC);
+CREATE INDEX IF NOT EXISTS idx_news_source_created_at ON news (source, created_at DESC, id DESC);
+)sql";
+
+// The key hash is computed by the application and cannot be reproduced in SQL,
+// so existing rows get their keys from BackfillContentKeys. NULLs never
+// conflict in a unique index.
+constexpr std::string_view kAddContentKey = R"sql(
+ALTER TABLE news ADD COLUMN IF NOT EXISTS content_key BIGINT;
+CREATE UNIQUE INDEX IF NOT EXISTS ux_news_content_key ON news (content_key);
+)sql";
+
+// New rows get their snippet from MakeSnippet at ingest; existing rows are
+// backfilled with a close SQL approximation of it
+constexpr std::string_view kAddNewsSnippet = R"sql(
+ALTER TABLE news ADD COLUMN IF NOT EXISTS snippet TEXT;
+UPDATE news
+SET snippet = CASE
+    WHEN char_length(body) > 280 THEN rtrim(left(body, 279)) || '…'
+    ELSE body
+END
+FROM (SELECT id AS body_id, btrim(regexp_replace(content, '\s+', ' ', 'g')) AS body FROM news) AS normalized
+WHERE news.id = normalized.body_id AND news.snippet IS NULL;
+)sql";
+
+// Range-partitions news by created_at. A unique index on a partitioned table
+// has to contain the partition key, so deduplication moves to news_keys, which
+// hands out the row id together with the created_at the row is stored under.
+// The existing table is not copied: it becomes the DEFAULT partition, so this
+// transaction only builds its (id, created_at) key and fills news_keys, and
+// BackfillNewsPartitions moves its rows into weekly partitions afterwards.
+constexpr std::string_view kPartitionNews = R"sql(
+ALTER TABLE news RENAME TO news_default;
+ALTER TABLE news_default DROP CONSTRAINT IF EXISTS news_pkey;
+DROP INDEX IF EXISTS ux_news_content_key;
+-- Matching indexes of a partition are attached instead of being built again
+ALTER INDEX IF EXISTS idx_news_created_at_id RENAME TO news_default_created_at_id_idx;
+ALTER INDEX IF EXISTS idx_news_category_created_at RENAME TO news_default_category_created_at_id_idx;
+ALTER INDEX IF EXISTS idx_news_source_created_at RENAME TO news_default_source_created_at_id_idx;
+ALTER SEQUENCE news_id_seq OWNED BY NONE;
+
+CREATE TABLE news (
+    id INT NOT NULL DEFAULT nextval('news_id_seq'),
+    title TEXT NOT NULL,
+    content TEXT NOT NULL DEFAULT '',
+    source TEXT NOT NULL,
+    category TEXT NOT NULL DEFAULT 'general',
+    url TEXT,
+    published_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    content_key BIGINT,
+    snippet TEXT,
+    PRIMARY KEY (id, created_at)
+) PARTITION BY RANGE (created_at);
+ALTER SEQUENCE news_id_seq OWNED BY news.id;
+
+CREATE INDEX idx_news_created_at_id ON news (created_at DESC, id DESC);
+CREATE INDEX idx_news_category_created_at ON news (category, created_at DESC, id DESC);
+CREATE INDEX idx_news_source_created_at ON news (source, created_at DESC, id DESC);
+
+ALTER TABLE news ATTACH PARTITION news_default DEFAULT;
+
+CREATE TABLE news_keys (
+    content_key BIGINT PRIMARY KEY,
+    news_id INT NOT NULL,
+    created_at TIMESTAMPTZ NOT NULL
+);
+CREATE INDEX idx_news_keys_created_at ON news_keys (created_at);
+
+INSERT INTO news_keys (content_key, news_id, created_at)
+SELECT content_key, id, created_at FROM news_default WHERE content_key IS NOT NULL;
+
+-- Creates the `unit` (day, week or month) partition containing `ts` unless it
+-- exists. Rows already in news_default for that range are moved into it. A
+-- range that overlaps partitions of another unit is left to news_default.
+CREATE FUNCTION news_ensure_partition(ts TIMESTAMPTZ, unit TEXT) RETURNS TEXT AS $$
+DECLARE
+    lower_bound TIMESTAMPTZ := date_trunc(unit, ts, 'UTC');
+    upper_bound TIMESTAMPTZ := lower_bound + ('1 ' || unit)::INTERVAL;
+    partition_name TEXT := 'news_' || unit || '_' || to_char(lower_bound AT TIME ZONE 'UTC', 'YYYYMMDD');
+BEGIN
+    IF to_regclass(partition_name) IS NOT NULL THEN
+        RETURN partition_name;
+    END IF;
+
+    BEGIN
+        CREATE TEMP TABLE IF NOT EXISTS news_partition_move (LIKE news) ON COMMIT DROP;
+        -- news_default may be the pre-partitioning table with another column order
+        WITH moved AS (
+            DELETE FROM news_default
+            WHERE created_at >= lower_bound AND created_at < upper_bound
+            RETURNING id, title, content, source, category, url, published_at, created_at, content_key, snippet
+        )
+        INSERT INTO news_partition_move SELECT * FROM moved;
+
+        EXECUTE format('CREATE TABLE %I PARTITION OF news FOR VALUES FROM (%L) TO (%L)',
+                       partition_name, lower_bound, upper_bound);
+
+        INSERT INTO news SELECT * FROM news_partition_move;
+        DELETE FROM news_partition_move;
+    EXCEPTION WHEN invalid_object_definition THEN
+        RETURN NULL;
+    END;
+    RETURN partition_name;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Detaches, and with drop_tables also drops, every partition that ends at or
+-- before `cutoff`, and forgets the content keys of its rows
+CREATE FUNCTION news_expire_partitions(cutoff TIMESTAMPTZ, drop_tables BOOLEAN) RETURNS SETOF TEXT AS $$
+DECLARE
+    expired RECORD;
+BEGIN
+    FOR expired IN
+        SELECT partition_name, lower_bound, upper_bound
+        FROM (
+            SELECT c.relname::TEXT AS partition_name,
+                   (regexp_match(pg_get_expr(c.relpartbound, c.oid), 'FROM \(''([^'']+)''\)'))[1]::TIMESTAMPTZ AS lower_bound,
+                   (regexp_match(pg_get_expr(c.relpartbound, c.oid), 'TO \(''([^'']+)''\)'))[1]::TIMESTAMPTZ AS upper_bound
+            FROM pg_inherits i
+            JOIN pg_class c ON c.oid = i.inhrelid
+            WHERE i.inhparent = 'news'::REGCLASS AND c.relname ~ '^news_(day|week|month)_[0-9]{8}$'
+        ) AS partitions
+        WHERE upper_bound <= cutoff
+        ORDER BY lower_bound
+    LOOP
+        EXECUTE format('ALTER TABLE news DETACH PARTITION %I', expired.partition_name);
+        DELETE FROM news_keys WHERE created_at >= expired.lower_bound AND created_at < expired.upper_bound;
+        IF drop_tables THEN
+            EXECUTE format('DROP TABLE %I', expired.partition_name);
+        END IF;
+        RETURN NEXT expired.partition_name;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+)sql";
+
+// Ingest counters per source and category, one row per time bucket. Instances
+// add their deltas, so a row is the sum over every writer; updated_at lets
+// them reload only the rows changed since their last checkpoint.
+constexpr std::string_view kCreateIngestStats = R"sql(
+CREATE TABLE news_ingest_stats (
+    resolution TEXT NOT NULL,
+    bucket_start TIMESTAMPTZ NOT NULL,
+    dimension TEXT NOT NULL,
+    name TEXT NOT NULL,
+    count BIGINT NOT NULL,
+    updated_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    PRIMARY KEY (resolution, bucket_start, dimension, name)
+);
+CREATE INDEX idx_news_ingest_stats_updated_at ON news_ingest_stats (updated_at);
+)sql";
+
+// Rows stored before NormalizeNewsItem ran at ingest still hold raw text. They
+// cannot be told apart from clean text by looking at it (a clean title may
+// legitimately contain "&amp;"), so every row says whether it was normalized:
+// existing rows start as false and BackfillTextNormalization normalizes each
+// of them exactly once; the application inserts true. news_ensure_partition
+// has to carry the flag when it moves rows out of news_default.
+constexpr std::string_view kAddTextNormalized = R"sql(
+ALTER TABLE news ADD COLUMN text_normalized BOOLEAN NOT NULL DEFAULT FALSE;
+
+CREATE OR REPLACE FUNCTION news_ensure_partition(ts TIMESTAMPTZ, unit TEXT) RETURNS TEXT AS $$
+DECLARE
+    lower_bound TIMESTAMPTZ := date_trunc(unit, ts, 'UTC');
+    upper_bound TIMESTAMPTZ := lower_bound + ('1 ' || unit)::INTERVAL;
+    partition_name TEXT := 'news_' || unit || '_' || to_char(lower_bound AT TIME ZONE 'UTC', 'YYYYMMDD');
+BEGIN
+    IF to_regclass(partition_name) IS NOT NULL THEN
+        RETURN partition_name;
+    END IF;
+
+    BEGIN
+        CREATE TEMP TABLE IF NOT EXISTS news_partition_move (LIKE news) ON COMMIT DROP;
+        -- news_default may be the pre-partitioning table with another column order
+        WITH moved AS (
+            DELETE FROM news_default
+            WHERE created_at >= lower_bound AND created_at < upper_bound
+            RETURNING id, title, content, source, category, url, published_at, created_at, content_key, snippet,
+                      text_normalized
+        )
+        INSERT INTO news_partition_move SELECT * FROM moved;
+
+        EXECUTE format('CREATE TABLE %I PARTITION OF news FOR VALUES FROM (%L) TO (%L)',
+                       partition_name, lower_bound, upper_bound);
+
+        INSERT INTO news SELECT * FROM news_partition_move;
+        DELETE FROM news_partition_move;
+    EXCEPTION WHEN invalid_object_definition THEN
+        RETURN NULL;
+    END;
+    RETURN partition_name;
+END;
+$$ LANGUAGE plpgsql;
+)sql";
+
+// Gives rows stored before content keys existed their key, so re-ingesting one
+// of those stories is recognized as a duplicate. Backfills run after every
+// migration is applied, so keys are claimed in news_keys like on insert. Of
+// several old rows with the same key only the oldest gets it. The feed GUID is
+// not stored, so a row without a URL is keyed by source and title.
+bool BackfillContentKeys(PostgresClient& client, const std::atomic<bool>& should_stop) {
+    int last_id = 0;
+    while (!should_stop) {
+        const auto rows = client.QueryRows(
+            "SELECT id, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, url, source, title "
+            "FROM news WHERE content_key IS NULL AND id > " + std::to_string(last_id) +
+            " ORDER BY id LIMIT " + std::to_string(kContentKeyBackfillBatch));
+        if (!rows) {
+            return false;
+        }
+        if (rows->empty()) {
+            return true;
+        }
+
+        std::string ids = "{";
+        std::string keys = "{";
+        std::string created_at = "{";
+        for (const auto& row : *rows) {
+            if (ids.size() > 1) {
+                ids += ',';
+                keys += ',';
+                created_at += ',';
+            }
+            ids += row[0];
+            keys += std::to_string(ComputeContentKey(row[2], {}, row[3], row[4]));
+            created_at += row[1];
+        }
+        ids += '}';
+        keys += '}';
+        created_at += '}';
+        last_id = std::stoi(rows->back()[0]);
+
+        // One statement, so a batch claims its keys and stores them atomically
+        const auto updated = client.ExecuteAffected(
+            "WITH batch AS ("
+            "SELECT * FROM unnest('" + ids + "'::INT[], '" + keys + "'::BIGINT[], '" + created_at + "'::BIGINT[]) "
+            "AS b(id, content_key, created_at_us)), "
+            "claimed AS ("
+            "INSERT INTO news_keys (content_key, news_id, created_at) "
+            "SELECT DISTINCT ON (content_key) content_key, id, "
+            "TIMESTAMPTZ 'epoch' + created_at_us * INTERVAL '1 microsecond' "
+            "FROM batch ORDER BY content_key, id "
+            "ON CONFLICT (content_key) DO NOTHING "
+            "RETURNING content_key, news_id, created_at) "
+            "UPDATE news SET content_key = claimed.content_key FROM claimed "
+            "WHERE news.id = claimed.news_id AND news.created_at = claimed.created_at");
+        if (!updated) {
+            return false;
+        }
+        LOG_INFO() << "Content key backfill: " << *updated << " of " << rows->size() << " rows keyed, up to id "
+                   << last_id;
+    }
+    return false;
+}
+
+// Normalizes the text of rows stored before normalization at ingest, the way
+// NormalizeNewsItem would have, and rebuilds their snippets from the clean
+// body. Content keys stay as they were claimed. Rows already served may stay
+// in the in-memory caches with their old text until evicted.
+bool BackfillTextNormalization(PostgresClient& client, const std::atomic<bool>& should_stop) {
+    int last_id = 0;
+    while (!should_stop) {
+        const auto rows = client.QueryRows(
+            "SELECT id, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, title, content, source, category "
+            "FROM news WHERE NOT text_normalized AND id > " + std::to_string(last_id) +
+            " ORDER BY id LIMIT " + std::to_string(kTextNormalizationBatch));
+        if (!rows) {
+            return false;
+        }
+        if (rows->empty()) {
+            return true;
+        }
+
+        std::string values;
+        for (const auto& row : *rows) {
+            NewsItem item;
+            item.title = row[2];
+            item.content = row[3];
+            item.source = row[4];
+            item.category = row[5];
+            NormalizeNewsItem(item);
+            if (!values.empty()) {
+                values += ", ";
+            }
+            values += "(" + row[0] + ", " + row[1] + ", " + client.EscapeString(item.title) + ", " +
+                      client.EscapeString(item.content) + ", " + client.EscapeString(item.source) + ", " +
+                      client.EscapeString(item.category) + ", " + client.EscapeString(MakeSnippet(item.content)) +
+                      ")";
+        }
+        last_id = std::stoi(rows->back()[0]);
+
+        // The flag is checked again, so a row is never normalized twice
+        const auto updated = client.ExecuteAffected(
+            "UPDATE news SET title = batch.title, content = batch.content, source = batch.source, "
+            "category = batch.category, snippet = batch.snippet, text_normalized = TRUE "
+            "FROM (VALUES " + values + ") AS batch(id, created_at_us, title, content, source, category, snippet) "
+            "WHERE news.id = batch.id "
+            "AND news.created_at = TIMESTAMPTZ 'epoch' + batch.created_at_us * INTERVAL '1 microsecond' "
+            "AND NOT news.text_normalized");
+        if (!updated) {
+            return false;
+        }
+        LOG_INFO() << "Text normalization backfill: " << *updated << " rows, up to id " << last_id;
+    }
+    return false;
+}
+
+// Moves the rows of the pre-partitioning table out of news_default into weekly
+// partitions, oldest week first and one week per transaction. A week that
+// overlaps partitions of another unit stays in news_default, as it would for
+// news_ensure_partition anywhere else.
+bool BackfillNewsPartitions(PostgresClient& client, const std::atomic<bool>& should_stop) {
+    std::string after = "-infinity";
+    while (!should_stop) {
+        const auto week = client.QueryRows(
+            "SELECT week_start, week_start + INTERVAL '1 week' FROM ("
+            "SELECT date_trunc('week', MIN(created_at), 'UTC') AS week_start FROM news_default "
+            "WHERE created_at >= " + client.EscapeString(after) + "::TIMESTAMPTZ) AS oldest");
+        if (!week || week->size() != 1) {
+            return false;
+        }
+        if ((*week)[0][0].empty()) {
+            return true;
+        }
+
+        // Partition maintenance may be creating partitions at the same time
+        const auto& week_start = (*week)[0][0];
+        const auto moved = client.Execute("BEGIN") &&
+                           client.Execute("SELECT pg_advisory_xact_lock(" + std::string(kPartitionLockKey) + ")") &&
+                           client.Execute("SELECT news_ensure_partition(" + client.EscapeString(week_start) +
+                                          "::TIMESTAMPTZ, 'week')") &&
+                           client.Execute("COMMIT");
+        if (!moved) {
+            client.Execute("ROLLBACK");
+            return false;
+        }
+        LOG_INFO() << "Partitioning backfill: moved the week of " << week_start;
+        after = (*week)[0][1];
+    }
+    return false;
+}
+
+}  // namespace
+
+const std::vector<Migration>& GetMigrations() {
+    static const std::vector<Migration> migrations = {
+        {1, "create_news_table", kCreateNewsTable},
+        {2, "create_latest_news_indexes", kCreateLatestNewsIndexes},
+        {3, "add_content_key", kAddContentKey, BackfillContentKeys},
+        {4, "add_news_snippet", kAddNewsSnippet},
+        {5, "partition_news_by_created_at", kPartitionNews, BackfillNewsPartitions},
+        {6, "create_ingest_stats", kCreateIngestStats},
+        {7, "add_text_normalized", kAddTextNormalized, BackfillTextNormalization},
+    };
+    return migrations;
+}
+
+bool ApplyMigrations(PostgresClient& client) {
+    if (!client.Execute("CREATE TABLE IF NOT EXISTS schema_migrations ("
+                        "version INT PRIMARY KEY, "
+                        "name TEXT NOT NULL, "
+                        "applied_at TIMESTAMPTZ NOT NULL DEFAULT CURRENT_TIMESTAMP)") ||
+        !client.Execute("ALTER TABLE schema_migrations ADD COLUMN IF NOT EXISTS backfilled_at TIMESTAMPTZ")) {
+        return false;
+    }
+
+    if (!client.Execute("SELECT pg_advisory_lock(" + std::string(kMigrationLockKey) + ")")) {
+        return false;
+    }
+
+    bool success = true;
+    const auto current = client.QueryScalar("SELECT COALESCE(MAX(version), 0) FROM schema_migrations");
+    int current_version = current ? std::stoi(*current) : 0;
+    LOG_INFO() << "Database schema version: " << current_version;
+
+    for (const auto& migration : GetMigrations()) {
+        if (migration.version <= current_version) {
+            continue;
+        }
+
+        LOG_INFO() << "Applying migration " << migration.version << " (" << migration.name << ")";
+        // A migration with a backfill stays pending in backfilled_at until RunBackfills finishes it
+        const std::string record = "INSERT INTO schema_migrations (version, name, backfilled_at) VALUES (" +
+                                   std::to_string(migration.version) + ", " +
+                                   client.EscapeString(std::string(migration.name)) + ", " +
+                                   (migration.backfill ? "NULL" : "CURRENT_TIMESTAMP") + ")";
+
+        if (!client.Execute("BEGIN") ||
+            (!migration.sql.empty() && !client.Execute(std::string(migration.sql))) ||
+            !client.Execute(record) ||
+            !client.Execute("COMMIT")) {
+            LOG_ERROR() << "Migration " << migration.version << " failed, rolling back";
+            client.Execute("ROLLBACK");
+            success = false;
+            break;
+        }
+        current_version = migration.version;
+    }
+
+    client.Execute("SELECT pg_advisory_unlock(" + std::string(kMigrationLockKey) + ")");
+
+    if (success) {
+        LOG_INFO() << "Database schema is up to date at version " << current_version;
+    }
+    return success;
+}
+
+bool RunBackfills(PostgresClient& client, const std::atomic<bool>& should_stop) {
+    const auto locked = client.QueryScalar("SELECT pg_try_advisory_lock(" + std::string(kBackfillLockKey) + ")");
+    if (!locked) {
+        return false;
+    }
+    if (*locked != "t") {
+        LOG_INFO() << "Migration backfills are run by another instance";
+        return true;
+    }
+
+    bool success = true;
+    const auto pending =
+        client.QueryRows("SELECT version FROM schema_migrations WHERE backfilled_at IS NULL ORDER BY version");
+    if (!pending) {
+        success = false;
+    }
+    for (size_t i = 0; success && pending && i < pending->size(); ++i) {
+        const int version = std::stoi((*pending)[i][0]);
+        const auto& migrations = GetMigrations();
+        const auto migration = std::find_if(migrations.begin(), migrations.end(),
+                                            [version](const Migration& m) { return m.version == version; });
+        if (migration == migrations.end() || !migration->backfill) {
+            continue;
+        }
+
+        LOG_INFO() << "Backfilling migration " << version << " (" << migration->name << ")";
+        if (!migration->backfill(client, should_stop) ||
+            !client.Execute("UPDATE schema_migrations SET backfilled_at = CURRENT_TIMESTAMP WHERE version = " +
+                            std::to_string(version))) {
+            LOG_WARNING() << "Backfill of migration " << version << " did not finish, it resumes on the next start";
+            success = false;
+        }
+    }
+
+    client.Execute("SELECT pg_advisory_unlock(" + std::string(kBackfillLockKey) + ")");
+    return success;
+}
+
+}  // namespace news_aggregator::storage
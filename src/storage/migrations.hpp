@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// Moves existing rows to what a migration's schema change expects, one short
+// transaction per batch, so it never holds locks on the whole table. Must be
+// safe to resume from the start after an interruption. Returns false when it
+// failed or was stopped before finishing; it is retried on the next start.
+using Backfill = bool (*)(PostgresClient& client, const std::atomic<bool>& should_stop);
+
+struct Migration {
+    int version;
+    std::string_view name;
+    std::string_view sql;
+    Backfill backfill = nullptr;
+};
+
+// Ordered list of schema migrations; new entries are only ever appended
+const std::vector<Migration>& GetMigrations();
+
+// Applies every migration newer than the version recorded in schema_migrations.
+// Each migration runs in its own transaction under an advisory lock, so several
+// StorageService instances may start concurrently.
+bool ApplyMigrations(PostgresClient& client);
+
+// Runs the backfills of applied migrations that have not finished yet. Meant
+// for a background task after startup; when another instance is already
+// running them this returns right away.
+bool RunBackfills(PostgresClient& client, const std::atomic<bool>& should_stop);
+
+}  // namespace news_aggregator::storage
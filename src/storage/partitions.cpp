@@ -0,0 +1,60 @@
+#include "partitions.hpp"
+#include <userver/logging/log.hpp>
+
+namespace news_aggregator::storage {
+
+bool MaintainPartitions(PostgresClient& client, const PartitioningConfig& config) {
+    const auto locked = client.QueryScalar("SELECT pg_try_advisory_lock(" + std::string(kPartitionLockKey) + ")");
+    if (!locked) {
+        return false;
+    }
+    if (*locked != "t") {
+        LOG_DEBUG() << "Partition maintenance is running on another instance";
+        return true;
+    }
+    
+    const std::string unit = client.EscapeString(config.unit);
+    bool success = client.Execute(
+        "SELECT news_ensure_partition(CURRENT_TIMESTAMP + period * ('1 ' || " + unit + ")::INTERVAL, " + unit + ") "
+        "FROM generate_series(0, " + std::to_string(config.premake_periods) + ") AS period");
+    
+    if (success && config.retention_days > 0) {
+        const auto expired = client.QueryScalar(
+            "SELECT COUNT(*) FROM news_expire_partitions(CURRENT_TIMESTAMP - INTERVAL '" +
+            std::to_string(config.retention_days) + " days', " + (config.drop_expired ? "TRUE" : "FALSE") + ")");
+        if (!expired) {
+            success = false;
+        } else if (*expired != "0") {
+            LOG_INFO() << (config.drop_expired ? "Dropped " : "Detached ") << *expired
+                       << " news partitions older than " << config.retention_days << " days";
+        }
+    }
+    
+    client.Execute("SELECT pg_advisory_unlock(" + std::string(kPartitionLockKey) + ")");
+    return success;
+}
+
+std::optional<std::vector<PartitionRange>> ListPartitionsEndedBefore(PostgresClient& client, int older_than_days) {
+    // Same bound parsing as news_expire_partitions
+    const auto rows = client.QueryRows(
+        "SELECT partition_name, lower_bound, upper_bound FROM ("
+        "  SELECT c.relname::TEXT AS partition_name,"
+        "         (regexp_match(pg_get_expr(c.relpartbound, c.oid), 'FROM \\(''([^'']+)''\\)'))[1] AS lower_bound,"
+        "         (regexp_match(pg_get_expr(c.relpartbound, c.oid), 'TO \\(''([^'']+)''\\)'))[1] AS upper_bound"
+        "  FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid"
+        "  WHERE i.inhparent = 'news'::REGCLASS AND c.relname ~ '^news_(day|week|month)_[0-9]{8}$'"
+        ") AS partitions "
+        "WHERE upper_bound::TIMESTAMPTZ <= CURRENT_TIMESTAMP - INTERVAL '" + std::to_string(older_than_days) +
+        " days' ORDER BY lower_bound::TIMESTAMPTZ");
+    if (!rows) {
+        return std::nullopt;
+    }
+    
+    std::vector<PartitionRange> partitions;
+    for (const auto& row : *rows) {
+        partitions.push_back(PartitionRange{row[0], row[1], row[2]});
+    }
+    return partitions;
+}
+
+}  // namespace news_aggregator::storage
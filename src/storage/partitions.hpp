@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// pg_advisory_lock key that serializes partition creation between instances
+inline constexpr std::string_view kPartitionLockKey = "727174002";
+
+struct PartitioningConfig {
+    std::string unit = "week";  // day, week or month
+    int premake_periods = 4;    // future partitions kept ready ahead of ingest
+    int retention_days = 0;     // 0 keeps every partition
+    bool drop_expired = false;  // drop expired partitions instead of detaching them
+};
+
+// Creates the partitions for the current and the next `premake_periods`
+// periods, then detaches or drops partitions older than the retention period.
+// Safe to run concurrently from several instances.
+bool MaintainPartitions(PostgresClient& client, const PartitioningConfig& config);
+
+struct PartitionRange {
+    std::string name;
+    std::string lower_bound;  // TIMESTAMPTZ text, inclusive
+    std::string upper_bound;  // exclusive
+};
+
+// Range partitions of news that ended more than `older_than_days` ago, oldest first
+std::optional<std::vector<PartitionRange>> ListPartitionsEndedBefore(PostgresClient& client, int older_than_days);
+
+}  // namespace news_aggregator::storage
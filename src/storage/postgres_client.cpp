@@ -1,9 +1,63 @@
 #include "postgres_client.hpp"
+#include "content_key.hpp"
+#include "snippet.hpp"
 #include <userver/logging/log.hpp>
+#include <charconv>
 #include <stdexcept>
 
 namespace news_aggregator::storage {
 
+namespace {
+
+// Column lists of the queries that materialize NewsItem rows, see ReadNewsItems.
+// Listings never read the article body.
+constexpr std::string_view kSummaryColumns =
+    "id, title, ''::TEXT, snippet, source, category, published_at, url, "
+    "(EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT";
+constexpr std::string_view kDetailColumns =
+    "id, title, content, snippet, source, category, published_at, url, "
+    "(EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT";
+
+// PostgreSQL array literal of `ids`, bound as one INT[] parameter
+std::string FormatIdArray(const std::vector<int>& ids) {
+    std::string id_array = "{";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i != 0) {
+            id_array += ',';
+        }
+        id_array += std::to_string(ids[i]);
+    }
+    id_array += '}';
+    return id_array;
+}
+
+NewsItem ReadNewsItem(PGresult* result, int row) {
+    NewsItem item;
+    item.id = std::stoi(PQgetvalue(result, row, 0));
+    item.title = PQgetvalue(result, row, 1);
+    item.content = PQgetvalue(result, row, 2);
+    item.snippet = PQgetisnull(result, row, 3) ? "" : PQgetvalue(result, row, 3);
+    item.source = PQgetvalue(result, row, 4);
+    item.category = PQgetvalue(result, row, 5);
+    item.published_at = PQgetvalue(result, row, 6);
+    item.url = PQgetisnull(result, row, 7) ? "" : PQgetvalue(result, row, 7);
+    item.created_at_us = std::stoll(PQgetvalue(result, row, 8));
+    return item;
+}
+
+std::vector<NewsItem> ReadNewsItems(PGresult* result) {
+    std::vector<NewsItem> news;
+    const int rows = PQntuples(result);
+    news.reserve(rows);
+    
+    for (int i = 0; i < rows; ++i) {
+        news.push_back(ReadNewsItem(result, i));
+    }
+    return news;
+}
+
+}  // namespace
+
 PostgresClient::PostgresClient(const std::string& connection_string)
     : connection_string_(connection_string), connection_(nullptr) {
 }
@@ -41,87 +95,375 @@ bool PostgresClient::IsConnected() const {
     return connection_ && PQstatus(connection_) == CONNECTION_OK;
 }
 
+std::string EncodeCursor(const NewsCursor& cursor) {
+    return std::to_string(cursor.created_at_us) + "_" + std::to_string(cursor.id);
+}
+
+std::optional<NewsCursor> ParseCursor(std::string_view text) {
+    const auto separator = text.find('_');
+    if (separator == std::string_view::npos || separator == 0 || separator + 1 == text.size()) {
+        return std::nullopt;
+    }
+
+    NewsCursor cursor;
+    const auto ts_part = text.substr(0, separator);
+    const auto id_part = text.substr(separator + 1);
+    const auto ts_result = std::from_chars(ts_part.data(), ts_part.data() + ts_part.size(), cursor.created_at_us);
+    const auto id_result = std::from_chars(id_part.data(), id_part.data() + id_part.size(), cursor.id);
+    if (ts_result.ec != std::errc{} || ts_result.ptr != ts_part.data() + ts_part.size() ||
+        id_result.ec != std::errc{} || id_result.ptr != id_part.data() + id_part.size()) {
+        return std::nullopt;
+    }
+    return cursor;
+}
+
+NewsCursor CursorOf(const NewsItem& item) {
+    return NewsCursor{item.created_at_us, item.id};
+}
+
 std::vector<NewsItem> PostgresClient::GetLatestNews(int limit) {
-    std::vector<NewsItem> news;
+    NewsQuery query;
+    query.limit = limit;
+    return GetLatestNews(query);
+}
+
+std::vector<NewsItem> PostgresClient::GetLatestNews(const NewsQuery& query) {
+    // Every filter combination is served by one of the (…, created_at DESC, id DESC)
+    // indexes, so the scan stops after `limit` rows regardless of page depth
+    std::vector<std::string> params;
+    std::string where;
+    auto add_condition = [&where](const std::string& condition) {
+        where += where.empty() ? " WHERE " : " AND ";
+        where += condition;
+    };
+    
+    if (!query.category.empty()) {
+        params.push_back(query.category);
+        add_condition("category = $" + std::to_string(params.size()));
+    }
+    if (!query.source.empty()) {
+        params.push_back(query.source);
+        add_condition("source = $" + std::to_string(params.size()));
+    }
+    
+    if (query.before) {
+        params.push_back(std::to_string(query.before->created_at_us));
+        const auto ts_param = "$" + std::to_string(params.size());
+        params.push_back(std::to_string(query.before->id));
+        const auto id_param = "$" + std::to_string(params.size());
+        add_condition("(created_at, id) < (TIMESTAMPTZ 'epoch' + " + ts_param +
+                      "::BIGINT * INTERVAL '1 microsecond', " + id_param + "::INT)");
+        // Redundant with the row comparison, but only a plain bound prunes partitions
+        add_condition("created_at <= TIMESTAMPTZ 'epoch' + " + ts_param + "::BIGINT * INTERVAL '1 microsecond'");
+    }
     
+    // One statement: the partitions' indexes are merged newest first and the
+    // merge stops after `limit` rows, so older partitions cost one index probe
+    return QueryNews("SELECT " + std::string(kSummaryColumns) + " FROM news" + where +
+                         " ORDER BY created_at DESC, id DESC LIMIT " + std::to_string(query.limit),
+                     params);
+}
+
+std::vector<NewsItem> PostgresClient::GetNewsCreatedBetween(int64_t from_us, int64_t to_us) {
+    const std::string sql =
+        "SELECT " + std::string(kSummaryColumns) + " FROM news "
+        "WHERE created_at >= TIMESTAMPTZ 'epoch' + $1::BIGINT * INTERVAL '1 microsecond' "
+        "AND created_at < TIMESTAMPTZ 'epoch' + $2::BIGINT * INTERVAL '1 microsecond' "
+        "ORDER BY created_at DESC, id DESC";
+    return QueryNews(sql, {std::to_string(from_us), std::to_string(to_us)});
+}
+
+std::vector<NewsItem> PostgresClient::GetNewsByIds(const std::vector<int>& ids) {
+    if (ids.empty()) {
+        return {};
+    }
+    const std::string sql = "SELECT " + std::string(kDetailColumns) + " FROM news WHERE id = ANY($1::INT[])";
+    return QueryNews(sql, {FormatIdArray(ids)});
+}
+
+std::vector<NewsItem> PostgresClient::GetNewsSummariesByIds(const std::vector<int>& ids) {
+    if (ids.empty()) {
+        return {};
+    }
+    const std::string sql = "SELECT " + std::string(kSummaryColumns) + " FROM news WHERE id = ANY($1::INT[])";
+    return QueryNews(sql, {FormatIdArray(ids)});
+}
+
+PostgresClient::StreamStatus PostgresClient::StreamNewsCreatedBetween(
+    const std::string& from, const std::string& to, const std::function<bool(NewsItem&&)>& on_row) {
     if (!IsConnected()) {
         LOG_ERROR() << "Not connected to PostgreSQL";
-        return news;
+        return StreamStatus::kFailed;
     }
     
-    std::string query = "SELECT id, title, content, source, category, published_at, url FROM news ORDER BY created_at DESC LIMIT " + std::to_string(limit);
+    const std::string sql = "SELECT " + std::string(kDetailColumns) + " FROM news "
+                            "WHERE created_at >= $1::TIMESTAMPTZ AND created_at < $2::TIMESTAMPTZ "
+                            "ORDER BY created_at, id";
+    const char* values[2] = {from.c_str(), to.c_str()};
     
-    LOG_INFO() << "Executing query: " << query;
+    // Single-row mode hands over one row per PGresult, so memory use does not
+    // depend on the size of the range
+    if (!PQsendQueryParams(connection_, sql.c_str(), 2, nullptr, values, nullptr, nullptr, 0) ||
+        !PQsetSingleRowMode(connection_)) {
+        LOG_ERROR() << "PostgreSQL export query failed: " << PQerrorMessage(connection_);
+        while (PGresult* result = PQgetResult(connection_)) {
+            PQclear(result);
+        }
+        return StreamStatus::kFailed;
+    }
     
-    PGresult* result = PQexec(connection_, query.c_str());
+    auto status = StreamStatus::kDone;
+    while (PGresult* result = PQgetResult(connection_)) {
+        const auto result_status = PQresultStatus(result);
+        if (result_status == PGRES_SINGLE_TUPLE) {
+            if (status == StreamStatus::kDone && !on_row(ReadNewsItem(result, 0))) {
+                status = StreamStatus::kStopped;
+                // Stop the server from producing rows nobody reads; the
+                // remaining results are drained below
+                if (PGcancel* cancel = PQgetCancel(connection_)) {
+                    char error[256];
+                    PQcancel(cancel, error, sizeof(error));
+                    PQfreeCancel(cancel);
+                }
+            }
+        } else if (result_status != PGRES_TUPLES_OK && status == StreamStatus::kDone) {
+            // SQLSTATE class 22 is a data exception, e.g. a malformed timestamp
+            const char* sqlstate = PQresultErrorField(result, PG_DIAG_SQLSTATE);
+            const bool invalid_input = sqlstate && std::string_view(sqlstate).substr(0, 2) == "22";
+            status = invalid_input ? StreamStatus::kInvalidInput : StreamStatus::kFailed;
+            if (!invalid_input) {
+                LOG_ERROR() << "PostgreSQL export failed: " << PQresultErrorMessage(result);
+            }
+        }
+        PQclear(result);
+    }
+    return status;
+}
+
+std::optional<NewsCursor> PostgresClient::GetCursorAtDepth(int depth) {
+    if (!IsConnected() || depth <= 0) {
+        return std::nullopt;
+    }
     
+    const std::string sql = "SELECT (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, id FROM news "
+                            "ORDER BY created_at DESC, id DESC OFFSET " + std::to_string(depth - 1) + " LIMIT 1";
+    PGresult* result = PQexec(connection_, sql.c_str());
+    
+    std::optional<NewsCursor> cursor;
     if (PQresultStatus(result) != PGRES_TUPLES_OK) {
         LOG_ERROR() << "PostgreSQL query failed: " << PQerrorMessage(connection_);
-        PQclear(result);
-        return news;
+    } else if (PQntuples(result) == 1) {
+        cursor = NewsCursor{std::stoll(PQgetvalue(result, 0, 0)), std::stoi(PQgetvalue(result, 0, 1))};
+    }
+    PQclear(result);
+    return cursor;
+}
+
+std::optional<NewsChecksum> PostgresClient::GetNewsChecksum(const std::optional<NewsCursor>& from) {
+    if (!IsConnected()) {
+        return std::nullopt;
     }
     
-    int rows = PQntuples(result);
-    LOG_INFO() << "Query returned " << rows << " rows";
+    std::string sql = "SELECT COUNT(*), COALESCE(SUM(id), 0) FROM news";
+    std::vector<std::string> params;
+    if (from) {
+        sql += " WHERE (created_at, id) >= (TIMESTAMPTZ 'epoch' + $1::BIGINT * INTERVAL '1 microsecond', $2::INT)";
+        params = {std::to_string(from->created_at_us), std::to_string(from->id)};
+    }
+    std::vector<const char*> values;
+    for (const auto& param : params) {
+        values.push_back(param.c_str());
+    }
+    PGresult* result = PQexecParams(connection_, sql.c_str(), static_cast<int>(values.size()), nullptr,
+                                    values.data(), nullptr, nullptr, 0);
     
-    for (int i = 0; i < rows; ++i) {
-        NewsItem item;
-        item.id = std::stoi(PQgetvalue(result, i, 0));
-        item.title = PQgetvalue(result, i, 1);
-        item.content = PQgetvalue(result, i, 2);
-        item.source = PQgetvalue(result, i, 3);
-        item.category = PQgetvalue(result, i, 4);
-        item.published_at = PQgetvalue(result, i, 5);
-        item.url = PQgetisnull(result, i, 6) ? "" : PQgetvalue(result, i, 6);
-        news.push_back(item);
-        LOG_INFO() << "Retrieved news item: " << item.title << " (ID: " << item.id << ")";
+    std::optional<NewsChecksum> checksum;
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+        LOG_ERROR() << "PostgreSQL query failed: " << PQerrorMessage(connection_);
+    } else if (PQntuples(result) == 1) {
+        checksum = NewsChecksum{std::stoll(PQgetvalue(result, 0, 0)), std::stoll(PQgetvalue(result, 0, 1))};
+    }
+    PQclear(result);
+    return checksum;
+}
+
+std::vector<NewsItem> PostgresClient::QueryNews(const std::string& sql, const std::vector<std::string>& params) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return {};
+    }
+    
+    LOG_DEBUG() << "Executing query: " << sql;
+    
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const auto& param : params) {
+        values.push_back(param.c_str());
     }
     
+    PGresult* result = PQexecParams(connection_, sql.c_str(), static_cast<int>(values.size()), nullptr,
+                                    values.data(), nullptr, nullptr, 0);
+    
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+        LOG_ERROR() << "PostgreSQL query failed: " << PQerrorMessage(connection_);
+        PQclear(result);
+        return {};
+    }
+    
+    auto news = ReadNewsItems(result);
+    LOG_DEBUG() << "Query returned " << news.size() << " rows";
     PQclear(result);
     return news;
 }
 
-int PostgresClient::AddNews(const std::string& title, const std::string& content, 
-                           const std::string& source, const std::string& category, 
-                           const std::string& url) {
+AddNewsResult PostgresClient::AddNews(const NewsItem& item) {
+    const int64_t content_key = ComputeContentKey(item);
+    std::vector<AddNewsResult> results{InsertNews(item, content_key)};
+    ResolveDuplicates(results, {content_key});
+    return results.front();
+}
+
+AddNewsResult PostgresClient::InsertNews(const NewsItem& item, int64_t content_key_value) {
+    AddNewsResult add_result;
+    
     if (!IsConnected()) {
         LOG_ERROR() << "Not connected to PostgreSQL";
-        return -1;
+        return add_result;
     }
     
-    std::string query = "INSERT INTO news (title, content, source, category, url) VALUES ($1, $2, $3, $4, $5) RETURNING id";
+    const std::string content_key = std::to_string(content_key_value);
+    const std::string snippet = item.snippet.empty() ? MakeSnippet(item.content) : item.snippet;
+    
+    // news is partitioned, so uniqueness of the content key lives in news_keys:
+    // the row is only inserted if claiming its key succeeded
+    std::string query = "WITH claimed AS ("
+                        "INSERT INTO news_keys (content_key, news_id, created_at) "
+                        "VALUES ($6, nextval('news_id_seq'), CURRENT_TIMESTAMP) "
+                        "ON CONFLICT (content_key) DO NOTHING "
+                        "RETURNING news_id, created_at) "
+                        "INSERT INTO news (id, title, content, source, category, url, content_key, snippet, created_at, "
+                        "text_normalized) "
+                        "SELECT news_id, $1, $2, $3, $4, $5, $6, $7, created_at, TRUE FROM claimed "
+                        "RETURNING id, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT, published_at";
     
-    const char* values[5] = {
-        title.c_str(),
-        content.c_str(),
-        source.c_str(),
-        category.c_str(),
-        url.c_str()
+    const char* values[7] = {
+        item.title.c_str(),
+        item.content.c_str(),
+        item.source.c_str(),
+        item.category.c_str(),
+        item.url.c_str(),
+        content_key.c_str(),
+        snippet.c_str()
     };
     
-    int lengths[5] = {
-        static_cast<int>(title.length()),
-        static_cast<int>(content.length()),
-        static_cast<int>(source.length()),
-        static_cast<int>(category.length()),
-        static_cast<int>(url.length())
+    int lengths[7] = {
+        static_cast<int>(item.title.length()),
+        static_cast<int>(item.content.length()),
+        static_cast<int>(item.source.length()),
+        static_cast<int>(item.category.length()),
+        static_cast<int>(item.url.length()),
+        static_cast<int>(content_key.length()),
+        static_cast<int>(snippet.length())
     };
     
-    int formats[5] = {0, 0, 0, 0, 0}; // text format
+    int formats[7] = {0, 0, 0, 0, 0, 0, 0}; // text format
     
-    PGresult* result = PQexecParams(connection_, query.c_str(), 5, nullptr, values, lengths, formats, 0);
+    PGresult* result = PQexecParams(connection_, query.c_str(), 7, nullptr, values, lengths, formats, 0);
     
     if (PQresultStatus(result) != PGRES_TUPLES_OK) {
         LOG_ERROR() << "PostgreSQL insert failed: " << PQerrorMessage(connection_);
         PQclear(result);
-        return -1;
+        return add_result;
+    }
+    
+    if (PQntuples(result) == 1) {
+        add_result.id = std::stoi(PQgetvalue(result, 0, 0));
+        add_result.created_at_us = std::stoll(PQgetvalue(result, 0, 1));
+        add_result.published_at = PQgetvalue(result, 0, 2);
+        add_result.inserted = true;
+        LOG_INFO() << "Successfully inserted news with ID: " << add_result.id;
+    } else {
+        add_result.duplicate = true;
+    }
+    PQclear(result);
+    return add_result;
+}
+
+void PostgresClient::ResolveDuplicates(std::vector<AddNewsResult>& results, const std::vector<int64_t>& content_keys) {
+    std::string key_array;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].duplicate) {
+            key_array += key_array.empty() ? "{" : ",";
+            key_array += std::to_string(content_keys[i]);
+        }
+    }
+    if (key_array.empty()) {
+        return;
+    }
+    key_array += '}';
+    
+    // Report the id of the row that already holds each story. A failed lookup
+    // leaves the ids unknown; the items are still duplicates, not failures.
+    const char* values[1] = {key_array.c_str()};
+    PGresult* result = PQexecParams(connection_,
+                                    "SELECT content_key, news_id, (EXTRACT(EPOCH FROM created_at) * 1000000)::BIGINT "
+                                    "FROM news_keys WHERE content_key = ANY($1::BIGINT[])",
+                                    1, nullptr, values, nullptr, nullptr, 0);
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+        LOG_WARNING() << "Failed to look up the ids of duplicate news: " << PQerrorMessage(connection_);
+        PQclear(result);
+        return;
     }
     
-    int news_id = std::stoi(PQgetvalue(result, 0, 0));
+    for (int row = 0; row < PQntuples(result); ++row) {
+        const int64_t key = std::stoll(PQgetvalue(result, row, 0));
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].duplicate && content_keys[i] == key) {
+                results[i].id = std::stoi(PQgetvalue(result, row, 1));
+                results[i].created_at_us = std::stoll(PQgetvalue(result, row, 2));
+                LOG_DEBUG() << "Skipped duplicate news item, existing ID: " << results[i].id;
+            }
+        }
+    }
     PQclear(result);
+}
+
+std::vector<AddNewsResult> PostgresClient::AddNewsBatch(const std::vector<NewsItem>& items) {
+    std::vector<int64_t> content_keys;
+    content_keys.reserve(items.size());
+    for (const auto& item : items) {
+        content_keys.push_back(ComputeContentKey(item));
+    }
+    
+    std::vector<AddNewsResult> results;
+    results.reserve(items.size());
     
-    LOG_INFO() << "Successfully inserted news with ID: " << news_id;
-    return news_id;
+    bool committed = false;
+    if (items.size() > 1 && Execute("BEGIN")) {
+        bool aborted = false;
+        for (size_t i = 0; i < items.size(); ++i) {
+            results.push_back(InsertNews(items[i], content_keys[i]));
+            if (!results.back().inserted && !results.back().duplicate) {
+                aborted = true;
+                break;
+            }
+        }
+        
+        committed = !aborted && Execute("COMMIT");
+        if (!committed) {
+            LOG_WARNING() << "Group insert of " << items.size() << " news items failed, retrying one by one";
+            Execute("ROLLBACK");
+            results.clear();
+        }
+    }
+    
+    if (!committed) {
+        for (size_t i = 0; i < items.size(); ++i) {
+            results.push_back(InsertNews(items[i], content_keys[i]));
+        }
+    }
+    ResolveDuplicates(results, content_keys);
+    return results;
 }
 
 std::string PostgresClient::EscapeString(const std::string& str) {
@@ -140,4 +482,131 @@ std::string PostgresClient::EscapeString(const std::string& str) {
     return result;
 }
 
+bool PostgresClient::Execute(const std::string& sql) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return false;
+    }
+    
+    PGresult* result = PQexec(connection_, sql.c_str());
+    const auto status = PQresultStatus(result);
+    
+    if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
+        LOG_ERROR() << "PostgreSQL statement failed: " << PQerrorMessage(connection_);
+        PQclear(result);
+        return false;
+    }
+    
+    PQclear(result);
+    return true;
+}
+
+std::optional<std::string> PostgresClient::QueryScalar(const std::string& sql) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return std::nullopt;
+    }
+    
+    PGresult* result = PQexec(connection_, sql.c_str());
+    
+    if (PQresultStatus(result) != PGRES_TUPLES_OK || PQntuples(result) == 0 || PQgetisnull(result, 0, 0)) {
+        if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+            LOG_ERROR() << "PostgreSQL query failed: " << PQerrorMessage(connection_);
+        }
+        PQclear(result);
+        return std::nullopt;
+    }
+    
+    std::string value = PQgetvalue(result, 0, 0);
+    PQclear(result);
+    return value;
+}
+
+std::optional<std::vector<std::vector<std::string>>> PostgresClient::QueryRows(const std::string& sql) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return std::nullopt;
+    }
+    
+    PGresult* result = PQexec(connection_, sql.c_str());
+    
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+        LOG_ERROR() << "PostgreSQL query failed: " << PQerrorMessage(connection_);
+        PQclear(result);
+        return std::nullopt;
+    }
+    
+    const int rows = PQntuples(result);
+    const int columns = PQnfields(result);
+    std::vector<std::vector<std::string>> values(rows);
+    for (int row = 0; row < rows; ++row) {
+        values[row].reserve(columns);
+        for (int column = 0; column < columns; ++column) {
+            values[row].emplace_back(PQgetvalue(result, row, column), PQgetlength(result, row, column));
+        }
+    }
+    PQclear(result);
+    return values;
+}
+
+std::optional<int64_t> PostgresClient::ExecuteAffected(const std::string& sql) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return std::nullopt;
+    }
+    
+    PGresult* result = PQexec(connection_, sql.c_str());
+    
+    if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+        LOG_ERROR() << "PostgreSQL statement failed: " << PQerrorMessage(connection_);
+        PQclear(result);
+        return std::nullopt;
+    }
+    
+    const char* affected = PQcmdTuples(result);
+    const int64_t count = (affected && *affected) ? std::stoll(affected) : 0;
+    PQclear(result);
+    return count;
+}
+
+bool PostgresClient::BeginCopy(const std::string& copy_sql) {
+    if (!IsConnected()) {
+        LOG_ERROR() << "Not connected to PostgreSQL";
+        return false;
+    }
+    
+    PGresult* result = PQexec(connection_, copy_sql.c_str());
+    const bool ready = PQresultStatus(result) == PGRES_COPY_IN;
+    if (!ready) {
+        LOG_ERROR() << "PostgreSQL COPY failed to start: " << PQerrorMessage(connection_);
+    }
+    PQclear(result);
+    return ready;
+}
+
+bool PostgresClient::PutCopyData(std::string_view data) {
+    if (PQputCopyData(connection_, data.data(), static_cast<int>(data.size())) != 1) {
+        LOG_ERROR() << "PostgreSQL COPY data failed: " << PQerrorMessage(connection_);
+        return false;
+    }
+    return true;
+}
+
+bool PostgresClient::EndCopy() {
+    if (PQputCopyEnd(connection_, nullptr) != 1) {
+        LOG_ERROR() << "PostgreSQL COPY end failed: " << PQerrorMessage(connection_);
+        return false;
+    }
+    
+    bool success = true;
+    while (PGresult* result = PQgetResult(connection_)) {
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+            LOG_ERROR() << "PostgreSQL COPY failed: " << PQerrorMessage(connection_);
+            success = false;
+        }
+        PQclear(result);
+    }
+    return success;
+}
+
 }  // namespace news_aggregator::storage
\ No newline at end of file
@@ -1,38 +1,129 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <postgresql@14/libpq-fe.h>
 
 namespace news_aggregator::storage {
 
+// Listing queries return summary rows: `snippet` is set and `content` is empty.
+// The full body is only read by GetNewsByIds.
 struct NewsItem {
     int id;
     std::string title;
     std::string content;
+    std::string snippet;        // computed from content at ingest, see MakeSnippet
     std::string source;
     std::string category;
     std::string published_at;
     std::string url;
+    int64_t created_at_us = 0;  // created_at as microseconds since Unix epoch
+    std::string guid;           // feed GUID, only used to derive the content key
+};
+
+struct AddNewsResult {
+    int id = -1;             // id of the new row, or of the existing duplicate
+    bool inserted = false;
+    // The content key was already stored. The existing row's id is looked up
+    // afterwards and stays -1 when that lookup fails; the item is not failed.
+    bool duplicate = false;
+    int64_t created_at_us = 0;
+    std::string published_at;  // as stored, only set for inserted rows
+};
+
+// Position of the last row of a page, ordered by (created_at DESC, id DESC)
+struct NewsCursor {
+    int64_t created_at_us = 0;
+    int id = 0;
+};
+
+// Opaque "<created_at_us>_<id>" representation used in ?before=
+std::string EncodeCursor(const NewsCursor& cursor);
+std::optional<NewsCursor> ParseCursor(std::string_view text);
+NewsCursor CursorOf(const NewsItem& item);
+
+// Number and id sum of the rows in a range, a cheap fingerprint of its contents
+struct NewsChecksum {
+    int64_t count = 0;
+    int64_t id_sum = 0;
+};
+
+struct NewsQuery {
+    int limit = 10;
+    std::optional<NewsCursor> before;
+    std::string category;  // empty = any category
+    std::string source;    // empty = any source
+    // The caller was told rows up to this id are committed and must see them
+    int min_id = 0;
 };
 
 class PostgresClient {
 public:
+    enum class StreamStatus {
+        kDone,          // every row was handed to the callback
+        kStopped,       // the callback asked to stop
+        kInvalidInput,  // a parameter was rejected by PostgreSQL
+        kFailed,
+    };
+
     PostgresClient(const std::string& connection_string);
     ~PostgresClient();
-    
+
     bool Connect();
     void Disconnect();
     bool IsConnected() const;
-    
+
     std::vector<NewsItem> GetLatestNews(int limit);
-    int AddNews(const std::string& title, const std::string& content, 
-                const std::string& source, const std::string& category, 
-                const std::string& url = "");
+    std::vector<NewsItem> GetLatestNews(const NewsQuery& query);
+    // Rows with created_at in [from_us, to_us), newest first
+    std::vector<NewsItem> GetNewsCreatedBetween(int64_t from_us, int64_t to_us);
+    // Full rows including content, in no particular order; unknown ids are skipped
+    std::vector<NewsItem> GetNewsByIds(const std::vector<int>& ids);
+    // Listing columns only (no content), in no particular order; unknown ids are skipped
+    std::vector<NewsItem> GetNewsSummariesByIds(const std::vector<int>& ids);
+    // Full rows with created_at in [from, to), oldest first, handed to `on_row`
+    // one at a time while they arrive; `on_row` returns false to stop early.
+    // Bounds are anything PostgreSQL accepts as a TIMESTAMPTZ.
+    StreamStatus StreamNewsCreatedBetween(const std::string& from, const std::string& to,
+                                          const std::function<bool(NewsItem&&)>& on_row);
+    // Position of the depth-th newest row, std::nullopt if the table is smaller
+    std::optional<NewsCursor> GetCursorAtDepth(int depth);
+    // Checksum of the rows at or after `from` in (created_at, id) order, of
+    // the whole table without it
+    std::optional<NewsChecksum> GetNewsChecksum(const std::optional<NewsCursor>& from);
+    // Idempotent: a story whose content key is already stored is not inserted again
+    AddNewsResult AddNews(const NewsItem& item);
+    // Group commit: all items share one transaction. If it aborts, the items are
+    // retried one by one so a single bad row does not fail the whole group.
+    // Duplicates are resolved to their ids after the commit.
+    std::vector<AddNewsResult> AddNewsBatch(const std::vector<NewsItem>& items);
     std::string EscapeString(const std::string& str);
 
+    // Raw statement helpers, used by schema migrations
+    bool Execute(const std::string& sql);
+    std::optional<std::string> QueryScalar(const std::string& sql);
+    // Every row as text columns (NULL reads as empty), std::nullopt on error
+    std::optional<std::vector<std::vector<std::string>>> QueryRows(const std::string& sql);
+    // Number of rows affected by an INSERT/UPDATE/DELETE, std::nullopt on error
+    std::optional<int64_t> ExecuteAffected(const std::string& sql);
+
+    // COPY ... FROM STDIN streaming, used by the bulk importer
+    bool BeginCopy(const std::string& copy_sql);
+    bool PutCopyData(std::string_view data);
+    bool EndCopy();
+
 private:
+    // Claims the content key and inserts the row; a duplicate is only flagged
+    AddNewsResult InsertNews(const NewsItem& item, int64_t content_key);
+    // Fills in the ids of the rows already holding the keys of duplicates
+    void ResolveDuplicates(std::vector<AddNewsResult>& results, const std::vector<int64_t>& content_keys);
+    std::vector<NewsItem> QueryNews(const std::string& sql, const std::vector<std::string>& params);
+
     std::string connection_string_;
     PGconn* connection_;
 };
@@ -0,0 +1,201 @@
+#include "replica_set.hpp"
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr std::string_view kPrimaryPositionQuery = "SELECT pg_current_wal_lsn() - '0/0'::pg_lsn";
+// NULL replay position on a server that is not a standby
+constexpr std::string_view kReplayPositionQuery =
+    "SELECT pg_is_in_recovery(), pg_last_wal_replay_lsn() - '0/0'::pg_lsn";
+
+// Bounds primary_positions_ while a replica stays unreachable
+constexpr size_t kMaxPrimaryPositions = 4096;
+
+}  // namespace
+
+ReplicaSet::Lease::Lease(ReplicaSet& set, size_t index) : set_(&set), index_(index) {
+    auto& replica = *set_->replicas_[index_];
+    ++replica.outstanding;
+    ++replica.requests;
+}
+
+ReplicaSet::Lease::Lease(Lease&& other) noexcept : set_(other.set_), index_(other.index_) {
+    other.set_ = nullptr;
+}
+
+ReplicaSet::Lease& ReplicaSet::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        if (set_) {
+            --set_->replicas_[index_]->outstanding;
+        }
+        set_ = other.set_;
+        index_ = other.index_;
+        other.set_ = nullptr;
+    }
+    return *this;
+}
+
+ReplicaSet::Lease::~Lease() {
+    if (set_) {
+        --set_->replicas_[index_]->outstanding;
+    }
+}
+
+const std::string& ReplicaSet::Lease::GetDsn() const {
+    return set_->replicas_[index_]->dsn;
+}
+
+void ReplicaSet::Lease::MarkFailed() {
+    LOG_WARNING() << "Excluding replica " << index_ << " after a failed request";
+    set_->replicas_[index_]->healthy = false;
+}
+
+ReplicaSet::ReplicaSet(std::string primary_dsn, const std::vector<std::string>& dsns,
+                       std::chrono::milliseconds max_lag)
+    : primary_dsn_(std::move(primary_dsn)), max_lag_(max_lag) {
+    for (const auto& dsn : dsns) {
+        auto replica = std::make_unique<Replica>();
+        replica->dsn = dsn;
+        replicas_.push_back(std::move(replica));
+    }
+}
+
+ReplicaSet::~ReplicaSet() = default;
+
+std::optional<ReplicaSet::Lease> ReplicaSet::Acquire() {
+    if (replicas_.empty()) {
+        return std::nullopt;
+    }
+    
+    // Start the scan at a rotating offset so ties are spread evenly
+    const size_t start = next_++ % replicas_.size();
+    std::optional<size_t> best;
+    int best_outstanding = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < replicas_.size(); ++i) {
+        const size_t index = (start + i) % replicas_.size();
+        const auto& replica = *replicas_[index];
+        if (!replica.healthy) {
+            continue;
+        }
+        const int outstanding = replica.outstanding;
+        if (outstanding < best_outstanding) {
+            best = index;
+            best_outstanding = outstanding;
+        }
+    }
+    
+    if (!best) {
+        return std::nullopt;
+    }
+    return Lease(*this, *best);
+}
+
+void ReplicaSet::SamplePrimary() {
+    if (!primary_monitor_ || !primary_monitor_->IsConnected()) {
+        primary_monitor_ = std::make_unique<PostgresClient>(primary_dsn_);
+        if (!primary_monitor_->Connect()) {
+            LOG_WARNING() << "Cannot reach the primary to measure replica lag";
+            primary_monitor_.reset();
+            return;
+        }
+    }
+    
+    const auto position = primary_monitor_->QueryScalar(std::string(kPrimaryPositionQuery));
+    if (!position) {
+        primary_monitor_.reset();
+        return;
+    }
+    
+    const uint64_t lsn = std::stoull(*position);
+    if (primary_positions_.empty()) {
+        // When the primary got there is unknown, so a replica still behind the
+        // first sample counts as lagging until it has replayed it
+        primary_positions_.push_back({lsn, std::chrono::steady_clock::time_point{}});
+    } else if (lsn > primary_positions_.back().lsn) {
+        primary_positions_.push_back({lsn, std::chrono::steady_clock::now()});
+        if (primary_positions_.size() > kMaxPrimaryPositions) {
+            dropped_lsn_ = primary_positions_.front().lsn;
+            primary_positions_.pop_front();
+        }
+    }
+}
+
+std::chrono::milliseconds ReplicaSet::LagBehind(uint64_t replayed_lsn) const {
+    // Behind a dropped position, e.g. after being unreachable: since when is unknown
+    if (replayed_lsn < dropped_lsn_) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                     std::chrono::steady_clock::time_point{});
+    }
+    for (const auto& position : primary_positions_) {
+        if (position.lsn > replayed_lsn) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                         position.seen_at);
+        }
+    }
+    return std::chrono::milliseconds(0);
+}
+
+void ReplicaSet::CheckReplicas() {
+    SamplePrimary();
+    
+    std::optional<uint64_t> min_replayed;
+    for (size_t i = 0; i < replicas_.size(); ++i) {
+        auto& replica = *replicas_[i];
+        if (!replica.monitor || !replica.monitor->IsConnected()) {
+            replica.monitor = std::make_unique<PostgresClient>(replica.dsn);
+            if (!replica.monitor->Connect()) {
+                if (replica.healthy.exchange(false)) {
+                    LOG_WARNING() << "Replica " << i << " is unreachable, reads go elsewhere";
+                }
+                replica.monitor.reset();
+                continue;
+            }
+        }
+        
+        const auto rows = replica.monitor->QueryRows(std::string(kReplayPositionQuery));
+        if (!rows || rows->size() != 1) {
+            replica.healthy = false;
+            replica.monitor.reset();
+            continue;
+        }
+        
+        // A promoted replica no longer follows the primary
+        const auto& row = rows->front();
+        if (row[0] != "t" || row[1].empty()) {
+            if (replica.healthy.exchange(false)) {
+                LOG_WARNING() << "Replica " << i << " is not a standby, reads go elsewhere";
+            }
+            continue;
+        }
+        
+        const uint64_t replayed = std::stoull(row[1]);
+        min_replayed = std::min(min_replayed.value_or(replayed), replayed);
+        replica.lag_ms = LagBehind(replayed).count();
+        const bool healthy = replica.lag_ms <= max_lag_.count();
+        if (replica.healthy.exchange(healthy) != healthy) {
+            LOG_WARNING() << "Replica " << i << (healthy ? " is back in rotation" : " excluded")
+                          << ", replay lag " << replica.lag_ms << "ms";
+        }
+    }
+    
+    // Keep the newest position, the next samples are compared with it
+    while (min_replayed && primary_positions_.size() > 1 && primary_positions_.front().lsn <= *min_replayed) {
+        dropped_lsn_ = primary_positions_.front().lsn;
+        primary_positions_.pop_front();
+    }
+}
+
+std::vector<ReplicaStats> ReplicaSet::GetStats() const {
+    std::vector<ReplicaStats> stats;
+    stats.reserve(replicas_.size());
+    for (const auto& replica : replicas_) {
+        stats.push_back({replica->healthy, replica->lag_ms, replica->outstanding, replica->requests});
+    }
+    return stats;
+}
+
+}  // namespace news_aggregator::storage
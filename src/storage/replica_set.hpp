@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+struct ReplicaStats {
+    bool healthy = false;
+    int64_t lag_ms = -1;  // -1 until the first successful check
+    int outstanding = 0;
+    uint64_t requests = 0;
+};
+
+// Streaming-replication standbys that serve read queries. Reads go to the
+// healthy replica with the fewest requests in flight; a replica is excluded
+// while it is unreachable or its replay lags the primary by more than max_lag.
+//
+// Lag is measured against the primary's WAL position, sampled on every check:
+// it is the time since the primary reached the oldest sampled position the
+// replica has not replayed yet. A replica that lost its WAL receiver therefore
+// falls behind as soon as the primary writes, while one that is merely idle
+// stays current.
+class ReplicaSet {
+public:
+    // Keeps the chosen replica counted as busy until destroyed
+    class Lease {
+    public:
+        Lease(ReplicaSet& set, size_t index);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        const std::string& GetDsn() const;
+        // Excludes the replica until its next successful check
+        void MarkFailed();
+
+    private:
+        ReplicaSet* set_;
+        size_t index_;
+    };
+
+    ReplicaSet(std::string primary_dsn, const std::vector<std::string>& dsns, std::chrono::milliseconds max_lag);
+    ~ReplicaSet();
+
+    bool IsEmpty() const { return replicas_.empty(); }
+
+    // std::nullopt when no replica is usable and the read should go to the primary
+    std::optional<Lease> Acquire();
+
+    // Measures replay lag of every replica and updates its health. Blocking.
+    void CheckReplicas();
+
+    std::vector<ReplicaStats> GetStats() const;
+
+private:
+    struct Replica {
+        std::string dsn;
+        std::unique_ptr<PostgresClient> monitor;  // only used by CheckReplicas
+        std::atomic<bool> healthy{false};
+        std::atomic<int64_t> lag_ms{-1};
+        std::atomic<int> outstanding{0};
+        std::atomic<uint64_t> requests{0};
+    };
+
+    struct WalPosition {
+        uint64_t lsn;
+        std::chrono::steady_clock::time_point seen_at;
+    };
+
+    // Appends the primary's current WAL position to primary_positions_
+    void SamplePrimary();
+    std::chrono::milliseconds LagBehind(uint64_t replayed_lsn) const;
+
+    const std::string primary_dsn_;
+    const std::chrono::milliseconds max_lag_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    // Only used by CheckReplicas. Oldest first; positions every replica has
+    // replayed are dropped.
+    std::unique_ptr<PostgresClient> primary_monitor_;
+    std::deque<WalPosition> primary_positions_;
+    uint64_t dropped_lsn_ = 0;
+    std::atomic<size_t> next_{0};
+};
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,593 @@
+#include "search_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_set>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr size_t kMaxTermBytes = 64;
+// A title occurrence counts as this many body occurrences
+constexpr uint32_t kTitleWeight = 2;
+constexpr int kRecencyHalfLives = 32;
+constexpr int64_t kMicrosecondsPerHour = 3600LL * 1000000;
+
+bool IsAsciiWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+void PutVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+const uint8_t* GetVarint(const uint8_t* data, uint32_t& value) {
+    value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return data;
+        }
+    }
+}
+
+// First block at or after `from` that may contain `doc`
+size_t SeekBlock(const std::vector<PostingList::Block>& blocks, size_t from, uint32_t doc) {
+    return std::partition_point(blocks.begin() + from, blocks.end(),
+                                [doc](const PostingList::Block& block) { return block.last_doc < doc; }) -
+           blocks.begin();
+}
+
+}  // namespace
+
+std::vector<std::string> Tokenize(std::string_view text) {
+    std::vector<std::string> terms;
+    std::string current;
+    auto finish = [&terms, &current]() {
+        if (!current.empty() && current.size() <= kMaxTermBytes) {
+            terms.push_back(current);
+        }
+        current.clear();
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        
+        if (c < 0x80) {
+            // Skip markup, but keep a lone '<' in plain text as a separator
+            if (c == '<' && i + 1 < text.size() &&
+                (IsAsciiWordChar(text[i + 1]) || text[i + 1] == '/' || text[i + 1] == '!')) {
+                finish();
+                const auto tag_end = text.find('>', i);
+                i = tag_end == std::string_view::npos ? text.size() : tag_end + 1;
+                continue;
+            }
+            if (IsAsciiWordChar(c)) {
+                current.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : static_cast<char>(c));
+            } else {
+                finish();
+            }
+            ++i;
+            continue;
+        }
+        
+        const size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (length == 1 || i + length > text.size()) {
+            // Stray continuation byte or truncated sequence
+            finish();
+            ++i;
+            continue;
+        }
+        
+        const auto c1 = static_cast<unsigned char>(text[i + 1]);
+        if (c == 0xD0 && c1 >= 0x90 && c1 <= 0x9F) {
+            // А-П -> а-п
+            current += '\xD0';
+            current += static_cast<char>(c1 + 0x20);
+        } else if (c == 0xD0 && c1 >= 0xA0 && c1 <= 0xAF) {
+            // Р-Я -> р-я
+            current += '\xD1';
+            current += static_cast<char>(c1 - 0x20);
+        } else if ((c == 0xD0 && c1 == 0x81) || (c == 0xD1 && c1 == 0x91)) {
+            // Ё, ё -> е
+            current += "\xD0\xB5";
+        } else if (c == 0xC2 || (c == 0xE2 && c1 == 0x80)) {
+            // Latin-1 and general punctuation: NBSP, « », dashes, quotes, ellipsis
+            finish();
+        } else {
+            current.append(text.substr(i, length));
+        }
+        i += length;
+    }
+    finish();
+    return terms;
+}
+
+void PostingList::Append(uint32_t doc, uint32_t term_frequency) {
+    if (blocks_.empty() || blocks_.back().count == kBlockSize) {
+        blocks_.push_back(Block{doc, doc, static_cast<uint32_t>(data_.size()), 0});
+    }
+    auto& block = blocks_.back();
+    PutVarint(data_, block.count == 0 ? 0 : doc - block.last_doc);
+    PutVarint(data_, term_frequency);
+    block.last_doc = doc;
+    ++block.count;
+    ++document_frequency_;
+}
+
+void PostingList::Concat(const PostingList& other, uint32_t doc_offset) {
+    const auto data_offset = static_cast<uint32_t>(data_.size());
+    data_.insert(data_.end(), other.data_.begin(), other.data_.end());
+    blocks_.reserve(blocks_.size() + other.blocks_.size());
+    for (auto block : other.blocks_) {
+        block.first_doc += doc_offset;
+        block.last_doc += doc_offset;
+        block.offset += data_offset;
+        blocks_.push_back(block);
+    }
+    document_frequency_ += other.document_frequency_;
+}
+
+size_t PostingList::DecodeBlock(size_t index, uint32_t* docs, uint32_t* term_frequencies) const {
+    const auto& block = blocks_[index];
+    const uint8_t* data = data_.data() + block.offset;
+    uint32_t doc = block.first_doc;
+    for (uint32_t i = 0; i < block.count; ++i) {
+        uint32_t delta = 0;
+        uint32_t term_frequency = 0;
+        data = GetVarint(data, delta);
+        data = GetVarint(data, term_frequency);
+        doc += delta;
+        docs[i] = doc;
+        if (term_frequencies) {
+            term_frequencies[i] = term_frequency;
+        }
+    }
+    return block.count;
+}
+
+size_t IntersectSorted(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* a_positions,
+                       uint32_t* b_positions) {
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+    auto emit = [&](size_t a_position, size_t b_position) {
+        a_positions[count] = static_cast<uint32_t>(a_position);
+        b_positions[count] = static_cast<uint32_t>(b_position);
+        ++count;
+    };
+
+#if defined(__SSE2__)
+    // Compare 4 x 4 elements at a time: every rotation of the b vector against
+    // the a vector, then advance whichever side has the smaller maximum. Lane l
+    // of rotation r pairs a[i + l] with b[j + (l + r) % 4].
+    while (i + 4 <= a_size && j + 4 <= b_size) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        const int masks[4] = {
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb))),
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))))),
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))))),
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))))),
+        };
+        if (masks[0] | masks[1] | masks[2] | masks[3]) {
+            for (int lane = 0; lane < 4; ++lane) {
+                for (int rotation = 0; rotation < 4; ++rotation) {
+                    if (masks[rotation] & (1 << lane)) {
+                        emit(i + lane, j + (lane + rotation) % 4);
+                        break;
+                    }
+                }
+            }
+        }
+
+        const uint32_t a_max = a[i + 3];
+        const uint32_t b_max = b[j + 3];
+        if (a_max <= b_max) {
+            i += 4;
+        }
+        if (b_max <= a_max) {
+            j += 4;
+        }
+    }
+#endif
+
+    while (i < a_size && j < b_size) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            emit(i++, j++);
+        }
+    }
+    return count;
+}
+
+uint32_t SearchSegment::Intern(std::unordered_map<std::string, uint32_t>& ids, std::vector<std::string>& names,
+                               const std::string& value) {
+    const auto [it, inserted] = ids.emplace(value, static_cast<uint32_t>(names.size()));
+    if (inserted) {
+        names.push_back(value);
+    }
+    return it->second;
+}
+
+SearchSegment::DocumentTerms SearchSegment::CountTerms(const NewsItem& item) {
+    DocumentTerms terms;
+    for (auto& term : Tokenize(item.title)) {
+        terms.frequencies[std::move(term)] += kTitleWeight;
+        ++terms.length;
+    }
+    for (auto& term : Tokenize(item.content)) {
+        terms.frequencies[std::move(term)] += 1;
+        ++terms.length;
+    }
+    return terms;
+}
+
+void SearchSegment::Add(const NewsItem& item) {
+    Add(item, CountTerms(item));
+}
+
+void SearchSegment::Add(const NewsItem& item, const DocumentTerms& terms) {
+    const auto doc = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(Document{item.id, item.created_at_us, terms.length,
+                                  Intern(category_ids_, categories_, item.category),
+                                  Intern(source_ids_, sources_, item.source)});
+    total_length_ += terms.length;
+    for (const auto& [term, frequency] : terms.frequencies) {
+        postings_[term].Append(doc, frequency);
+    }
+}
+
+SearchSegment SearchSegment::CopyCreatedSince(int64_t cutoff_us) const {
+    constexpr uint32_t kRemoved = std::numeric_limits<uint32_t>::max();
+
+    SearchSegment copy;
+    copy.category_ids_ = category_ids_;
+    copy.categories_ = categories_;
+    copy.source_ids_ = source_ids_;
+    copy.sources_ = sources_;
+
+    // Kept documents are renumbered in their original order, so every
+    // posting list stays ascending
+    std::vector<uint32_t> renumbered(documents_.size(), kRemoved);
+    for (size_t doc = 0; doc < documents_.size(); ++doc) {
+        if (documents_[doc].created_at_us >= cutoff_us) {
+            renumbered[doc] = static_cast<uint32_t>(copy.documents_.size());
+            copy.documents_.push_back(documents_[doc]);
+            copy.total_length_ += documents_[doc].length;
+        }
+    }
+
+    uint32_t docs[PostingList::kBlockSize];
+    uint32_t frequencies[PostingList::kBlockSize];
+    for (const auto& [term, list] : postings_) {
+        PostingList kept;
+        for (size_t block = 0; block < list.GetBlocks().size(); ++block) {
+            const size_t count = list.DecodeBlock(block, docs, frequencies);
+            for (size_t i = 0; i < count; ++i) {
+                if (renumbered[docs[i]] != kRemoved) {
+                    kept.Append(renumbered[docs[i]], frequencies[i]);
+                }
+            }
+        }
+        if (kept.GetDocumentFrequency() != 0) {
+            copy.postings_.emplace(term, std::move(kept));
+        }
+    }
+    return copy;
+}
+
+void SearchSegment::Append(SearchSegment&& other) {
+    if (documents_.empty()) {
+        *this = std::move(other);
+        return;
+    }
+
+    const auto doc_offset = static_cast<uint32_t>(documents_.size());
+    std::vector<uint32_t> category_map;
+    for (const auto& category : other.categories_) {
+        category_map.push_back(Intern(category_ids_, categories_, category));
+    }
+    std::vector<uint32_t> source_map;
+    for (const auto& source : other.sources_) {
+        source_map.push_back(Intern(source_ids_, sources_, source));
+    }
+
+    documents_.reserve(documents_.size() + other.documents_.size());
+    for (auto document : other.documents_) {
+        document.category = category_map[document.category];
+        document.source = source_map[document.source];
+        documents_.push_back(document);
+    }
+    total_length_ += other.total_length_;
+
+    for (auto& [term, list] : other.postings_) {
+        postings_[term].Concat(list, doc_offset);
+    }
+    other = SearchSegment();
+}
+
+SearchIndex::SearchIndex(SearchRankingConfig config) : config_(config) {
+}
+
+void SearchIndex::Add(const std::vector<NewsItem>& items) {
+    std::lock_guard<engine::Mutex> lock(pending_mutex_);
+    pending_.insert(pending_.end(), items.begin(), items.end());
+}
+
+void SearchIndex::Flush() {
+    std::lock_guard<engine::Mutex> writer_lock(writer_mutex_);
+    std::vector<NewsItem> items;
+    {
+        std::lock_guard<engine::Mutex> lock(pending_mutex_);
+        items.swap(pending_);
+    }
+    if (items.empty()) {
+        return;
+    }
+
+    // Tokenized before the exclusive lock, which then only covers the posting appends
+    std::vector<SearchSegment::DocumentTerms> terms;
+    terms.reserve(items.size());
+    for (const auto& item : items) {
+        terms.push_back(SearchSegment::CountTerms(item));
+    }
+    std::unique_lock<engine::SharedMutex> lock(mutex_);
+    for (size_t i = 0; i < items.size(); ++i) {
+        segment_.Add(items[i], terms[i]);
+    }
+}
+
+void SearchIndex::Reset(SearchSegment segment, const std::vector<NewsItem>& recent) {
+    std::lock_guard<engine::Mutex> writer_lock(writer_mutex_);
+    std::vector<NewsItem> added = recent;
+    {
+        std::lock_guard<engine::Mutex> lock(pending_mutex_);
+        added.insert(added.end(), pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+
+    // A slice read before rows were archived may still contain them
+    const int64_t removed_before = removed_before_us_;
+    const bool has_removed = std::any_of(
+        segment.documents_.begin(), segment.documents_.end(),
+        [removed_before](const SearchSegment::Document& document) { return document.created_at_us < removed_before; });
+    if (has_removed) {
+        segment = segment.CopyCreatedSince(removed_before);
+    }
+
+    if (!added.empty()) {
+        // The segment is ordered by created_at, so only its tail can overlap `added`
+        int64_t oldest_added = added.front().created_at_us;
+        for (const auto& item : added) {
+            oldest_added = std::min(oldest_added, item.created_at_us);
+        }
+        std::unordered_set<int> indexed;
+        for (auto it = segment.documents_.rbegin();
+             it != segment.documents_.rend() && it->created_at_us >= oldest_added; ++it) {
+            indexed.insert(it->news_id);
+        }
+        for (const auto& item : added) {
+            if (indexed.insert(item.id).second) {
+                segment.Add(item);
+            }
+        }
+    }
+
+    std::unique_lock<engine::SharedMutex> lock(mutex_);
+    segment_ = std::move(segment);
+}
+
+void SearchIndex::RemoveCreatedBefore(int64_t cutoff_us) {
+    std::lock_guard<engine::Mutex> writer_lock(writer_mutex_);
+    if (cutoff_us <= removed_before_us_) {
+        return;
+    }
+    removed_before_us_ = cutoff_us;
+
+    // Only writers change segment_, so the writer lock is enough to read it
+    const bool has_removed = std::any_of(
+        segment_.documents_.begin(), segment_.documents_.end(),
+        [cutoff_us](const SearchSegment::Document& document) { return document.created_at_us < cutoff_us; });
+    if (!has_removed) {
+        return;
+    }
+    auto compacted = segment_.CopyCreatedSince(cutoff_us);
+    std::unique_lock<engine::SharedMutex> lock(mutex_);
+    segment_ = std::move(compacted);
+}
+
+SearchResult SearchIndex::Search(const SearchQuery& query) const {
+    auto terms = Tokenize(query.text);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.empty() || query.limit <= 0) {
+        return {};
+    }
+
+    const int64_t removed_before = removed_before_us_;
+    std::shared_lock<engine::SharedMutex> lock(mutex_);
+    const auto& segment = segment_;
+
+    std::vector<const PostingList*> lists;
+    for (const auto& term : terms) {
+        const auto it = segment.postings_.find(term);
+        if (it == segment.postings_.end()) {
+            return {};  // AND semantics: a term without postings matches nothing
+        }
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const PostingList* lhs, const PostingList* rhs) {
+        return lhs->GetDocumentFrequency() < rhs->GetDocumentFrequency();
+    });
+
+    std::optional<uint32_t> category;
+    if (!query.category.empty()) {
+        const auto it = segment.category_ids_.find(query.category);
+        if (it == segment.category_ids_.end()) {
+            return {};
+        }
+        category = it->second;
+    }
+    std::optional<uint32_t> source;
+    if (!query.source.empty()) {
+        const auto it = segment.source_ids_.find(query.source);
+        if (it == segment.source_ids_.end()) {
+            return {};
+        }
+        source = it->second;
+    }
+
+    const double document_count = static_cast<double>(segment.documents_.size());
+    const double average_length = std::max(1.0, static_cast<double>(segment.total_length_) / document_count);
+    auto term_score = [&](double idf, uint32_t doc, double tf) {
+        const double length = segment.documents_[doc].length;
+        return idf * tf * (config_.k1 + 1) / (tf + config_.k1 * (1 - config_.b + config_.b * length / average_length));
+    };
+    auto idf = [document_count](const PostingList& list) {
+        const double df = static_cast<double>(list.GetDocumentFrequency());
+        return std::log(1.0 + (document_count - df + 0.5) / (df + 0.5));
+    };
+
+    uint32_t docs[PostingList::kBlockSize];
+    uint32_t frequencies[PostingList::kBlockSize];
+    uint32_t candidate_positions[PostingList::kBlockSize];
+    uint32_t block_positions[PostingList::kBlockSize];
+
+    // Candidates start as the filtered postings of the rarest term...
+    std::vector<uint32_t> candidates;
+    std::vector<double> scores;
+    candidates.reserve(lists.front()->GetDocumentFrequency());
+    scores.reserve(lists.front()->GetDocumentFrequency());
+    const double rarest_idf = idf(*lists.front());
+    for (size_t block = 0; block < lists.front()->GetBlocks().size(); ++block) {
+        const size_t count = lists.front()->DecodeBlock(block, docs, frequencies);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& document = segment.documents_[docs[i]];
+            if ((!category || document.category == *category) && (!source || document.source == *source) &&
+                document.created_at_us >= removed_before) {
+                candidates.push_back(docs[i]);
+                scores.push_back(term_score(rarest_idf, docs[i], frequencies[i]));
+            }
+        }
+    }
+
+    // ...and are intersected with the other terms, decoding only the blocks
+    // whose range contains a candidate and accumulating BM25 on the way
+    std::vector<uint32_t> next;
+    std::vector<double> next_scores;
+    for (size_t t = 1; t < lists.size() && !candidates.empty(); ++t) {
+        const auto& blocks = lists[t]->GetBlocks();
+        const double term_idf = idf(*lists[t]);
+        next.clear();
+        next_scores.clear();
+        size_t candidate = 0;
+        size_t block = SeekBlock(blocks, 0, candidates.front());
+        while (block < blocks.size() && candidate < candidates.size()) {
+            if (blocks[block].first_doc > candidates.back()) {
+                break;
+            }
+            const size_t range_end =
+                std::upper_bound(candidates.begin() + candidate, candidates.end(), blocks[block].last_doc) -
+                candidates.begin();
+            if (range_end > candidate) {
+                const size_t count = lists[t]->DecodeBlock(block, docs, frequencies);
+                // A block holds at most kBlockSize documents, so at most that many match
+                const size_t matches = IntersectSorted(candidates.data() + candidate, range_end - candidate, docs,
+                                                       count, candidate_positions, block_positions);
+                for (size_t m = 0; m < matches; ++m) {
+                    const uint32_t doc = docs[block_positions[m]];
+                    next.push_back(doc);
+                    next_scores.push_back(scores[candidate + candidate_positions[m]] +
+                                          term_score(term_idf, doc, frequencies[block_positions[m]]));
+                }
+                candidate = range_end;
+            }
+            if (candidate < candidates.size()) {
+                block = SeekBlock(blocks, block + 1, candidates[candidate]);
+            }
+        }
+        candidates.swap(next);
+        scores.swap(next_scores);
+    }
+
+    SearchResult result;
+    result.total_matches = candidates.size();
+    if (candidates.empty()) {
+        return result;
+    }
+
+    // Recency boost, looked up per hour of age instead of an exp2 per candidate;
+    // past kRecencyHalfLives half-lives it is negligible
+    const int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const double half_life_hours = std::max<double>(1, config_.recency_half_life.count());
+    std::vector<double> boost(static_cast<size_t>(half_life_hours * kRecencyHalfLives) + 1);
+    for (size_t hours = 0; hours < boost.size(); ++hours) {
+        boost[hours] = 1 + config_.recency_weight * std::exp2(-static_cast<double>(hours) / half_life_hours);
+    }
+    boost.back() = 1;
+
+    // Top offset + limit in a min-heap, best first, newer first on ties
+    const auto offset = static_cast<size_t>(std::max(0, query.offset));
+    const size_t keep = offset + query.limit;
+    using Ranked = std::pair<double, uint32_t>;  // score, candidate index
+    auto better = [&candidates](const Ranked& lhs, const Ranked& rhs) {
+        if (lhs.first != rhs.first) {
+            return lhs.first > rhs.first;
+        }
+        return candidates[lhs.second] > candidates[rhs.second];
+    };
+    std::vector<Ranked> top;
+    top.reserve(keep + 1);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const auto age_hours = static_cast<uint64_t>(
+            std::max<int64_t>(0, now_us - segment.documents_[candidates[i]].created_at_us) / kMicrosecondsPerHour);
+        const Ranked ranked{scores[i] * boost[std::min<uint64_t>(age_hours, boost.size() - 1)],
+                            static_cast<uint32_t>(i)};
+        if (top.size() < keep) {
+            top.push_back(ranked);
+            std::push_heap(top.begin(), top.end(), better);
+        } else if (better(ranked, top.front())) {
+            std::pop_heap(top.begin(), top.end(), better);
+            top.back() = ranked;
+            std::push_heap(top.begin(), top.end(), better);
+        }
+    }
+    std::sort(top.begin(), top.end(), better);
+
+    for (size_t i = offset; i < top.size(); ++i) {
+        const auto& document = segment.documents_[candidates[top[i].second]];
+        result.hits.push_back(SearchHit{document.news_id, document.created_at_us, top[i].first});
+    }
+    return result;
+}
+
+size_t SearchIndex::GetDocumentCount() const {
+    std::shared_lock<engine::SharedMutex> lock(mutex_);
+    return segment_.documents_.size();
+}
+
+size_t SearchIndex::GetTermCount() const {
+    std::shared_lock<engine::SharedMutex> lock(mutex_);
+    return segment_.postings_.size();
+}
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/shared_mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// Lower-cased terms of `text`: ASCII and Cyrillic letters are folded, HTML tags
+// and punctuation separate terms
+std::vector<std::string> Tokenize(std::string_view text);
+
+struct SearchQuery {
+    std::string text;
+    std::string category;  // empty = any category
+    std::string source;    // empty = any source
+    int limit = 10;
+    int offset = 0;
+};
+
+struct SearchHit {
+    int news_id = 0;
+    int64_t created_at_us = 0;
+    double score = 0;
+};
+
+struct SearchResult {
+    std::vector<SearchHit> hits;  // best first
+    size_t total_matches = 0;
+};
+
+struct SearchRankingConfig {
+    double k1 = 1.2;
+    double b = 0.75;
+    // Multiplier of BM25 is 1 + recency_weight for a brand-new story and halves
+    // every recency_half_life
+    double recency_weight = 0.5;
+    std::chrono::hours recency_half_life{72};
+};
+
+// Postings of one term: ascending document numbers with term frequencies,
+// delta + varint encoded in blocks of up to kBlockSize documents. Each block
+// records its first and last document so lookups skip blocks without decoding.
+class PostingList {
+public:
+    static constexpr size_t kBlockSize = 128;
+
+    struct Block {
+        uint32_t first_doc;
+        uint32_t last_doc;
+        uint32_t offset;  // into data_
+        uint32_t count;
+    };
+
+    // `doc` must be greater than every document already in the list
+    void Append(uint32_t doc, uint32_t term_frequency);
+    // Appends `other` with its document numbers shifted by `doc_offset`
+    void Concat(const PostingList& other, uint32_t doc_offset);
+
+    size_t GetDocumentFrequency() const { return document_frequency_; }
+    const std::vector<Block>& GetBlocks() const { return blocks_; }
+    // Returns the number of documents written to `docs` / `term_frequencies`
+    size_t DecodeBlock(size_t block, uint32_t* docs, uint32_t* term_frequencies) const;
+
+private:
+    std::vector<uint8_t> data_;
+    std::vector<Block> blocks_;
+    size_t document_frequency_ = 0;
+};
+
+// Intersection of two ascending arrays without duplicates, SIMD-accelerated
+// where available. Writes the positions of each common element in `a` and `b`
+// in ascending order and returns their number.
+size_t IntersectSorted(const uint32_t* a, size_t a_size, const uint32_t* b, size_t b_size, uint32_t* a_positions,
+                       uint32_t* b_positions);
+
+// Not thread-safe: built by one thread, then moved into a SearchIndex
+class SearchSegment {
+public:
+    void Add(const NewsItem& item);
+    // Appends the documents of `other` after the documents of this segment
+    void Append(SearchSegment&& other);
+
+    size_t GetDocumentCount() const { return documents_.size(); }
+
+private:
+    friend class SearchIndex;
+
+    struct Document {
+        int news_id;
+        int64_t created_at_us;
+        uint32_t length;
+        uint32_t category;
+        uint32_t source;
+    };
+
+    // Weighted term frequencies and length of one document
+    struct DocumentTerms {
+        std::unordered_map<std::string, uint32_t> frequencies;
+        uint32_t length = 0;
+    };
+
+    static DocumentTerms CountTerms(const NewsItem& item);
+    void Add(const NewsItem& item, const DocumentTerms& terms);
+    // Copy without the documents created before `cutoff_us`
+    SearchSegment CopyCreatedSince(int64_t cutoff_us) const;
+
+    uint32_t Intern(std::unordered_map<std::string, uint32_t>& ids, std::vector<std::string>& names,
+                    const std::string& value);
+
+    std::vector<Document> documents_;
+    std::unordered_map<std::string, PostingList> postings_;
+    uint64_t total_length_ = 0;
+    std::unordered_map<std::string, uint32_t> category_ids_;
+    std::vector<std::string> categories_;
+    std::unordered_map<std::string, uint32_t> source_ids_;
+    std::vector<std::string> sources_;
+};
+
+// In-memory full-text index of news title and content. AND semantics over the
+// query terms, BM25 ranking with a recency boost, category/source filters.
+//
+// Searches share `mutex_`; writers are serialized by `writer_mutex_` and do
+// their work (tokenizing, compaction) before taking `mutex_` exclusively, so
+// readers only wait for the final swap or posting appends.
+class SearchIndex {
+public:
+    explicit SearchIndex(SearchRankingConfig config);
+
+    // Queues inserted items until the next Flush; items must carry their full content
+    void Add(const std::vector<NewsItem>& items);
+    // Makes the queued items searchable, all under one exclusive lock
+    void Flush();
+    // Replaces the contents with `segment`, then re-adds `recent` and queued
+    // items the segment does not contain (inserted while it was being built)
+    void Reset(SearchSegment segment, const std::vector<NewsItem>& recent);
+    // Drops the documents created before `cutoff_us`, i.e. rows archived or
+    // expired by retention. They stop matching at once and are compacted away
+    // before this returns.
+    void RemoveCreatedBefore(int64_t cutoff_us);
+
+    SearchResult Search(const SearchQuery& query) const;
+
+    size_t GetDocumentCount() const;
+    size_t GetTermCount() const;
+
+private:
+    const SearchRankingConfig config_;
+    engine::Mutex writer_mutex_;
+    mutable engine::SharedMutex mutex_;
+    SearchSegment segment_;
+    std::atomic<int64_t> removed_before_us_{std::numeric_limits<int64_t>::min()};
+    engine::Mutex pending_mutex_;
+    std::vector<NewsItem> pending_;
+};
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,78 @@
+#include "snippet.hpp"
+#include <algorithm>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr std::string_view kEllipsis = "\xE2\x80\xA6";
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+bool IsContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+}  // namespace
+
+std::string MakeSnippet(std::string_view content, size_t max_chars) {
+    std::string snippet;
+    snippet.reserve(std::min(content.size(), max_chars * 4));
+    
+    size_t chars = 0;
+    size_t last_space = std::string::npos;
+    bool pending_space = false;
+    bool truncated = false;
+    
+    for (size_t i = 0; i < content.size(); ++i) {
+        const char c = content[i];
+        if (IsSpace(c)) {
+            pending_space = !snippet.empty();
+            continue;
+        }
+        
+        const bool starts_char = !IsContinuationByte(c);
+        if (starts_char && chars + (pending_space ? 1 : 0) >= max_chars) {
+            truncated = true;
+            if (pending_space) {
+                // The cut falls between words: keep them all
+                last_space = snippet.size();
+            }
+            break;
+        }
+        if (pending_space) {
+            last_space = snippet.size();
+            snippet.push_back(' ');
+            ++chars;
+            pending_space = false;
+        }
+        snippet.push_back(c);
+        if (starts_char) {
+            ++chars;
+        }
+    }
+    
+    if (truncated) {
+        // Prefer ending on a word unless that drops most of the text,
+        // otherwise drop the last character to make room for the ellipsis
+        if (last_space != std::string::npos && last_space >= snippet.size() / 2) {
+            snippet.resize(last_space);
+        } else {
+            while (!snippet.empty() && IsContinuationByte(snippet.back())) {
+                snippet.pop_back();
+            }
+            if (!snippet.empty()) {
+                snippet.pop_back();
+            }
+        }
+        while (!snippet.empty() && snippet.back() == ' ') {
+            snippet.pop_back();
+        }
+        snippet += kEllipsis;
+    }
+    return snippet;
+}
+
+}  // namespace news_aggregator::storage
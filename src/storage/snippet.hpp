@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace news_aggregator::storage {
+
+// Length limit of news.snippet, in characters
+constexpr size_t kSnippetMaxChars = 280;
+
+// Listing preview of an article body: whitespace collapsed, cut at a word
+// boundary and suffixed with "…" when longer than `max_chars` characters.
+// Never splits a UTF-8 sequence.
+std::string MakeSnippet(std::string_view content, size_t max_chars = kSnippetMaxChars);
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,1130 @@
+#include "storage_service.hpp"
+
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include "migrations.hpp"
+#include "snippet.hpp"
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr size_t kContentCacheWays = 16;
+constexpr size_t kMaxUnsavedStatsRows = 100000;
+// Rows checkpointed this long before a reload are read again by the next one,
+// for upserts that were still committing while the previous reload ran
+constexpr std::chrono::seconds kStatsReloadOverlap{60};
+// How long a failed hot set check waits for in-flight inserts before the next one
+constexpr std::chrono::milliseconds kHotSetRecheckDelay{20};
+
+// UTC timestamp literal with microseconds, as accepted by TIMESTAMPTZ input
+std::string FormatTimestampUs(int64_t timestamp_us) {
+    const std::time_t seconds = timestamp_us / 1000000;
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%06d+00", tm.tm_year + 1900, tm.tm_mon + 1,
+                  tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(timestamp_us % 1000000));
+    return buffer;
+}
+
+}  // namespace
+
+StorageService::StorageService(const components::ComponentConfig& config,
+                               const components::ComponentContext& component_context)
+    : LoggableComponentBase(config, component_context),
+      connection_string_(config["connection_string"].As<std::string>()),
+      fs_task_processor_(component_context.GetTaskProcessor(
+          config["fs-task-processor"].As<std::string>("fs-task-processor"))),
+      content_cache_(kContentCacheWays, std::max(config["content_cache_size"].As<size_t>(2000), kContentCacheWays)) {
+    
+    const auto replicas = config["replicas"].As<std::vector<std::string>>(std::vector<std::string>{});
+    if (!replicas.empty()) {
+        replica_set_ = std::make_unique<ReplicaSet>(
+            connection_string_, replicas, std::chrono::milliseconds(config["replica_max_lag_ms"].As<int64_t>(5000)));
+        replica_check_interval_ =
+            config["replica_check_interval_seconds"].As<std::chrono::seconds>(replica_check_interval_);
+        replica_set_->CheckReplicas();
+    }
+    
+    auto client = CreateClient();
+    if (!ApplyMigrations(*client)) {
+        throw std::runtime_error("Failed to apply database migrations");
+    }
+    
+    const auto partitioning_config = config["partitioning"];
+    partitioning_.unit = partitioning_config["unit"].As<std::string>(partitioning_.unit);
+    partitioning_.premake_periods = partitioning_config["premake_periods"].As<int>(partitioning_.premake_periods);
+    partitioning_.retention_days = partitioning_config["retention_days"].As<int>(partitioning_.retention_days);
+    partitioning_.drop_expired = partitioning_config["retention_action"].As<std::string>("detach") == "drop";
+    partition_maintenance_interval_ =
+        partitioning_config["maintenance_interval_seconds"].As<std::chrono::seconds>(partition_maintenance_interval_);
+    const auto archive_config = config["archive"];
+    if (archive_config["enabled"].As<bool>(false)) {
+        archive_ = std::make_unique<ArchiveStore>(archive_config["directory"].As<std::string>());
+        archive_older_than_days_ = archive_config["older_than_days"].As<int>(archive_older_than_days_);
+        archive_->Refresh();
+        if (partitioning_.retention_days > 0 && partitioning_.retention_days <= archive_older_than_days_) {
+            LOG_WARNING() << "partitioning.retention_days expires partitions before they are archived";
+        }
+    }
+    // Today's partition has to exist before the first insert
+    if (!MaintainPartitions(*client, partitioning_)) {
+        LOG_ERROR() << "Initial partition maintenance failed, new rows go to news_default";
+    }
+    
+    const auto write_behind_config = config["write_behind"];
+    if (write_behind_config["enabled"].As<bool>(false)) {
+        WriteBehindConfig queue_config;
+        queue_config.max_queue_size = write_behind_config["max_queue_size"].As<size_t>(queue_config.max_queue_size);
+        queue_config.batch_size = write_behind_config["batch_size"].As<size_t>(queue_config.batch_size);
+        queue_config.flush_interval = std::chrono::milliseconds(
+            write_behind_config["flush_interval_ms"].As<int>(queue_config.flush_interval.count()));
+        queue_config.ack_mode = write_behind_config["ack"].As<std::string>("commit") == "enqueue"
+                                    ? AckMode::kAfterEnqueue
+                                    : AckMode::kAfterCommit;
+        
+        write_behind_ = std::make_unique<WriteBehindQueue>(
+            queue_config, fs_task_processor_,
+            [this](const std::vector<NewsItem>& items) { return FlushWriteBehind(items); });
+    }
+    
+    const auto hot_set_config = config["hot_set"];
+    if (hot_set_config["enabled"].As<bool>(true)) {
+        hot_set_ = std::make_unique<HotSet>(hot_set_config["capacity"].As<size_t>(5000));
+        hot_set_load_parallelism_ = std::max<size_t>(1, hot_set_config["load_parallelism"].As<size_t>(4));
+        hot_set_refresh_interval_ = hot_set_config["refresh_interval_seconds"].As<std::chrono::seconds>(60);
+        hot_set_verify_interval_ = std::chrono::milliseconds(
+            hot_set_config["verify_interval_ms"].As<int>(hot_set_verify_interval_.count()));
+    }
+    
+    if (config["ingest_stats"]["enabled"].As<bool>(true)) {
+        ingest_stats_ = std::make_unique<IngestStats>();
+        const auto loaded_at = std::chrono::steady_clock::now();
+        if (auto rows = LoadIngestStats(*client)) {
+            ingest_stats_->Replace(*rows);
+            ingest_stats_loaded_at_ = loaded_at;
+        } else {
+            LOG_ERROR() << "Failed to load checkpointed ingest stats, counting from zero";
+        }
+    }
+    
+    const auto change_events_config = config["change_events"];
+    if (change_events_config["enabled"].As<bool>(false)) {
+        change_publisher_ = std::make_unique<ChangePublisher>(
+            change_events_config["redis_host"].As<std::string>("localhost"),
+            change_events_config["redis_port"].As<int>(6379),
+            change_events_config["channel"].As<std::string>("news:changes"));
+        change_events_flush_interval_ = std::chrono::milliseconds(
+            change_events_config["flush_interval_ms"].As<int>(change_events_flush_interval_.count()));
+    }
+    
+    const auto trending_config = config["trending"];
+    if (trending_config["enabled"].As<bool>(true)) {
+        TrendingConfig tracker_config;
+        tracker_config.slice = trending_config["slice_seconds"].As<std::chrono::seconds>(tracker_config.slice);
+        tracker_config.window_slices = trending_config["window_slices"].As<size_t>(tracker_config.window_slices);
+        tracker_config.baseline_slices = trending_config["baseline_slices"].As<size_t>(tracker_config.baseline_slices);
+        tracker_config.sketch_width = trending_config["sketch_width"].As<size_t>(tracker_config.sketch_width);
+        tracker_config.sketch_depth = trending_config["sketch_depth"].As<size_t>(tracker_config.sketch_depth);
+        tracker_config.top_k = trending_config["top_k"].As<size_t>(tracker_config.top_k);
+        tracker_config.min_count = trending_config["min_count"].As<uint64_t>(tracker_config.min_count);
+        trending_ = std::make_unique<TrendingTracker>(tracker_config);
+        trending_replay_before_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    const auto search_config = config["search"];
+    if (search_config["enabled"].As<bool>(true)) {
+        SearchRankingConfig ranking;
+        ranking.recency_weight = search_config["recency_weight"].As<double>(ranking.recency_weight);
+        ranking.recency_half_life =
+            std::chrono::hours(search_config["recency_half_life_hours"].As<int>(ranking.recency_half_life.count()));
+        search_index_ = std::make_unique<SearchIndex>(ranking);
+        search_rebuild_parallelism_ = std::max<size_t>(1, search_config["rebuild_parallelism"].As<size_t>(4));
+        search_flush_interval_ = std::chrono::milliseconds(
+            std::max<int64_t>(1, search_config["flush_interval_ms"].As<int64_t>(search_flush_interval_.count())));
+    }
+    
+    statistics_holder_ = component_context.FindComponent<components::StatisticsStorage>()
+                             .GetStorage()
+                             .RegisterWriter("news-storage", [this](utils::statistics::Writer& writer) {
+                                 writer["primary_reads"] = primary_reads_.load();
+                                 if (replica_set_) {
+                                     const auto replica_stats = replica_set_->GetStats();
+                                     for (size_t i = 0; i < replica_stats.size(); ++i) {
+                                         auto replica_writer = writer["replicas"][std::to_string(i)];
+                                         replica_writer["healthy"] = replica_stats[i].healthy ? 1 : 0;
+                                         replica_writer["lag_ms"] = replica_stats[i].lag_ms;
+                                         replica_writer["outstanding"] = replica_stats[i].outstanding;
+                                         replica_writer["requests"] = replica_stats[i].requests;
+                                     }
+                                 }
+                                 if (hot_set_) {
+                                     auto hot_set_writer = writer["hot-set"];
+                                     hot_set_writer["size"] = hot_set_->GetSize();
+                                     hot_set_writer["capacity"] = hot_set_->GetCapacity();
+                                 }
+                                 if (archive_) {
+                                     auto archive_writer = writer["archive"];
+                                     archive_writer["segments"] = archive_->GetSegmentCount();
+                                     archive_writer["rows"] = archive_->GetRowCount();
+                                 }
+                                 if (change_publisher_) {
+                                     const auto event_stats = change_publisher_->GetStats();
+                                     auto events_writer = writer["change-events"];
+                                     events_writer["published"] = event_stats.published;
+                                     events_writer["failed"] = event_stats.failed;
+                                     events_writer["pending_rows"] = event_stats.pending_rows;
+                                 }
+                                 if (search_index_) {
+                                     auto search_writer = writer["search"];
+                                     search_writer["ready"] = search_ready_.load() ? 1 : 0;
+                                     search_writer["documents"] = search_index_->GetDocumentCount();
+                                     search_writer["terms"] = search_index_->GetTermCount();
+                                 }
+                                 if (!write_behind_) {
+                                     return;
+                                 }
+                                 const auto stats = write_behind_->GetStats();
+                                 auto queue_writer = writer["write-behind"];
+                                 queue_writer["queue_depth"] = stats.queue_depth;
+                                 queue_writer["max_queue_size"] = write_behind_->GetConfig().max_queue_size;
+                                 queue_writer["enqueued"] = stats.enqueued;
+                                 queue_writer["rejected"] = stats.rejected;
+                                 queue_writer["committed"] = stats.committed;
+                                 queue_writer["failed"] = stats.failed;
+                                 queue_writer["batches"] = stats.batches;
+                                 queue_writer["last_batch_size"] = stats.last_batch_size;
+                             });
+    
+    LOG_INFO() << "StorageService initialized with " << replicas.size() << " read replicas, write-behind "
+               << (write_behind_ ? "enabled" : "disabled") << ", hot set "
+               << (hot_set_ ? "enabled" : "disabled") << ", search " << (search_index_ ? "enabled" : "disabled");
+}
+
+StorageService::~StorageService() {
+    statistics_holder_.Unregister();
+}
+
+void StorageService::OnAllComponentsLoaded() {
+    if (hot_set_) {
+        // A failed load is not fatal: requests fall back to PostgreSQL until the next refresh
+        try {
+            LoadHotSet();
+            hot_set_->Verify(*CreateClient());
+        } catch (const std::exception& ex) {
+            LOG_ERROR() << "Failed to load the hot set: " << ex.what();
+        }
+        StartHotSetRefreshLoop();
+    }
+    if (write_behind_) {
+        write_behind_->Start();
+    }
+    if (search_index_) {
+        // Searches answer 503 until the build finishes; startup does not wait for it
+        search_rebuild_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+            try {
+                RebuildSearchIndex();
+            } catch (const std::exception& ex) {
+                LOG_ERROR() << "Failed to build the search index: " << ex.what();
+                std::lock_guard<engine::Mutex> lock(search_pending_mutex_);
+                search_pending_.reset();
+            }
+        });
+        StartSearchFlushLoop();
+    }
+    if (ingest_stats_) {
+        StartIngestStatsLoop();
+    }
+    if (change_publisher_) {
+        StartChangeEventsLoop();
+    }
+    if (trending_) {
+        // Replays the titles of the window and baseline so trends survive a
+        // restart. Rows created from the cut-off on are recorded live instead.
+        trending_warmup_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+            try {
+                const auto to_us = trending_replay_before_us_;
+                const auto from_us = to_us - std::chrono::duration_cast<std::chrono::microseconds>(
+                    trending_->GetSpan()).count();
+                const auto rows = CreateReadClient().client->GetNewsCreatedBetween(from_us, to_us);
+                for (const auto& row : rows) {
+                    trending_->Record(row.title, row.source, std::chrono::system_clock::time_point(
+                        std::chrono::microseconds(row.created_at_us)));
+                }
+                LOG_INFO() << "Trending tracker replayed " << rows.size() << " recent rows";
+            } catch (const std::exception& ex) {
+                LOG_ERROR() << "Failed to replay recent rows into the trending tracker: " << ex.what();
+            }
+        });
+    }
+    StartPartitionMaintenanceLoop();
+    if (replica_set_) {
+        StartReplicaCheckLoop();
+    }
+    // Row rewrites of migrations run in small batches next to live traffic
+    backfill_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        try {
+            if (!RunBackfills(*CreateClient(), should_stop_)) {
+                LOG_ERROR() << "Migration backfills did not finish";
+            }
+        } catch (const std::exception& ex) {
+            LOG_ERROR() << "Migration backfills failed: " << ex.what();
+        }
+    });
+}
+
+void StorageService::OnAllComponentsAreStopping() {
+    LOG_INFO() << "StorageService: flushing write-behind queue";
+    if (write_behind_) {
+        write_behind_->Stop();
+    }
+    should_stop_ = true;
+    if (hot_set_refresh_task_.IsValid()) {
+        hot_set_refresh_task_.Wait();
+    }
+    if (partition_maintenance_task_.IsValid()) {
+        partition_maintenance_task_.Wait();
+    }
+    if (replica_check_task_.IsValid()) {
+        replica_check_task_.Wait();
+    }
+    if (search_rebuild_task_.IsValid()) {
+        search_rebuild_task_.Wait();
+    }
+    if (search_flush_task_.IsValid()) {
+        search_flush_task_.Wait();
+    }
+    if (ingest_stats_task_.IsValid()) {
+        ingest_stats_task_.Wait();
+    }
+    if (trending_warmup_task_.IsValid()) {
+        trending_warmup_task_.Wait();
+    }
+    if (change_events_task_.IsValid()) {
+        change_events_task_.Wait();
+    }
+    if (backfill_task_.IsValid()) {
+        backfill_task_.Wait();
+    }
+}
+
+StorageService::ReadConnection StorageService::CreateReadClient() {
+    ReadConnection connection;
+    if (replica_set_) {
+        connection.lease = replica_set_->Acquire();
+    }
+    if (connection.lease) {
+        connection.client = std::make_unique<PostgresClient>(connection.lease->GetDsn());
+        if (connection.client->Connect()) {
+            return connection;
+        }
+        connection.lease->MarkFailed();
+        connection.lease.reset();
+    }
+    
+    ++primary_reads_;
+    connection.client = CreateClient();
+    return connection;
+}
+
+void StorageService::StartReplicaCheckLoop() {
+    replica_check_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        while (!should_stop_) {
+            for (int i = 0; i < replica_check_interval_.count() && !should_stop_; ++i) {
+                engine::SleepFor(std::chrono::seconds(1));
+            }
+            if (should_stop_) {
+                break;
+            }
+            replica_set_->CheckReplicas();
+        }
+    });
+}
+
+void StorageService::StartChangeEventsLoop() {
+    change_events_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        while (!should_stop_) {
+            engine::SleepFor(change_events_flush_interval_);
+            change_publisher_->Flush();
+        }
+        // Inserts flushed from the write-behind queue on shutdown still get announced
+        change_publisher_->Flush();
+    });
+}
+
+void StorageService::LoadHotSet() {
+    const auto started = std::chrono::steady_clock::now();
+    const auto version = hot_set_->GetVersion();
+    auto connection = CreateReadClient();
+    auto& client = connection.client;
+    
+    const auto newest = client->QueryScalar(
+        "SELECT (EXTRACT(EPOCH FROM MAX(created_at)) * 1000000)::BIGINT FROM news");
+    if (!newest || newest->empty()) {
+        hot_set_->Reset({}, true, version);
+        return;
+    }
+    
+    // Without a row at depth `capacity` the whole table fits in memory
+    const auto boundary = client->GetCursorAtDepth(static_cast<int>(hot_set_->GetCapacity()));
+    int64_t from_us = 0;
+    if (boundary) {
+        from_us = boundary->created_at_us;
+    } else {
+        const auto oldest = client->QueryScalar(
+            "SELECT (EXTRACT(EPOCH FROM MIN(created_at)) * 1000000)::BIGINT FROM news");
+        from_us = oldest ? std::stoll(*oldest) : 0;
+    }
+    const int64_t to_us = std::stoll(*newest) + 1;
+    
+    // Split [from, to) into equal time slices and read them concurrently,
+    // each on its own connection, off the main task processor
+    const auto slices = static_cast<int64_t>(hot_set_load_parallelism_);
+    const int64_t span = to_us - from_us;
+    std::vector<engine::TaskWithResult<std::vector<NewsItem>>> tasks;
+    tasks.reserve(hot_set_load_parallelism_);
+    for (int64_t i = 0; i < slices; ++i) {
+        const int64_t slice_from = from_us + span * i / slices;
+        const int64_t slice_to = from_us + span * (i + 1) / slices;
+        if (slice_from == slice_to) {
+            continue;
+        }
+        tasks.push_back(engine::AsyncNoSpan(fs_task_processor_, [this, slice_from, slice_to] {
+            return CreateReadClient().client->GetNewsCreatedBetween(slice_from, slice_to);
+        }));
+    }
+    
+    std::vector<NewsItem> items;
+    for (auto& task : tasks) {
+        auto slice = task.Get();
+        items.insert(items.end(), std::make_move_iterator(slice.begin()), std::make_move_iterator(slice.end()));
+    }
+    
+    const auto loaded = items.size();
+    hot_set_->Reset(std::move(items), !boundary, version);
+    
+    LOG_INFO() << "Hot set loaded " << loaded << " rows in " << tasks.size() << " slices, "
+               << std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - started).count()
+               << "ms";
+}
+
+void StorageService::StartHotSetRefreshLoop() {
+    hot_set_refresh_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        // Rows written by other instances and the bulk importer only show up in
+        // PostgreSQL: a mismatching check sends reads there and reloads the set
+        std::unique_ptr<PostgresClient> client;
+        auto last_load = std::chrono::steady_clock::now();
+        // A row committed here but not merged yet fails one check; checking
+        // again at once keeps that from costing a reload and a full interval
+        // of PostgreSQL reads
+        const auto verify = [this, &client] {
+            if (hot_set_->Verify(*client)) {
+                return true;
+            }
+            engine::SleepFor(kHotSetRecheckDelay);
+            return hot_set_->Verify(*client);
+        };
+        while (!should_stop_) {
+            try {
+                if (!client || !client->IsConnected()) {
+                    client = CreateClient();
+                }
+                const bool matches = verify();
+                const auto now = std::chrono::steady_clock::now();
+                if (!matches || now - last_load >= hot_set_refresh_interval_) {
+                    if (!matches) {
+                        LOG_INFO() << "Hot set does not match PostgreSQL, reloading";
+                    }
+                    last_load = now;
+                    LoadHotSet();
+                    verify();
+                }
+            } catch (const std::exception& ex) {
+                hot_set_->Invalidate();
+                LOG_ERROR() << "Failed to refresh the hot set: " << ex.what();
+            }
+            engine::SleepFor(hot_set_verify_interval_);
+        }
+    });
+}
+
+void StorageService::StartPartitionMaintenanceLoop() {
+    partition_maintenance_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        while (!should_stop_) {
+            // Wait until next pass or until stop
+            for (int i = 0; i < partition_maintenance_interval_.count() && !should_stop_; ++i) {
+                engine::SleepFor(std::chrono::seconds(1));
+            }
+            if (should_stop_) {
+                break;
+            }
+            
+            // Archive first, so retention never drops a partition that should be archived
+            if (archive_) {
+                try {
+                    if (!ArchiveExpiredPartitions(*CreateClient(), *archive_, archive_older_than_days_)) {
+                        LOG_ERROR() << "Archiving failed";
+                    }
+                    // Picks up segments written by other instances
+                    archive_->Refresh();
+                } catch (const std::exception& ex) {
+                    LOG_ERROR() << "Archiving failed: " << ex.what();
+                }
+            }
+            
+            try {
+                if (!MaintainPartitions(*CreateClient(), partitioning_)) {
+                    LOG_ERROR() << "Partition maintenance failed";
+                }
+            } catch (const std::exception& ex) {
+                LOG_ERROR() << "Partition maintenance failed: " << ex.what();
+            }
+            
+            // Whether this instance or another one archived or expired them,
+            // rows older than the oldest live row are gone from the table
+            if (search_index_) {
+                try {
+                    const auto oldest = CreateReadClient().client->QueryScalar(
+                        "SELECT (EXTRACT(EPOCH FROM MIN(created_at)) * 1000000)::BIGINT FROM news");
+                    if (oldest && !oldest->empty()) {
+                        search_index_->RemoveCreatedBefore(std::stoll(*oldest));
+                    }
+                } catch (const std::exception& ex) {
+                    LOG_ERROR() << "Failed to drop removed rows from the search index: " << ex.what();
+                }
+            }
+        }
+    });
+}
+
+void StorageService::StartSearchFlushLoop() {
+    search_flush_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        while (!should_stop_) {
+            engine::SleepFor(search_flush_interval_);
+            search_index_->Flush();
+        }
+    });
+}
+
+void StorageService::StartIngestStatsLoop() {
+    ingest_stats_task_ = engine::AsyncNoSpan(fs_task_processor_, [this]() {
+        auto minute_of = [](std::chrono::system_clock::time_point time) {
+            return std::chrono::time_point_cast<std::chrono::minutes>(time);
+        };
+        auto current_minute = minute_of(std::chrono::system_clock::now());
+        // Increments whose checkpoint failed are retried with the next one
+        std::vector<StatsBucketRow> unsaved;
+        
+        auto checkpoint = [this, &unsaved](std::chrono::system_clock::time_point bucket_time) {
+            auto rows = ingest_stats_->Rotate(bucket_time);
+            unsaved.insert(unsaved.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+            try {
+                auto client = CreateClient();
+                if (CheckpointIngestStats(*client, unsaved)) {
+                    unsaved.clear();
+                    // Picks up the checkpoints of other instances: the rows any
+                    // of them touched since the previous reload, or everything
+                    // while nothing was loaded yet. On failure the local
+                    // buckets stay and the next reload covers a longer span.
+                    const auto now = std::chrono::steady_clock::now();
+                    if (ingest_stats_loaded_at_) {
+                        const auto touched_within = std::chrono::duration_cast<std::chrono::microseconds>(
+                            now - *ingest_stats_loaded_at_ + kStatsReloadOverlap);
+                        if (auto touched = LoadIngestStats(*client, touched_within)) {
+                            ingest_stats_->Update(*touched);
+                            ingest_stats_loaded_at_ = now;
+                        }
+                    } else if (auto checkpointed = LoadIngestStats(*client)) {
+                        ingest_stats_->Replace(*checkpointed);
+                        ingest_stats_loaded_at_ = now;
+                    }
+                    return;
+                }
+            } catch (const std::exception& ex) {
+                LOG_ERROR() << "Ingest stats checkpoint failed: " << ex.what();
+            }
+            if (unsaved.size() > kMaxUnsavedStatsRows) {
+                LOG_ERROR() << "Dropping " << unsaved.size() << " ingest stats rows that could not be checkpointed";
+                unsaved.clear();
+            }
+        };
+        
+        while (!should_stop_) {
+            engine::SleepFor(std::chrono::seconds(1));
+            const auto minute = minute_of(std::chrono::system_clock::now());
+            if (minute != current_minute) {
+                checkpoint(current_minute);
+                current_minute = minute;
+            }
+        }
+        // Whatever was counted in the last, partial minute
+        checkpoint(current_minute);
+    });
+}
+
+void StorageService::RebuildSearchIndex() {
+    const auto started = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<engine::Mutex> lock(search_pending_mutex_);
+        search_pending_.emplace();
+    }
+    
+    auto client = CreateReadClient().client;
+    const auto oldest = client->QueryScalar(
+        "SELECT (EXTRACT(EPOCH FROM MIN(created_at)) * 1000000)::BIGINT FROM news");
+    const auto newest = client->QueryScalar(
+        "SELECT (EXTRACT(EPOCH FROM MAX(created_at)) * 1000000)::BIGINT FROM news");
+    client.reset();
+    
+    // Each slice is streamed into its own segment on its own connection; the
+    // segments are concatenated oldest first so document order follows created_at
+    std::vector<engine::TaskWithResult<SearchSegment>> tasks;
+    if (oldest && !oldest->empty() && newest && !newest->empty()) {
+        const int64_t from_us = std::stoll(*oldest);
+        const int64_t to_us = std::stoll(*newest) + 1;
+        const auto slices = static_cast<int64_t>(search_rebuild_parallelism_);
+        for (int64_t i = 0; i < slices; ++i) {
+            const int64_t slice_from = from_us + (to_us - from_us) * i / slices;
+            const int64_t slice_to = from_us + (to_us - from_us) * (i + 1) / slices;
+            if (slice_from == slice_to) {
+                continue;
+            }
+            tasks.push_back(engine::AsyncNoSpan(fs_task_processor_, [this, slice_from, slice_to] {
+                SearchSegment segment;
+                const auto status = CreateReadClient().client->StreamNewsCreatedBetween(
+                    FormatTimestampUs(slice_from), FormatTimestampUs(slice_to), [this, &segment](NewsItem&& item) {
+                        segment.Add(item);
+                        return !should_stop_.load();
+                    });
+                if (status != PostgresClient::StreamStatus::kDone) {
+                    throw std::runtime_error("search index slice read failed");
+                }
+                return segment;
+            }));
+        }
+    }
+    
+    SearchSegment segment;
+    for (auto& task : tasks) {
+        segment.Append(task.Get());
+    }
+    const auto documents = segment.GetDocumentCount();
+    
+    std::vector<NewsItem> pending;
+    {
+        std::lock_guard<engine::Mutex> lock(search_pending_mutex_);
+        pending = std::move(*search_pending_);
+        search_pending_.reset();
+        search_index_->Reset(std::move(segment), pending);
+    }
+    search_ready_ = true;
+    
+    LOG_INFO() << "Search index built from " << documents << " rows in " << tasks.size() << " slices, "
+               << pending.size() << " inserted meanwhile, "
+               << std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - started).count()
+               << "ms";
+}
+
+void StorageService::OnNewsInserted(const std::vector<NewsItem>& items,
+                                    const std::vector<AddNewsResult>& results) {
+    std::vector<NewsItem> inserted;
+    for (size_t i = 0; i < items.size() && i < results.size(); ++i) {
+        const auto& result = results[i];
+        if (!result.inserted) {
+            continue;
+        }
+        NewsItem item = items[i];
+        item.id = result.id;
+        item.created_at_us = result.created_at_us;
+        item.published_at = result.published_at;
+        if (item.snippet.empty()) {
+            item.snippet = MakeSnippet(item.content);
+        }
+        
+        inserted.push_back(std::move(item));
+    }
+    if (inserted.empty()) {
+        return;
+    }
+    
+    if (ingest_stats_) {
+        for (const auto& item : inserted) {
+            ingest_stats_->Record(item.source, item.category);
+        }
+    }
+    if (trending_) {
+        const auto now = std::chrono::system_clock::now();
+        for (const auto& item : inserted) {
+            // Older rows belong to the warm-up replay
+            if (item.created_at_us >= trending_replay_before_us_) {
+                trending_->Record(item.title, item.source, now);
+            }
+        }
+    }
+    
+    if (search_index_) {
+        std::lock_guard<engine::Mutex> lock(search_pending_mutex_);
+        if (search_pending_) {
+            search_pending_->insert(search_pending_->end(), inserted.begin(), inserted.end());
+        } else {
+            search_index_->Add(inserted);
+        }
+    }
+    
+    // Fresh stories are the ones most likely to be opened next
+    for (auto& item : inserted) {
+        content_cache_.Put(item.id, std::make_shared<const NewsItem>(item));
+        item.content.clear();
+    }
+    if (hot_set_) {
+        hot_set_->Insert(change_publisher_ ? std::vector<NewsItem>(inserted) : std::move(inserted));
+    }
+    // Only now, so a cache reload triggered by the event already finds the rows in the hot set
+    if (change_publisher_) {
+        change_publisher_->Record(inserted);
+    }
+}
+
+std::unique_ptr<PostgresClient> StorageService::CreateClient() const {
+    auto client = std::make_unique<PostgresClient>(connection_string_);
+    if (!client->Connect()) {
+        throw std::runtime_error("Failed to connect to PostgreSQL");
+    }
+    return client;
+}
+
+std::vector<NewsItemPtr> StorageService::GetLatestNews(const NewsQuery& query) {
+    if (hot_set_) {
+        if (auto cached = hot_set_->TryGetLatest(query)) {
+            return std::move(*cached);
+        }
+    }
+    
+    // A replica may not have replayed the rows up to min_id yet
+    auto rows = query.min_id > 0 ? CreateClient()->GetLatestNews(query)
+                                 : CreateReadClient().client->GetLatestNews(query);
+    std::vector<NewsItemPtr> result;
+    result.reserve(rows.size());
+    for (auto& row : rows) {
+        result.push_back(std::make_shared<const NewsItem>(std::move(row)));
+    }
+    return result;
+}
+
+std::vector<NewsItemPtr> StorageService::GetNewsByIds(const std::vector<int>& ids) {
+    std::unordered_map<int, NewsItemPtr> found;
+    std::vector<int> missing;
+    for (const int id : ids) {
+        if (found.count(id)) {
+            continue;
+        }
+        if (auto cached = content_cache_.Get(id)) {
+            found.emplace(id, std::move(*cached));
+        } else {
+            found.emplace(id, nullptr);
+            missing.push_back(id);
+        }
+    }
+    
+    auto load = [this, &found, &missing](PostgresClient& client) {
+        for (auto& row : client.GetNewsByIds(missing)) {
+            auto item = std::make_shared<const NewsItem>(std::move(row));
+            content_cache_.Put(item->id, item);
+            found[item->id] = std::move(item);
+        }
+        missing.erase(std::remove_if(missing.begin(), missing.end(), [&found](int id) { return found[id] != nullptr; }),
+                      missing.end());
+    };
+    
+    if (!missing.empty()) {
+        auto connection = CreateReadClient();
+        load(*connection.client);
+        // A lagging replica may not have a just-inserted row yet
+        if (!missing.empty() && connection.lease) {
+            ++primary_reads_;
+            load(*CreateClient());
+        }
+    }
+    
+    std::vector<NewsItemPtr> result;
+    result.reserve(ids.size());
+    for (const int id : ids) {
+        const auto& item = found[id];
+        if (item) {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+std::vector<NewsItemPtr> StorageService::GetNewsSummariesByIds(const std::vector<int>& ids) {
+    std::unordered_map<int, NewsItemPtr> found;
+    std::vector<int> missing;
+    for (const int id : ids) {
+        if (found.count(id)) {
+            continue;
+        }
+        if (auto cached = content_cache_.Get(id)) {
+            found.emplace(id, std::move(*cached));
+        } else {
+            found.emplace(id, nullptr);
+            missing.push_back(id);
+        }
+    }
+    
+    // Summary rows lack the content, so they are not put into content_cache_
+    auto load = [&found, &missing](PostgresClient& client) {
+        for (auto& row : client.GetNewsSummariesByIds(missing)) {
+            const int id = row.id;
+            found[id] = std::make_shared<const NewsItem>(std::move(row));
+        }
+        missing.erase(std::remove_if(missing.begin(), missing.end(), [&found](int id) { return found[id] != nullptr; }),
+                      missing.end());
+    };
+    
+    if (!missing.empty()) {
+        auto connection = CreateReadClient();
+        load(*connection.client);
+        if (!missing.empty() && connection.lease) {
+            ++primary_reads_;
+            load(*CreateClient());
+        }
+    }
+    
+    std::vector<NewsItemPtr> result;
+    result.reserve(ids.size());
+    for (const int id : ids) {
+        const auto& item = found[id];
+        if (item) {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+PostgresClient::StreamStatus StorageService::ExportNews(const std::string& from, const std::string& to,
+                                                       const std::function<bool(NewsItem&&)>& on_row) {
+    return CreateReadClient().client->StreamNewsCreatedBetween(from, to, on_row);
+}
+
+std::optional<StatsWindowResult> StorageService::GetIngestStats(const StatsWindow& window) const {
+    if (!ingest_stats_) {
+        return std::nullopt;
+    }
+    return ingest_stats_->Query(window, std::chrono::system_clock::now());
+}
+
+std::optional<std::vector<NewsItem>> StorageService::GetArchivedNews(const ArchiveQuery& query) const {
+    if (!archive_) {
+        return std::nullopt;
+    }
+    return archive_->Query(query);
+}
+
+std::optional<int64_t> StorageService::GetArchivedBeforeUs() const {
+    if (!archive_) {
+        return std::nullopt;
+    }
+    return archive_->GetArchivedBeforeUs();
+}
+
+std::optional<std::vector<TrendingTerm>> StorageService::GetTrending(size_t limit) const {
+    if (!trending_) {
+        return std::nullopt;
+    }
+    return trending_->GetTrending(limit, std::chrono::system_clock::now());
+}
+
+std::optional<SearchResult> StorageService::SearchNews(const SearchQuery& query) const {
+    if (!search_index_ || !search_ready_) {
+        return std::nullopt;
+    }
+    return search_index_->Search(query);
+}
+
+AddNewsResult StorageService::AddNews(const NewsItem& item) {
+    auto result = CreateClient()->AddNews(item);
+    OnNewsInserted({item}, {result});
+    return result;
+}
+
+std::vector<AddNewsResult> StorageService::AddNewsBatch(const std::vector<NewsItem>& items) {
+    auto results = CreateClient()->AddNewsBatch(items);
+    OnNewsInserted(items, results);
+    return results;
+}
+
+AckMode StorageService::GetWriteBehindAckMode() const {
+    return write_behind_ ? write_behind_->GetConfig().ack_mode : AckMode::kAfterCommit;
+}
+
+std::optional<std::vector<WriteBehindQueue::Ticket>> StorageService::EnqueueNews(std::vector<NewsItem> items) {
+    if (!write_behind_) {
+        return std::nullopt;
+    }
+    return write_behind_->Enqueue(std::move(items));
+}
+
+std::vector<AddNewsResult> StorageService::FlushWriteBehind(const std::vector<NewsItem>& items) {
+    if (!write_behind_client_ || !write_behind_client_->IsConnected()) {
+        write_behind_client_ = CreateClient();
+    }
+    auto results = write_behind_client_->AddNewsBatch(items);
+    
+    // A group that broke the connection is retried once on a new one; inserts
+    // are idempotent by content key, so rows that did commit become duplicates
+    if (!write_behind_client_->IsConnected()) {
+        LOG_WARNING() << "Write-behind connection lost, retrying a group of " << items.size() << " items";
+        write_behind_client_ = CreateClient();
+        auto retried = write_behind_client_->AddNewsBatch(items);
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].inserted) {
+                retried[i] = results[i];
+            }
+        }
+        results = std::move(retried);
+    }
+    OnNewsInserted(items, results);
+    return results;
+}
+
+yaml_config::Schema StorageService::GetStaticConfigSchema() {
+    return yaml_config::MergeSchemas<components::LoggableComponentBase>(R"(
+type: object
+description: StorageService component config
+additionalProperties: false
+properties:
+    connection_string:
+        type: string
+        description: libpq connection string of the primary, which takes every write
+    replicas:
+        type: array
+        description: libpq connection strings of streaming replicas that serve reads
+        defaultDescription: '[]'
+        items:
+            type: string
+            description: replica connection string
+    replica_max_lag_ms:
+        type: integer
+        description: replicas whose replay lags the primary by more are excluded from reads
+        defaultDescription: 5000
+    replica_check_interval_seconds:
+        type: integer
+        description: how often replica availability and lag are measured
+        defaultDescription: 1
+    content_cache_size:
+        type: integer
+        description: number of full articles cached for /news/{id}
+        defaultDescription: 2000
+    fs-task-processor:
+        type: string
+        description: task processor for blocking PostgreSQL work in the background
+        defaultDescription: fs-task-processor
+    partitioning:
+        type: object
+        description: maintenance of the created_at range partitions of news
+        additionalProperties: false
+        properties:
+            unit:
+                type: string
+                description: time range covered by one partition
+                enum: [day, week, month]
+                defaultDescription: week
+            premake_periods:
+                type: integer
+                description: partitions created ahead of the current one
+                defaultDescription: 4
+            retention_days:
+                type: integer
+                description: partitions that ended longer ago than this are expired, 0 keeps everything
+                defaultDescription: 0
+            retention_action:
+                type: string
+                description: detach expired partitions (keeping them as tables) or drop them
+                enum: [detach, drop]
+                defaultDescription: detach
+            maintenance_interval_seconds:
+                type: integer
+                description: how often partitions are created and expired
+                defaultDescription: 3600
+    archive:
+        type: object
+        description: cold archive of old partitions in compressed columnar segment files that serve /news/archive
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: move old partitions out of PostgreSQL into segment files
+                defaultDescription: false
+            directory:
+                type: string
+                description: directory of the segment files, shared by every instance
+            older_than_days:
+                type: integer
+                description: partitions that ended longer ago than this are archived
+                defaultDescription: 90
+    hot_set:
+        type: object
+        description: in-memory index of the newest rows that serves /news/latest
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: serve latest-news pages from memory when possible
+                defaultDescription: true
+            capacity:
+                type: integer
+                description: number of newest rows kept in memory
+                defaultDescription: 5000
+            load_parallelism:
+                type: integer
+                description: concurrent time slices (and connections) used to load the hot set
+                defaultDescription: 4
+            refresh_interval_seconds:
+                type: integer
+                description: how often the hot set is reloaded from PostgreSQL
+                defaultDescription: 60
+            verify_interval_ms:
+                type: integer
+                description: how often the hot set is checked against PostgreSQL for rows written elsewhere
+                defaultDescription: 1000
+    ingest_stats:
+        type: object
+        description: per-source and per-category ingest counters that serve /news/stats
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: count inserted rows in memory and checkpoint the counts every minute
+                defaultDescription: true
+    trending:
+        type: object
+        description: windowed Count-Min Sketch and heavy hitters over title terms that serve /news/trending
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: track title terms on insert
+                defaultDescription: true
+            slice_seconds:
+                type: integer
+                description: length of one time slice; the sketches rotate slice by slice
+                defaultDescription: 300
+            window_slices:
+                type: integer
+                description: recent slices whose mentions are ranked
+                defaultDescription: 12
+            baseline_slices:
+                type: integer
+                description: slices before the window that give the expected rate
+                defaultDescription: 72
+            sketch_width:
+                type: integer
+                description: counters per Count-Min Sketch row
+                defaultDescription: 4096
+            sketch_depth:
+                type: integer
+                description: Count-Min Sketch rows
+                defaultDescription: 4
+            top_k:
+                type: integer
+                description: heavy hitters tracked per slice
+                defaultDescription: 200
+            min_count:
+                type: integer
+                description: mentions in the window below which a term never trends
+                defaultDescription: 3
+    change_events:
+        type: object
+        description: change events on Redis pub/sub after each committed insert batch, used by gateway caches
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: publish change events
+                defaultDescription: false
+            redis_host:
+                type: string
+                description: Redis host
+                defaultDescription: localhost
+            redis_port:
+                type: integer
+                description: Redis port
+                defaultDescription: 6379
+            channel:
+                type: string
+                description: pub/sub channel
+                defaultDescription: news:changes
+            flush_interval_ms:
+                type: integer
+                description: inserts within one interval are announced by one merged event
+                defaultDescription: 50
+    search:
+        type: object
+        description: in-memory full-text index that serves /news/search
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: build the index at startup and keep it up to date on insert
+                defaultDescription: true
+            rebuild_parallelism:
+                type: integer
+                description: concurrent time slices (and connections) used to build the index
+                defaultDescription: 4
+            flush_interval_ms:
+                type: integer
+                description: inserts are queued and become searchable in one batch per interval
+                defaultDescription: 100
+            recency_weight:
+                type: number
+                description: extra score factor of a brand-new story relative to an old one
+                defaultDescription: 0.5
+            recency_half_life_hours:
+                type: integer
+                description: age at which the recency boost has halved
+                defaultDescription: 72
+    write_behind:
+        type: object
+        description: group-commit write-behind mode for /news/add
+        additionalProperties: false
+        properties:
+            enabled:
+                type: boolean
+                description: queue inserts and commit them in groups
+                defaultDescription: false
+            max_queue_size:
+                type: integer
+                description: queued items above which /news/add answers 503
+                defaultDescription: 10000
+            batch_size:
+                type: integer
+                description: commit a group once this many items are queued
+                defaultDescription: 100
+            flush_interval_ms:
+                type: integer
+                description: commit a group at the latest this long after it started filling
+                defaultDescription: 10
+            ack:
+                type: string
+                description: respond after the group commit (commit) or right after queueing (enqueue)
+                enum: [commit, enqueue]
+                defaultDescription: commit
+)");
+}
+
+}  // namespace news_aggregator::storage
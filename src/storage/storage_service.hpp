@@ -0,0 +1,155 @@
+#pragma once
+
+#include <userver/cache/nway_lru_cache.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/yaml_config/schema.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "archive.hpp"
+#include "change_publisher.hpp"
+#include "hot_set.hpp"
+#include "ingest_stats.hpp"
+#include "partitions.hpp"
+#include "replica_set.hpp"
+#include "search_index.hpp"
+#include "trending.hpp"
+#include "postgres_client.hpp"
+#include "write_behind_queue.hpp"
+
+namespace news_aggregator::storage {
+
+// Owns the database configuration of StorageService and brings the schema up
+// to date on startup. Handlers go through this component instead of building
+// their own connection strings.
+class StorageService final : public components::LoggableComponentBase {
+public:
+    static constexpr std::string_view kName = "storage-service";
+
+    StorageService(const components::ComponentConfig& config,
+                   const components::ComponentContext& component_context);
+
+    ~StorageService() override;
+
+    static yaml_config::Schema GetStaticConfigSchema();
+
+    // Served from the in-memory hot set when it covers the page, else from
+    // PostgreSQL; from the primary rather than a replica when min_id is set
+    std::vector<NewsItemPtr> GetLatestNews(const NewsQuery& query);
+    // Full rows including content, in the order of `ids`; unknown ids are skipped
+    std::vector<NewsItemPtr> GetNewsByIds(const std::vector<int>& ids);
+    // Listing entries (snippet, no content) in the order of `ids`; unknown ids are skipped
+    std::vector<NewsItemPtr> GetNewsSummariesByIds(const std::vector<int>& ids);
+    // Streams full rows created in [from, to), oldest first, from a read replica
+    PostgresClient::StreamStatus ExportNews(const std::string& from, const std::string& to,
+                                            const std::function<bool(NewsItem&&)>& on_row);
+    // Full-text search over title and content; std::nullopt while the index is
+    // disabled or still being built
+    std::optional<SearchResult> SearchNews(const SearchQuery& query) const;
+    // Ingested row counts per source and category; std::nullopt when disabled
+    std::optional<StatsWindowResult> GetIngestStats(const StatsWindow& window) const;
+    // Title terms surging above their baseline rate; std::nullopt when disabled
+    std::optional<std::vector<TrendingTerm>> GetTrending(size_t limit) const;
+    // Rows moved to the cold archive; std::nullopt when archiving is disabled
+    std::optional<std::vector<NewsItem>> GetArchivedNews(const ArchiveQuery& query) const;
+    // See ArchiveStore::GetArchivedBeforeUs; std::nullopt when archiving is disabled
+    std::optional<int64_t> GetArchivedBeforeUs() const;
+    AddNewsResult AddNews(const NewsItem& item);
+    std::vector<AddNewsResult> AddNewsBatch(const std::vector<NewsItem>& items);
+
+    // Write-behind mode: items are queued and committed in groups by a background task
+    bool IsWriteBehindEnabled() const { return write_behind_ != nullptr; }
+    AckMode GetWriteBehindAckMode() const;
+    // Queues all items or none; std::nullopt when the queue is full and the
+    // caller should back off
+    std::optional<std::vector<WriteBehindQueue::Ticket>> EnqueueNews(std::vector<NewsItem> items);
+
+private:
+    void OnAllComponentsLoaded() override;
+    void OnAllComponentsAreStopping() override;
+
+    // Connection to the primary, used for writes and as the read fallback
+    std::unique_ptr<PostgresClient> CreateClient() const;
+    
+    struct ReadConnection {
+        std::optional<ReplicaSet::Lease> lease;  // unset when reading from the primary
+        std::unique_ptr<PostgresClient> client;
+    };
+    // Connection to the least busy healthy replica, or to the primary if there is none
+    ReadConnection CreateReadClient();
+    void StartReplicaCheckLoop();
+
+    // Reloads the newest `capacity` rows, one time slice per connection
+    void LoadHotSet();
+    void StartHotSetRefreshLoop();
+    void StartPartitionMaintenanceLoop();
+    // Rotates the ingest counters every minute and checkpoints them
+    void StartIngestStatsLoop();
+    // Publishes merged change events every flush interval
+    void StartChangeEventsLoop();
+    // Makes queued inserts searchable every flush interval
+    void StartSearchFlushLoop();
+    // Builds the search index from the whole table, one time slice per connection
+    void RebuildSearchIndex();
+    // Commits one write-behind group on the flusher's own connection
+    std::vector<AddNewsResult> FlushWriteBehind(const std::vector<NewsItem>& items);
+    // Write-through of the rows that were actually inserted
+    void OnNewsInserted(const std::vector<NewsItem>& items, const std::vector<AddNewsResult>& results);
+
+    std::string connection_string_;
+    std::unique_ptr<ReplicaSet> replica_set_;
+    std::chrono::seconds replica_check_interval_{1};
+    engine::TaskWithResult<void> replica_check_task_;
+    std::atomic<uint64_t> primary_reads_{0};
+    engine::TaskProcessor& fs_task_processor_;
+    std::unique_ptr<HotSet> hot_set_;
+    // Full articles by id for /news/{id}
+    cache::NWayLRU<int, NewsItemPtr> content_cache_;
+    size_t hot_set_load_parallelism_ = 4;
+    std::chrono::seconds hot_set_refresh_interval_{60};
+    std::chrono::milliseconds hot_set_verify_interval_{1000};
+    engine::TaskWithResult<void> hot_set_refresh_task_;
+    PartitioningConfig partitioning_;
+    std::chrono::seconds partition_maintenance_interval_{3600};
+    engine::TaskWithResult<void> partition_maintenance_task_;
+    std::unique_ptr<ArchiveStore> archive_;
+    int archive_older_than_days_ = 90;
+    std::unique_ptr<IngestStats> ingest_stats_;
+    // Last successful reload of the checkpointed stats; owned by the stats loop
+    std::optional<std::chrono::steady_clock::time_point> ingest_stats_loaded_at_;
+    engine::TaskWithResult<void> ingest_stats_task_;
+    std::unique_ptr<ChangePublisher> change_publisher_;
+    std::chrono::milliseconds change_events_flush_interval_{50};
+    engine::TaskWithResult<void> change_events_task_;
+    std::unique_ptr<TrendingTracker> trending_;
+    // Rows created before it are replayed at startup, later ones recorded on insert
+    int64_t trending_replay_before_us_ = 0;
+    engine::TaskWithResult<void> trending_warmup_task_;
+    std::unique_ptr<SearchIndex> search_index_;
+    size_t search_rebuild_parallelism_ = 4;
+    std::atomic<bool> search_ready_{false};
+    // Rows inserted while the index is being rebuilt, re-applied on top of it
+    engine::Mutex search_pending_mutex_;
+    std::optional<std::vector<NewsItem>> search_pending_;
+    engine::TaskWithResult<void> search_rebuild_task_;
+    std::chrono::milliseconds search_flush_interval_{100};
+    engine::TaskWithResult<void> search_flush_task_;
+    engine::TaskWithResult<void> backfill_task_;
+    std::atomic<bool> should_stop_{false};
+    std::unique_ptr<WriteBehindQueue> write_behind_;
+    // Only used by the write-behind flusher task
+    std::unique_ptr<PostgresClient> write_behind_client_;
+    utils::statistics::Entry statistics_holder_;
+};
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,219 @@
+#include "text_normalizer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace news_aggregator::storage {
+
+namespace {
+
+constexpr char32_t kReplacement = 0xFFFD;
+
+struct NamedEntity {
+    std::string_view name;
+    char32_t code_point;
+};
+
+// Sorted by name for binary search
+constexpr NamedEntity kNamedEntities[] = {
+    {"amp", '&'},      {"apos", '\''},    {"bdquo", 0x201E}, {"bull", 0x2022},  {"cent", 0xA2},
+    {"copy", 0xA9},    {"deg", 0xB0},     {"euro", 0x20AC},  {"gt", '>'},       {"hellip", 0x2026},
+    {"laquo", 0xAB},   {"ldquo", 0x201C}, {"lsaquo", 0x2039}, {"lsquo", 0x2018}, {"lt", '<'},
+    {"mdash", 0x2014}, {"middot", 0xB7},  {"nbsp", 0xA0},    {"ndash", 0x2013}, {"pound", 0xA3},
+    {"quot", '"'},     {"raquo", 0xBB},   {"rdquo", 0x201D}, {"reg", 0xAE},     {"rsaquo", 0x203A},
+    {"rsquo", 0x2019}, {"sbquo", 0x201A}, {"times", 0xD7},   {"trade", 0x2122}, {"yen", 0xA5},
+};
+
+constexpr size_t kMaxEntityLength = 10;
+
+bool IsHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+int HexValue(char c) {
+    if (c <= '9') {
+        return c - '0';
+    }
+    return (c | 0x20) - 'a' + 10;
+}
+
+bool IsValidCodePoint(char32_t code_point) {
+    return code_point <= 0x10FFFF && (code_point < 0xD800 || code_point > 0xDFFF);
+}
+
+// Decodes the entity starting at text[0] == '&'; returns the number of bytes it
+// spans, or 0 when it is not a recognized entity and the '&' is literal
+size_t DecodeEntity(std::string_view text, char32_t& code_point) {
+    const auto semicolon = text.substr(0, kMaxEntityLength + 2).find(';');
+    if (semicolon == std::string_view::npos || semicolon < 2) {
+        return 0;
+    }
+    const auto body = text.substr(1, semicolon - 1);
+
+    if (body[0] == '#') {
+        const bool hex = body.size() > 1 && (body[1] == 'x' || body[1] == 'X');
+        const auto digits = body.substr(hex ? 2 : 1);
+        if (digits.empty() || digits.size() > 7) {
+            return 0;
+        }
+        uint32_t value = 0;
+        for (const char c : digits) {
+            if (hex ? !IsHexDigit(c) : (c < '0' || c > '9')) {
+                return 0;
+            }
+            value = value * (hex ? 16 : 10) + (hex ? HexValue(c) : c - '0');
+        }
+        code_point = value != 0 && IsValidCodePoint(value) ? value : kReplacement;
+        return semicolon + 1;
+    }
+
+    const auto found = std::lower_bound(std::begin(kNamedEntities), std::end(kNamedEntities), body,
+                                        [](const NamedEntity& entity, std::string_view name) {
+                                            return entity.name < name;
+                                        });
+    if (found == std::end(kNamedEntities) || found->name != body) {
+        return 0;
+    }
+    code_point = found->code_point;
+    return semicolon + 1;
+}
+
+// Decodes one UTF-8 sequence; returns its length, or 0 when it is malformed,
+// overlong or a surrogate
+size_t DecodeUtf8(std::string_view text, char32_t& code_point) {
+    const auto lead = static_cast<unsigned char>(text[0]);
+    size_t length = 0;
+    char32_t min_value = 0;
+    if (lead < 0x80) {
+        code_point = lead;
+        return 1;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        min_value = 0x80;
+        code_point = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        min_value = 0x800;
+        code_point = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        min_value = 0x10000;
+        code_point = lead & 0x07;
+    } else {
+        return 0;
+    }
+    if (text.size() < length) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        const auto byte = static_cast<unsigned char>(text[i]);
+        if ((byte & 0xC0) != 0x80) {
+            return 0;
+        }
+        code_point = (code_point << 6) | (byte & 0x3F);
+    }
+    if (code_point < min_value || !IsValidCodePoint(code_point)) {
+        return 0;
+    }
+    return length;
+}
+
+void AppendUtf8(std::string& out, char32_t code_point) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        out += static_cast<char>(0xC0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        out += static_cast<char>(0xE0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+bool IsUnicodeSpace(char32_t code_point) {
+    return code_point == 0xA0 || (code_point >= 0x2000 && code_point <= 0x200A) || code_point == 0x2028 ||
+           code_point == 0x2029 || code_point == 0x202F || code_point == 0x205F || code_point == 0x3000;
+}
+
+bool IsDropped(char32_t code_point) {
+    // C0 controls other than tab and line breaks, DEL, C1 controls, zero-width
+    // characters and the byte order mark
+    return (code_point < 0x20 && code_point != '\t' && code_point != '\n' && code_point != '\r') ||
+           (code_point >= 0x7F && code_point <= 0x9F) || (code_point >= 0x200B && code_point <= 0x200D) ||
+           code_point == 0x2060 || code_point == 0xFEFF;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+std::string Normalize(std::string_view text, bool single_line) {
+    std::string out;
+    out.reserve(text.size());
+    bool pending_space = false;
+
+    size_t i = 0;
+    while (i < text.size()) {
+        char32_t code_point = 0;
+        size_t length = 0;
+        if (text[i] == '&') {
+            length = DecodeEntity(text.substr(i), code_point);
+        }
+        if (length == 0) {
+            length = DecodeUtf8(text.substr(i), code_point);
+            if (length == 0) {
+                code_point = kReplacement;
+                length = 1;
+            }
+        }
+        i += length;
+
+        if (IsDropped(code_point)) {
+            continue;
+        }
+        if (IsUnicodeSpace(code_point)) {
+            code_point = ' ';
+        }
+        if (single_line && code_point < 0x80 && IsSpace(static_cast<char>(code_point))) {
+            pending_space = !out.empty();
+            continue;
+        }
+        if (pending_space) {
+            out += ' ';
+            pending_space = false;
+        }
+        AppendUtf8(out, code_point);
+    }
+
+    while (!out.empty() && IsSpace(out.back())) {
+        out.pop_back();
+    }
+    const auto first = std::find_if(out.begin(), out.end(), [](char c) { return !IsSpace(c); });
+    out.erase(out.begin(), first);
+    return out;
+}
+
+}  // namespace
+
+std::string NormalizeText(std::string_view text) {
+    return Normalize(text, false);
+}
+
+std::string NormalizeLine(std::string_view text) {
+    return Normalize(text, true);
+}
+
+void NormalizeNewsItem(NewsItem& item) {
+    item.title = NormalizeLine(item.title);
+    item.content = NormalizeText(item.content);
+    item.source = NormalizeLine(item.source);
+    item.category = NormalizeLine(item.category);
+}
+
+}  // namespace news_aggregator::storage
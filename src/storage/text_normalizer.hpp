@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+// Clean text as it is stored: HTML entities decoded (named and numeric, in one
+// pass, so "&amp;lt;" stays "&lt;"), invalid UTF-8 replaced with U+FFFD,
+// control and zero-width characters dropped, Unicode spaces turned into ' ',
+// and the ends trimmed. Line breaks are kept.
+std::string NormalizeText(std::string_view text);
+
+// NormalizeText with every whitespace run collapsed into one space, for
+// single-line fields
+std::string NormalizeLine(std::string_view text);
+
+// Normalizes every free-text field of an incoming item in place
+void NormalizeNewsItem(NewsItem& item);
+
+}  // namespace news_aggregator::storage
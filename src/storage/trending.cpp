@@ -0,0 +1,215 @@
+#include "trending.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include "search_index.hpp"
+
+namespace news_aggregator::storage {
+
+namespace {
+
+// Shorter terms (one Cyrillic letter, "a", "of") carry no topic
+constexpr size_t kMinTermBytes = 3;
+
+const std::unordered_set<std::string>& StopWords() {
+    static const std::unordered_set<std::string> words = {
+        "the", "and", "for", "with", "from", "that", "this", "are", "was", "were", "has", "have", "had", "not",
+        "but", "its", "his", "her", "their", "they", "will", "would", "can", "could", "after", "over", "into",
+        "about", "more", "new", "says", "said", "what", "who", "how", "why", "when", "you", "your", "out",
+        "как", "что", "это", "для", "или", "при", "его", "она", "они", "все", "был", "была", "были", "будет",
+        "после", "также", "уже", "еще", "ещё", "так", "только", "может", "над", "под", "без", "про", "чем",
+    };
+    return words;
+}
+
+bool IsNumber(const std::string& term) {
+    return std::all_of(term.begin(), term.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+uint64_t Mix(uint64_t value) {
+    // splitmix64 finalizer
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+uint64_t HashTerm(const std::string& term) {
+    return Mix(std::hash<std::string>{}(term));
+}
+
+}  // namespace
+
+CountMinSketch::CountMinSketch(size_t width, size_t depth)
+    : width_(std::max<size_t>(1, width)), depth_(std::max<size_t>(1, depth)), counters_(width_ * depth_, 0) {
+}
+
+void CountMinSketch::Add(uint64_t hash, uint32_t count) {
+    for (size_t row = 0; row < depth_; ++row) {
+        counters_[row * width_ + Mix(hash + row) % width_] += count;
+    }
+}
+
+uint32_t CountMinSketch::Estimate(uint64_t hash) const {
+    uint32_t estimate = UINT32_MAX;
+    for (size_t row = 0; row < depth_; ++row) {
+        estimate = std::min(estimate, counters_[row * width_ + Mix(hash + row) % width_]);
+    }
+    return estimate;
+}
+
+void CountMinSketch::Clear() {
+    std::fill(counters_.begin(), counters_.end(), 0);
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {
+    entries_.reserve(capacity_);
+    positions_.reserve(capacity_);
+}
+
+void SpaceSaving::Add(const std::string& term, uint64_t source_bit) {
+    const auto it = positions_.find(term);
+    if (it != positions_.end()) {
+        auto& entry = entries_[it->second];
+        ++entry.count;
+        entry.sources |= source_bit;
+        return;
+    }
+    if (entries_.size() < capacity_) {
+        positions_.emplace(term, entries_.size());
+        entries_.push_back(Entry{term, 1, source_bit});
+        return;
+    }
+    
+    // The capacity is small, so a scan for the minimum is cheaper than
+    // keeping a second ordered structure up to date
+    const auto minimum = std::min_element(entries_.begin(), entries_.end(),
+                                          [](const Entry& lhs, const Entry& rhs) { return lhs.count < rhs.count; });
+    positions_.erase(minimum->term);
+    positions_.emplace(term, minimum - entries_.begin());
+    minimum->term = term;
+    minimum->count += 1;
+    minimum->sources = source_bit;
+}
+
+void SpaceSaving::Clear() {
+    entries_.clear();
+    positions_.clear();
+}
+
+TrendingTracker::TrendingTracker(const TrendingConfig& config) : config_(config) {
+    const size_t slots = std::max<size_t>(1, config_.window_slices + config_.baseline_slices);
+    slices_.reserve(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        slices_.push_back(Slice{-1, CountMinSketch(config_.sketch_width, config_.sketch_depth),
+                                SpaceSaving(config_.top_k)});
+    }
+}
+
+int64_t TrendingTracker::SliceIndex(std::chrono::system_clock::time_point time) const {
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    return seconds / std::max<int64_t>(1, config_.slice.count());
+}
+
+TrendingTracker::Slice* TrendingTracker::GetSlice(int64_t index) {
+    if (index < 0) {
+        return nullptr;
+    }
+    auto& slice = slices_[static_cast<size_t>(index) % slices_.size()];
+    if (slice.index > index) {
+        return nullptr;
+    }
+    if (slice.index < index) {
+        slice.index = index;
+        slice.sketch.Clear();
+        slice.heavy_hitters.Clear();
+    }
+    return &slice;
+}
+
+std::chrono::seconds TrendingTracker::GetSpan() const {
+    return config_.slice * static_cast<int64_t>(slices_.size());
+}
+
+void TrendingTracker::Record(const std::string& title, const std::string& source,
+                             std::chrono::system_clock::time_point time) {
+    auto terms = Tokenize(title);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    const uint64_t source_bit = 1ULL << (HashTerm(source) % 64);
+    
+    std::lock_guard<engine::Mutex> lock(mutex_);
+    auto* slice = GetSlice(SliceIndex(time));
+    if (!slice) {
+        return;
+    }
+    for (const auto& term : terms) {
+        if (term.size() < kMinTermBytes || IsNumber(term) || StopWords().count(term)) {
+            continue;
+        }
+        slice->sketch.Add(HashTerm(term));
+        slice->heavy_hitters.Add(term, source_bit);
+    }
+}
+
+std::vector<TrendingTerm> TrendingTracker::GetTrending(size_t limit, std::chrono::system_clock::time_point now) const {
+    const int64_t current = SliceIndex(now);
+    const auto window = static_cast<int64_t>(std::max<size_t>(1, config_.window_slices));
+    auto in_window = [&](int64_t index) { return index > current - window && index <= current; };
+    auto in_baseline = [&](int64_t index) {
+        return index <= current - window && index > current - static_cast<int64_t>(slices_.size());
+    };
+    
+    std::lock_guard<engine::Mutex> lock(mutex_);
+    
+    // Heavy hitters of any recent slice are the candidates
+    std::unordered_map<std::string, uint64_t> candidates;
+    size_t baseline_slices = 0;
+    for (const auto& slice : slices_) {
+        if (in_window(slice.index)) {
+            for (const auto& entry : slice.heavy_hitters.GetEntries()) {
+                candidates[entry.term] |= entry.sources;
+            }
+        } else if (in_baseline(slice.index)) {
+            ++baseline_slices;
+        }
+    }
+    
+    std::vector<TrendingTerm> trending;
+    for (const auto& [term, sources] : candidates) {
+        const uint64_t hash = HashTerm(term);
+        uint64_t count = 0;
+        uint64_t baseline = 0;
+        for (const auto& slice : slices_) {
+            if (in_window(slice.index)) {
+                count += slice.sketch.Estimate(hash);
+            } else if (in_baseline(slice.index)) {
+                baseline += slice.sketch.Estimate(hash);
+            }
+        }
+        if (count < config_.min_count) {
+            continue;
+        }
+        
+        // Without history yet every term is compared to zero, which ranks by volume
+        const double expected =
+            baseline_slices == 0 ? 0.0 : static_cast<double>(baseline) * window / static_cast<double>(baseline_slices);
+        const double score = (count - expected) / std::sqrt(expected + 1);
+        if (score <= 0) {
+            continue;
+        }
+        trending.push_back(TrendingTerm{term, count, expected, score, __builtin_popcountll(sources)});
+    }
+    
+    std::sort(trending.begin(), trending.end(), [](const TrendingTerm& lhs, const TrendingTerm& rhs) {
+        return lhs.score != rhs.score ? lhs.score > rhs.score : lhs.term < rhs.term;
+    });
+    if (trending.size() > limit) {
+        trending.resize(limit);
+    }
+    return trending;
+}
+
+}  // namespace news_aggregator::storage
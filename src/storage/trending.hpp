@@ -0,0 +1,99 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace news_aggregator::storage {
+
+struct TrendingConfig {
+    std::chrono::seconds slice{300};
+    size_t window_slices = 12;     // recent slices that are ranked
+    size_t baseline_slices = 72;   // slices before the window they are compared to
+    size_t sketch_width = 4096;
+    size_t sketch_depth = 4;
+    size_t top_k = 200;            // heavy hitters tracked per slice
+    uint64_t min_count = 3;        // fewer mentions in the window never trend
+};
+
+struct TrendingTerm {
+    std::string term;
+    uint64_t count = 0;      // mentions in the window (Count-Min estimate)
+    double expected = 0;     // mentions the baseline rate predicts for the window
+    double score = 0;
+    int sources = 0;         // distinct sources mentioning it, approximate
+};
+
+// Count-Min Sketch: frequency estimates that never undercount, in fixed memory
+class CountMinSketch {
+public:
+    CountMinSketch(size_t width, size_t depth);
+
+    void Add(uint64_t hash, uint32_t count = 1);
+    uint32_t Estimate(uint64_t hash) const;
+    void Clear();
+
+private:
+    size_t width_;
+    size_t depth_;
+    std::vector<uint32_t> counters_;  // depth_ rows of width_
+};
+
+// Space-Saving heavy hitters: the `capacity` most frequent terms of a stream.
+// An unseen term replaces the current minimum and inherits its count.
+class SpaceSaving {
+public:
+    struct Entry {
+        std::string term;
+        uint64_t count = 0;
+        uint64_t sources = 0;  // one bit per source hash
+    };
+
+    explicit SpaceSaving(size_t capacity);
+
+    void Add(const std::string& term, uint64_t source_bit);
+    const std::vector<Entry>& GetEntries() const { return entries_; }
+    void Clear();
+
+private:
+    size_t capacity_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, size_t> positions_;
+};
+
+// Terms of news titles whose mention rate in the recent window surges above the
+// rate of the preceding baseline. Memory is fixed by the config: one sketch and
+// one heavy-hitter table per time slice, reused as the slices rotate.
+class TrendingTracker {
+public:
+    explicit TrendingTracker(const TrendingConfig& config);
+
+    void Record(const std::string& title, const std::string& source, std::chrono::system_clock::time_point time);
+
+    std::vector<TrendingTerm> GetTrending(size_t limit, std::chrono::system_clock::time_point now) const;
+
+    // Rows created within this span before now feed a full window and baseline
+    std::chrono::seconds GetSpan() const;
+
+private:
+    struct Slice {
+        int64_t index = -1;  // time / slice length, -1 while unused
+        CountMinSketch sketch;
+        SpaceSaving heavy_hitters;
+    };
+
+    int64_t SliceIndex(std::chrono::system_clock::time_point time) const;
+    // Slice for `index`, recycling the slot of an expired one; nullptr when
+    // `index` has already rotated out
+    Slice* GetSlice(int64_t index);
+
+    const TrendingConfig config_;
+    mutable engine::Mutex mutex_;
+    std::vector<Slice> slices_;
+};
+
+}  // namespace news_aggregator::storage
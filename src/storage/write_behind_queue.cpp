@@ -0,0 +1,138 @@
+#include "write_behind_queue.hpp"
+
+#include <userver/engine/async.hpp>
+#include <userver/logging/log.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace news_aggregator::storage {
+
+WriteBehindQueue::WriteBehindQueue(WriteBehindConfig config, engine::TaskProcessor& task_processor,
+                                   Flusher flusher)
+    : config_(config), task_processor_(task_processor), flusher_(std::move(flusher)) {
+}
+
+WriteBehindQueue::~WriteBehindQueue() {
+    Stop();
+}
+
+void WriteBehindQueue::Start() {
+    LOG_INFO() << "Starting write-behind flusher, batch size " << config_.batch_size
+               << ", flush interval " << config_.flush_interval.count() << "ms";
+    flush_task_ = engine::AsyncNoSpan(task_processor_, [this]() { FlushLoop(); });
+}
+
+void WriteBehindQueue::Stop() {
+    {
+        std::lock_guard<engine::Mutex> lock(mutex_);
+        should_stop_ = true;
+    }
+    cv_.NotifyAll();
+
+    if (flush_task_.IsValid()) {
+        flush_task_.Wait();
+    }
+}
+
+std::optional<std::vector<WriteBehindQueue::Ticket>> WriteBehindQueue::Enqueue(std::vector<NewsItem> items) {
+    std::vector<Ticket> tickets;
+    tickets.reserve(items.size());
+    size_t depth = 0;
+    {
+        std::lock_guard<engine::Mutex> lock(mutex_);
+        if (should_stop_ || (!queue_.empty() && queue_.size() + items.size() > config_.max_queue_size)) {
+            rejected_ += items.size();
+            return std::nullopt;
+        }
+
+        for (auto& item : items) {
+            Pending pending{next_sequence_++, std::move(item), std::nullopt};
+            Ticket ticket{pending.sequence, std::nullopt};
+            if (config_.ack_mode == AckMode::kAfterCommit) {
+                pending.promise.emplace();
+                ticket.result = pending.promise->get_future();
+            }
+            queue_.push_back(std::move(pending));
+            tickets.push_back(std::move(ticket));
+        }
+        depth = queue_.size();
+        queue_depth_ = depth;
+    }
+    enqueued_ += tickets.size();
+
+    // The flusher only needs waking for the first items of a group and for a full group
+    if (depth == tickets.size() || depth >= config_.batch_size) {
+        cv_.NotifyOne();
+    }
+    return tickets;
+}
+
+WriteBehindStats WriteBehindQueue::GetStats() const {
+    WriteBehindStats stats;
+    stats.queue_depth = queue_depth_.load();
+    stats.enqueued = enqueued_.load();
+    stats.rejected = rejected_.load();
+    stats.committed = committed_.load();
+    stats.failed = failed_.load();
+    stats.batches = batches_.load();
+    stats.last_batch_size = last_batch_size_.load();
+    return stats;
+}
+
+void WriteBehindQueue::FlushLoop() {
+    while (true) {
+        std::vector<Pending> batch;
+        {
+            std::unique_lock<engine::Mutex> lock(mutex_);
+            if (!cv_.Wait(lock, [this] { return should_stop_ || !queue_.empty(); })) {
+                LOG_WARNING() << "Write-behind flusher cancelled with " << queue_.size() << " queued items";
+                break;
+            }
+            if (queue_.empty()) {
+                break;  // stopping and fully drained
+            }
+
+            // Give the group a chance to fill up before committing it
+            [[maybe_unused]] const bool filled = cv_.WaitFor(lock, config_.flush_interval, [this] {
+                return should_stop_ || queue_.size() >= config_.batch_size;
+            });
+
+            const size_t count = std::min(queue_.size(), config_.batch_size);
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            queue_depth_ = queue_.size();
+        }
+
+        std::vector<NewsItem> items;
+        items.reserve(batch.size());
+        for (auto& pending : batch) {
+            items.push_back(std::move(pending.item));
+        }
+
+        std::vector<AddNewsResult> results;
+        try {
+            results = flusher_(items);
+        } catch (const std::exception& ex) {
+            LOG_ERROR() << "Write-behind flush of " << items.size() << " items failed: " << ex.what();
+        }
+        results.resize(items.size());  // missing results stay failed (id == -1)
+
+        ++batches_;
+        last_batch_size_ = batch.size();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!results[i].inserted && !results[i].duplicate) {
+                ++failed_;
+            } else {
+                ++committed_;
+            }
+            if (batch[i].promise) {
+                batch[i].promise->set_value(results[i]);
+            }
+        }
+    }
+}
+
+}  // namespace news_aggregator::storage
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/future.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/utest/using_namespace_userver.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "postgres_client.hpp"
+
+namespace news_aggregator::storage {
+
+enum class AckMode {
+    kAfterCommit,   // respond once the item's group transaction has committed
+    kAfterEnqueue,  // respond as soon as the item is queued (may be lost on crash)
+};
+
+struct WriteBehindConfig {
+    size_t max_queue_size = 10000;
+    size_t batch_size = 100;                     // flush when this many items are queued...
+    std::chrono::milliseconds flush_interval{10};  // ...or when the oldest waited this long
+    AckMode ack_mode = AckMode::kAfterCommit;
+};
+
+struct WriteBehindStats {
+    size_t queue_depth = 0;
+    uint64_t enqueued = 0;
+    uint64_t rejected = 0;
+    uint64_t committed = 0;
+    uint64_t failed = 0;
+    uint64_t batches = 0;
+    size_t last_batch_size = 0;
+};
+
+// Bounded in-process queue of validated news items. A single background task
+// drains it and hands each group to the flusher, which commits it in one
+// transaction, so one fsync is shared by the whole group. The flusher blocks
+// on libpq, so the task runs on the task processor given for blocking work.
+class WriteBehindQueue {
+public:
+    using Flusher = std::function<std::vector<AddNewsResult>(const std::vector<NewsItem>&)>;
+
+    struct Ticket {
+        uint64_t sequence;
+        // Only valid with AckMode::kAfterCommit
+        std::optional<engine::Future<AddNewsResult>> result;
+    };
+
+    WriteBehindQueue(WriteBehindConfig config, engine::TaskProcessor& task_processor, Flusher flusher);
+    ~WriteBehindQueue();
+
+    void Start();
+    // Flushes everything still queued and stops the background task
+    void Stop();
+
+    // Queues every item or none of them, so a rejected request can be retried
+    // as a whole. Returns std::nullopt when they do not fit; a request larger
+    // than the whole queue is only taken into an empty queue.
+    std::optional<std::vector<Ticket>> Enqueue(std::vector<NewsItem> items);
+
+    const WriteBehindConfig& GetConfig() const { return config_; }
+    WriteBehindStats GetStats() const;
+
+private:
+    struct Pending {
+        uint64_t sequence;
+        NewsItem item;
+        std::optional<engine::Promise<AddNewsResult>> promise;
+    };
+
+    void FlushLoop();
+
+    const WriteBehindConfig config_;
+    engine::TaskProcessor& task_processor_;
+    const Flusher flusher_;
+
+    engine::Mutex mutex_;
+    engine::ConditionVariable cv_;
+    std::deque<Pending> queue_;
+    uint64_t next_sequence_{1};
+    bool should_stop_{false};
+    engine::TaskWithResult<void> flush_task_;
+
+    std::atomic<size_t> queue_depth_{0};
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> committed_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<size_t> last_batch_size_{0};
+};
+
+}  // namespace news_aggregator::storage
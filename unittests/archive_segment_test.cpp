@@ -0,0 +1,258 @@
+#include <userver/utest/utest.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/storage/archive_segment.hpp"
+
+namespace {
+
+using namespace news_aggregator;
+
+constexpr int kRows = 1000;  // several blocks, the last one partial
+constexpr int64_t kFirstCreatedUs = 1704067200000000;  // 2024-01-01
+constexpr int64_t kStepUs = 60000000;
+
+storage::NewsItem MakeRow(int i) {
+  storage::NewsItem item{};
+  // Two rows per timestamp, so the id breaks ties
+  item.id = 10000 + i;
+  item.created_at_us = kFirstCreatedUs + (i / 2) * kStepUs;
+  item.title = "Title " + std::to_string(i);
+  item.content = "Body of story " + std::to_string(i) + std::string(i % 50, 'x');
+  item.snippet = "Snippet " + std::to_string(i);
+  item.source = i % 3 == 0 ? "Reuters" : "TechCrunch";
+  item.category = i % 4 == 0 ? "business" : "technology";
+  item.published_at = "2024-01-01T00:00:00+00:00";
+  item.url = "https://example.com/" + std::to_string(i);
+  return item;
+}
+
+class TempDirectory {
+ public:
+  TempDirectory()
+      : path_(std::filesystem::temp_directory_path() /
+              ("archive_segment_test_" + std::to_string(getpid()) + "_" + std::to_string(counter_++))) {
+    std::filesystem::create_directories(path_);
+  }
+  ~TempDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+  }
+
+  std::string File(const std::string& name) const { return (path_ / name).string(); }
+
+ private:
+  static inline int counter_ = 0;
+  std::filesystem::path path_;
+};
+
+std::string WriteSegment(const TempDirectory& directory, int rows) {
+  const auto path = directory.File("segment.seg");
+  storage::SegmentWriter writer(path);
+  for (int i = 0; i < rows; ++i) {
+    EXPECT_TRUE(writer.Add(MakeRow(i)));
+  }
+  EXPECT_TRUE(writer.Finish());
+  EXPECT_EQ(writer.GetRowCount(), static_cast<size_t>(rows));
+  return path;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& data) {
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+}
+
+// Expected result of `query` over MakeRow(0..kRows), newest first
+std::vector<int> ExpectedIds(const storage::ArchiveQuery& query) {
+  std::vector<int> ids;
+  for (int i = kRows - 1; i >= 0 && static_cast<int>(ids.size()) < query.limit; --i) {
+    const auto row = MakeRow(i);
+    if (row.created_at_us < query.from_us || row.created_at_us >= query.to_us) {
+      continue;
+    }
+    if (query.before && (row.created_at_us > query.before->created_at_us ||
+                         (row.created_at_us == query.before->created_at_us && row.id >= query.before->id))) {
+      continue;
+    }
+    if ((!query.category.empty() && row.category != query.category) ||
+        (!query.source.empty() && row.source != query.source)) {
+      continue;
+    }
+    ids.push_back(row.id);
+  }
+  return ids;
+}
+
+std::vector<int> ScanIds(const storage::SegmentReader& reader, const storage::ArchiveQuery& query) {
+  std::vector<storage::NewsItem> items;
+  EXPECT_TRUE(reader.Scan(query, items));
+  std::vector<int> ids;
+  for (const auto& item : items) {
+    ids.push_back(item.id);
+  }
+  return ids;
+}
+
+// Opening and scanning a damaged file must fail cleanly, never crash
+bool OpensAndScans(const std::string& path) {
+  const auto reader = storage::SegmentReader::Open(path);
+  if (!reader) {
+    return false;
+  }
+  storage::ArchiveQuery query;
+  query.limit = kRows;
+  query.with_content = true;
+  std::vector<storage::NewsItem> items;
+  return reader->Scan(query, items);
+}
+
+}  // namespace
+
+UTEST(ArchiveSegment, RoundTrip) {
+  TempDirectory directory;
+  const auto path = WriteSegment(directory, kRows);
+  EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  const auto reader = storage::SegmentReader::Open(path);
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(reader->GetRowCount(), static_cast<size_t>(kRows));
+  EXPECT_EQ(reader->GetMinCreatedUs(), MakeRow(0).created_at_us);
+  EXPECT_EQ(reader->GetMaxCreatedUs(), MakeRow(kRows - 1).created_at_us);
+
+  storage::ArchiveQuery query;
+  query.limit = kRows;
+  query.with_content = true;
+  std::vector<storage::NewsItem> items;
+  ASSERT_TRUE(reader->Scan(query, items));
+  ASSERT_EQ(items.size(), static_cast<size_t>(kRows));
+  for (int i = 0; i < kRows; ++i) {
+    const auto expected = MakeRow(kRows - 1 - i);
+    const auto& item = items[i];
+    EXPECT_EQ(item.id, expected.id);
+    EXPECT_EQ(item.created_at_us, expected.created_at_us);
+    EXPECT_EQ(item.title, expected.title);
+    EXPECT_EQ(item.content, expected.content);
+    EXPECT_EQ(item.snippet, expected.snippet);
+    EXPECT_EQ(item.source, expected.source);
+    EXPECT_EQ(item.category, expected.category);
+    EXPECT_EQ(item.published_at, expected.published_at);
+    EXPECT_EQ(item.url, expected.url);
+  }
+
+  // Summaries leave the body compressed
+  query.with_content = false;
+  query.limit = 5;
+  items.clear();
+  ASSERT_TRUE(reader->Scan(query, items));
+  ASSERT_EQ(items.size(), 5u);
+  EXPECT_TRUE(items.front().content.empty());
+  EXPECT_EQ(items.front().title, MakeRow(kRows - 1).title);
+}
+
+UTEST(ArchiveSegment, Filters) {
+  TempDirectory directory;
+  const auto reader = storage::SegmentReader::Open(WriteSegment(directory, kRows));
+  ASSERT_TRUE(reader);
+
+  storage::ArchiveQuery query;
+  query.limit = kRows;
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+
+  // from/to across a block boundary
+  query.from_us = MakeRow(200).created_at_us;
+  query.to_us = MakeRow(700).created_at_us;
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+  EXPECT_EQ(ScanIds(*reader, query).size(), 500u);
+
+  // Cursor in the middle of a timestamp shared by two rows
+  query = {};
+  query.limit = 20;
+  query.before = storage::CursorOf(MakeRow(601));
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+  EXPECT_EQ(ScanIds(*reader, query).front(), MakeRow(600).id);
+
+  query = {};
+  query.limit = kRows;
+  query.category = "business";
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+  query.source = "Reuters";
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+  EXPECT_EQ(ScanIds(*reader, query).size(), static_cast<size_t>((kRows + 11) / 12));
+
+  // Everything combined, paged by the cursor of the previous page
+  query.from_us = MakeRow(100).created_at_us;
+  query.to_us = MakeRow(900).created_at_us;
+  query.limit = 7;
+  std::vector<storage::NewsItem> page;
+  ASSERT_TRUE(reader->Scan(query, page));
+  EXPECT_EQ(page.size(), 7u);
+  query.before = storage::CursorOf(page.back());
+  EXPECT_EQ(ScanIds(*reader, query), ExpectedIds(query));
+
+  query = {};
+  query.category = "sports";
+  EXPECT_TRUE(ScanIds(*reader, query).empty());
+}
+
+UTEST(ArchiveSegment, Truncated) {
+  TempDirectory directory;
+  const auto data = ReadFile(WriteSegment(directory, kRows));
+  const auto path = directory.File("truncated.seg");
+  for (const size_t size : {size_t{0}, size_t{8}, size_t{27}, data.size() / 2, data.size() - 20, data.size() - 1}) {
+    WriteFile(path, data.substr(0, size));
+    EXPECT_FALSE(storage::SegmentReader::Open(path)) << "size " << size;
+  }
+}
+
+UTEST(ArchiveSegment, BitFlips) {
+  TempDirectory directory;
+  const auto data = ReadFile(WriteSegment(directory, 300));
+  const auto path = directory.File("flipped.seg");
+
+  // Every byte of the header, the footer and the trailer, and a spread of
+  // the blocks: a flip either goes unnoticed or fails the open or scan
+  const size_t footer_offset = [&data] {
+    uint64_t offset = 0;
+    for (size_t i = 0; i < 8; ++i) {
+      offset |= static_cast<uint64_t>(static_cast<uint8_t>(data[data.size() - 20 + i])) << (8 * i);
+    }
+    return static_cast<size_t>(offset);
+  }();
+  ASSERT_LT(footer_offset, data.size());
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < data.size(); i += (i < 8 || i >= footer_offset) ? 1 : 7) {
+    positions.push_back(i);
+  }
+
+  for (const size_t position : positions) {
+    for (const int bit : {0, 7}) {
+      auto flipped = data;
+      flipped[position] = static_cast<char>(flipped[position] ^ (1 << bit));
+      WriteFile(path, flipped);
+      OpensAndScans(path);
+    }
+  }
+
+  // Damage to the magic or the trailer is always detected
+  for (const size_t position : {size_t{0}, data.size() - 1, data.size() - 20, data.size() - 12}) {
+    auto flipped = data;
+    flipped[position] = static_cast<char>(flipped[position] ^ 0x01);
+    WriteFile(path, flipped);
+    EXPECT_FALSE(storage::SegmentReader::Open(path)) << "position " << position;
+  }
+}
+
+UTEST(ArchiveSegment, MissingFile) {
+  TempDirectory directory;
+  EXPECT_FALSE(storage::SegmentReader::Open(directory.File("missing.seg")));
+}
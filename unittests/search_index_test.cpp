@@ -0,0 +1,213 @@
+#include <userver/utest/utest.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/storage/search_index.hpp"
+
+namespace {
+
+using namespace news_aggregator;
+
+struct Intersection {
+  std::vector<uint32_t> a_positions;
+  std::vector<uint32_t> b_positions;
+};
+
+// Plain merge, the result every IntersectSorted path must agree with
+Intersection IntersectScalar(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  Intersection result;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      result.a_positions.push_back(static_cast<uint32_t>(i++));
+      result.b_positions.push_back(static_cast<uint32_t>(j++));
+    }
+  }
+  return result;
+}
+
+Intersection Intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  Intersection result;
+  result.a_positions.resize(std::min(a.size(), b.size()));
+  result.b_positions.resize(std::min(a.size(), b.size()));
+  const auto count = storage::IntersectSorted(a.data(), a.size(), b.data(), b.size(), result.a_positions.data(),
+                                              result.b_positions.data());
+  result.a_positions.resize(count);
+  result.b_positions.resize(count);
+  return result;
+}
+
+void ExpectSameIntersection(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  const auto expected = IntersectScalar(a, b);
+  const auto actual = Intersect(a, b);
+  EXPECT_EQ(actual.a_positions, expected.a_positions);
+  EXPECT_EQ(actual.b_positions, expected.b_positions);
+}
+
+std::vector<uint32_t> RandomSorted(std::mt19937& random, size_t size, uint32_t range) {
+  std::vector<uint32_t> values;
+  std::uniform_int_distribution<uint32_t> distribution(0, range);
+  while (values.size() < size) {
+    values.push_back(distribution(random));
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+  }
+  return values;
+}
+
+storage::NewsItem MakeDocument(int id, const std::string& title, const std::string& content,
+                               const std::string& category = "technology") {
+  storage::NewsItem item{};
+  item.id = id;
+  item.title = title;
+  item.content = content;
+  item.category = category;
+  item.source = "TechCrunch";
+  item.created_at_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  return item;
+}
+
+std::vector<int> Ids(const storage::SearchResult& result) {
+  std::vector<int> ids;
+  for (const auto& hit : result.hits) {
+    ids.push_back(hit.news_id);
+  }
+  return ids;
+}
+
+}  // namespace
+
+UTEST(SearchIndex, IntersectSortedEdgeCases) {
+  ExpectSameIntersection({}, {});
+  ExpectSameIntersection({1, 2, 3}, {});
+  ExpectSameIntersection({1, 2, 3, 4}, {1, 2, 3, 4});
+  // Partial 4-blocks on either side go through the scalar tail
+  ExpectSameIntersection({1, 2, 3, 4, 5, 6, 7}, {2, 4, 6});
+  ExpectSameIntersection({5}, {1, 2, 3, 4, 5, 6, 7, 8, 9});
+  // Equal maxima advance both sides at once
+  ExpectSameIntersection({1, 3, 5, 8, 9, 10, 11, 20}, {2, 4, 6, 8, 10, 12, 14, 20});
+  ExpectSameIntersection({0, 1, 2, 8}, {5, 6, 7, 8, 9});
+  // Every match in a rotated lane
+  ExpectSameIntersection({1, 2, 3, 4}, {2, 3, 4, 5});
+  ExpectSameIntersection({4, 5, 6, 7}, {1, 2, 3, 4, 5, 6, 7, 8});
+}
+
+UTEST(SearchIndex, IntersectSortedMatchesScalar) {
+  std::mt19937 random(42);
+  for (int round = 0; round < 2000; ++round) {
+    const auto a = RandomSorted(random, random() % 40, 64);
+    const auto b = RandomSorted(random, random() % 40, 64);
+    ExpectSameIntersection(a, b);
+  }
+  // Long, sparse lists like real postings
+  const auto a = RandomSorted(random, 1000, 100000);
+  const auto b = RandomSorted(random, 333, 100000);
+  ExpectSameIntersection(a, b);
+  ExpectSameIntersection(b, a);
+}
+
+UTEST(SearchIndex, TokenizeFoldsCase) {
+  EXPECT_EQ(storage::Tokenize("Hello, WORLD 2026!"), (std::vector<std::string>{"hello", "world", "2026"}));
+  // А-П and Р-Я fold from different lead bytes; Ё folds to е
+  EXPECT_EQ(storage::Tokenize("ПРИВЕТ Мир ЁЛКА ёж"),
+            (std::vector<std::string>{"привет", "мир", "елка", "еж"}));
+}
+
+UTEST(SearchIndex, TokenizeSkipsMarkup) {
+  EXPECT_EQ(storage::Tokenize("<p class=\"lead\">Rates</p><!-- note -->rise"),
+            (std::vector<std::string>{"rates", "rise"}));
+  // A lone '<' in plain text only separates
+  EXPECT_EQ(storage::Tokenize("a < b"), (std::vector<std::string>{"a", "b"}));
+  // An unterminated tag swallows the rest
+  EXPECT_EQ(storage::Tokenize("before <a href="), (std::vector<std::string>{"before"}));
+  // NBSP, guillemets and dashes separate terms
+  EXPECT_EQ(storage::Tokenize("one\xC2\xA0two \xC2\xABthree\xC2\xBB four\xE2\x80\x94" "five"),
+            (std::vector<std::string>{"one", "two", "three", "four", "five"}));
+}
+
+UTEST(SearchIndex, TokenizeTruncatedUtf8) {
+  // A sequence cut off at the end, and stray continuation bytes, separate terms
+  EXPECT_EQ(storage::Tokenize("abc\xD0"), (std::vector<std::string>{"abc"}));
+  EXPECT_EQ(storage::Tokenize("abc\xE2\x80"), (std::vector<std::string>{"abc"}));
+  EXPECT_EQ(storage::Tokenize("a\x80" "b"), (std::vector<std::string>{"a", "b"}));
+  // Terms longer than 64 bytes are dropped
+  EXPECT_EQ(storage::Tokenize(std::string(65, 'x') + " ok"), (std::vector<std::string>{"ok"}));
+}
+
+UTEST(SearchIndex, SearchRequiresEveryTerm) {
+  storage::SearchIndex index(storage::SearchRankingConfig{});
+  index.Add({
+      MakeDocument(1, "Apple and banana", "fruit market"),
+      MakeDocument(2, "Apple", "orchard"),
+      MakeDocument(3, "Banana", "plantation"),
+      MakeDocument(4, "Banana apple", "smoothie", "food"),
+  });
+  index.Flush();
+  EXPECT_EQ(index.GetDocumentCount(), 4u);
+
+  storage::SearchQuery query;
+  query.text = "APPLE banana";
+  auto result = index.Search(query);
+  EXPECT_EQ(result.total_matches, 2u);
+  auto ids = Ids(result);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids, (std::vector<int>{1, 4}));
+
+  query.category = "food";
+  EXPECT_EQ(Ids(index.Search(query)), (std::vector<int>{4}));
+
+  query.category.clear();
+  query.text = "apple cherry";
+  EXPECT_TRUE(index.Search(query).hits.empty());
+  query.text = "";
+  EXPECT_TRUE(index.Search(query).hits.empty());
+}
+
+UTEST(SearchIndex, SearchPagesByOffset) {
+  storage::SearchIndex index(storage::SearchRankingConfig{});
+  std::vector<storage::NewsItem> items;
+  for (int id = 1; id <= 40; ++id) {
+    // Repeating the term raises the score of some documents; the rest tie
+    std::string content = "rates";
+    for (int i = 0; i < id % 5; ++i) {
+      content += " rates";
+    }
+    items.push_back(MakeDocument(id, "Central bank", content + " story " + std::to_string(id)));
+  }
+  index.Add(items);
+  index.Flush();
+
+  storage::SearchQuery query;
+  query.text = "bank rates";
+  query.limit = 40;
+  const auto all = index.Search(query);
+  ASSERT_EQ(all.hits.size(), 40u);
+  EXPECT_EQ(all.total_matches, 40u);
+  for (size_t i = 1; i < all.hits.size(); ++i) {
+    EXPECT_GE(all.hits[i - 1].score, all.hits[i].score);
+  }
+
+  // Pages cut at any offset concatenate to the full ranking, ties included
+  std::vector<int> paged;
+  query.limit = 7;
+  for (query.offset = 0; query.offset < 40; query.offset += query.limit) {
+    const auto page = Ids(index.Search(query));
+    paged.insert(paged.end(), page.begin(), page.end());
+  }
+  EXPECT_EQ(paged, Ids(all));
+
+  query.offset = 40;
+  EXPECT_TRUE(index.Search(query).hits.empty());
+}